@@ -20,252 +20,27 @@
 #include <boost/python/stl_iterator.hpp>
 #include <boost/python/suite/indexing/vector_indexing_suite.hpp>
 
-#include <boost/tuple/tuple.hpp>
-#include <boost/filesystem.hpp>
 #include <boost/regex.hpp>
-#include <set>
 #include <string>
-#include <fstream>
-#include <sstream>
-
-#include <cstring>
-#include <cctype>
 
 #include <iostream>
 
 #include <texpp/parser.h>
+#include <texpy/array_view.h>
 
-extern "C" {
-struct stemmer;
-
-extern struct stemmer * create_stemmer(void);
-extern void free_stemmer(struct stemmer * z);
-
-extern int stem(struct stemmer * z, char * b, int k);
-}
+#include "literals.h"
+#include "pipeline.h"
 
 using namespace boost::python;
 using namespace texpp;
+using namespace hrefkeywords;
+using texpp::string;
 
-class Stemmer {
-public:
-    Stemmer() { _stemmer = create_stemmer(); }
-    ~Stemmer() { free_stemmer(_stemmer); }
-
-    string stem(string word) const
-    {
-        /* TODO: remove unnessesary conversion to/from std::string */
-        int n = word.size();
-        char buf[n];
-        std::memcpy(buf, word.data(), n);
-        n = ::stem(_stemmer, buf, n-1);
-        return string(buf, n+1);
-    }
-
-protected:
-    mutable struct stemmer* _stemmer;
-};
-
-class WordsDict {
-public:
-    WordsDict(string filename, size_t abbrMaxLen)
-        : _abbrMaxLen(abbrMaxLen)
-    {
-        std::ifstream wordsfile(filename.c_str());
-        string word;
-        while(wordsfile.good()) {
-            std::getline(wordsfile, word);
-            size_t s = word.size();
-            if(s > 1 && s <= abbrMaxLen &&
-                    (s < 2 || word.substr(s-2) != "'s") ) {
-                _words.insert(word);
-            }
-        }
-    }
-
-    size_t abbrMaxLen() const { return _abbrMaxLen; }
-
-    void insert(string word) { _words.insert(word); }
-    bool contains(string word) const { return _words.count(word); }
-
-protected:
-    std::set<string> _words;
-    size_t _abbrMaxLen;
-};
-
-inline bool _islower(char ch) { return ch >= 'a' && ch <= 'z'; }
-inline bool _isupper(char ch) { return ch >= 'A' && ch <= 'Z'; }
-
-inline bool _isglue(char ch) {
-    return isdigit(ch) || ch == '-' || ch == '/';
-}
-
-inline bool _isIgnored(char ch) {
-    return ch == ' ' || ch == '~' || ch == '-' || ch == '/';
-}
-
-inline bool _isIgnoredWord(const string& word) {
-    return word == "the" || word == "a" || word == "an" ||
-           word == "The" || word == "A" || word == "An";
-}
-
-string normLiteral(string literal,
+string normLiteralWrap(string literal,
         const WordsDict* wordsDict, const Stemmer* stemmer, const dict& whiteList)
 {
-    /* TODO: support arbitrary stemmers and wordDicts */
-    /* TODO: unicode and locales */
-    string nliteral;
-    size_t n = 0, s = literal.size();
-    size_t wordStart = string::npos;
-    size_t lastDot = string::npos;
-    string lowercaseLiteral(literal);
-    for(size_t i = 0; i < lowercaseLiteral.size(); ++i)
-        if(_isupper(lowercaseLiteral[i])) lowercaseLiteral[i] -= 'A'-'a';
-    if(whiteList.has_key(lowercaseLiteral)) return literal;
-
-    /* TODO: handle 's */
-    for(n=0; ; ++n) {
-        char ch = n < s ? literal[n] : 0;
-
-        if(wordStart < n) { // inside a word
-            if(_islower(ch) || _isupper(ch) || std::isdigit(ch)) {
-                // add to current word
-            } else if(ch == '.') {
-                // add to current word but remember the dot position
-                lastDot = n;
-            } else { // end of the word
-
-                // re-read current char next time
-                --n;
-                
-                // check for the dot
-                if(lastDot < n) {
-                    // dot is present but not the last char
-                    n = lastDot;
-                }
-
-                // extract and lower the word
-                bool isAbbr = false;
-                size_t lastUpper = string::npos;
-                size_t firstLower = string::npos;
-                size_t wordSize = n + 1 - wordStart;
-                std::string word(literal, wordStart, wordSize);
-                std::string word1(literal, wordStart, wordSize);
-
-                // reset the word
-                size_t pLastDot = lastDot;
-                wordStart = lastDot = string::npos;
-
-                for(size_t k = 0; k < wordSize; ++k) {
-                    if(_isupper(word1[k])) {
-                        word1[k] += ('a' - 'A');
-                        lastUpper = k;
-                        if(k != 0) isAbbr = true;
-                    } else if(_islower(word1[k])) {
-                        if(firstLower > k) firstLower = k;
-                    } else { // digit or dot
-                        isAbbr = true;
-                    }
-                }
-
-                if(n+1 < s && _isIgnoredWord(word)) {
-                    // Skip articles, but not at the end
-                    continue;
-                }
-
-                // check for abbr in dictionary
-                if(!isAbbr && wordSize <= wordsDict->abbrMaxLen()) {
-                    isAbbr = !wordsDict->contains(word);
-                    if(isAbbr && lastUpper == 0)
-                        isAbbr = !wordsDict->contains(word1);
-                }
-                
-                // process the word
-                if(isAbbr) {
-                    if(pLastDot > n) {
-                        // Stem plural forms for uppercase abbrevations
-                        if(wordSize > 2 && firstLower == wordSize-2 &&
-                                word[wordSize-2] == 'e' &&
-                                word[wordSize-1] == 's') {
-                            --wordSize; --wordSize;
-                            word.resize(wordSize);
-                        } else if(wordSize > 1 && firstLower == wordSize-1 &&
-                                word[wordSize-1] == 's') {
-                            word.resize(--wordSize);
-                        }
-                        size_t nliteralSize = nliteral.size();
-                        nliteral.resize(nliteralSize + 2*wordSize);
-                        for(size_t k=0; k<wordSize; ++k) {
-                            nliteral[nliteralSize + (k<<1)] =
-                                _islower(word[k]) ?
-                                    word[k] - ('a' - 'A') : word[k];
-                            nliteral[nliteralSize + (k<<1) + 1] = '.';
-                        }
-                    } else {
-                        size_t nliteralSize = nliteral.size();
-                        nliteral.resize(nliteralSize + wordSize);
-                        for(size_t k=0; k<wordSize; ++k) {
-                            nliteral[nliteralSize + k] =
-                                _islower(word[k]) ?
-                                    word[k] - ('a' - 'A') : word[k];
-                        }
-                    }
-                } else {
-                    nliteral += stemmer->stem(word1);
-                }
-            }
-        } else { // not inside a word
-            if(_isIgnored(ch)) {
-                continue; // ignore these chars
-            } else if(_islower(ch) || _isupper(ch) || std::isdigit(ch)) {
-                wordStart = n;
-            } else if(ch == '\'' && n+1 < s && (literal[n+1] == 's') &&
-                    n != 0 && (_islower(literal[n-1]) ||
-                               _isupper(literal[n-1]))) {
-                if(n+2==s) break;
-                char ch2 = literal[n+2];
-                if(_islower(ch2) || _isupper(ch2) || std::isdigit(ch2)
-                                                    || ch2 == '.')
-                    nliteral += literal[n];
-                else
-                    ++n;
-            } else if(n >= s) {
-                break;
-            } else {
-                nliteral += literal[n]; // use character as-is
-            }
-        }
-    }
-
-    return nliteral;
-}
-
-string absolutePath(const string& str, const string& workdir)
-{
-    using boost::filesystem::path;
-    path p = path(str);
-    if(!p.is_complete()) {
-        if(!workdir.empty()) {
-            path w = path(workdir);
-            if(!w.is_complete()) 
-                w = boost::filesystem::current_path() / w;
-            p = w / p;
-        } else {
-            p = boost::filesystem::current_path() / p;
-        }
-    }
-
-    string result = p.normalize().string(); 
-    if(result.size() > 2 && 0==result.compare(result.size()-2, 2, "/."))
-        result.resize(result.size()-2);
-    return result;
-}
-
-bool isLocalFile(const string& str, const string& workdir)
-{
-    string aWorkdir = absolutePath(workdir, string());
-    return absolutePath(str, aWorkdir)
-            .compare(0, aWorkdir.size(), aWorkdir) == 0;
+    if(whiteList.has_key(lowerLiteral(literal))) return literal;
+    return normLiteral(literal, wordsDict, stemmer);
 }
 
 #define __PYTHON_NEXT(obj, iter) \
@@ -276,78 +51,60 @@ bool isLocalFile(const string& str, const string& workdir)
         throw; \
     }
 
-struct TextTag
+struct TextTagPickeSuite: pickle_suite
 {
-    enum Type {
-        TT_OTHER = 0,
-        TT_WORD, TT_CHARACTER, TT_LITERAL
-    };
-
-    Type   type;
-    size_t start;
-    size_t end;
-    string value;
-
-    // XXX: boost::python does not support pickling of enums
-    explicit TextTag(int t = TT_OTHER, size_t s = 0, size_t e = 0,
-                            const string& val = string())
-        : type(Type(t)), start(s), end(e), value(val) {}
-
-    bool operator==(const TextTag& o) {
-        return o.type == type && o.start == start &&
-               o.end == end && o.value == value;
-    }
-
-    bool operator!=(const TextTag& o) {
-        return o.type != type || o.start != start ||
-               o.end != end || o.value != value;
-    }
-
-    string repr() const {
-        static const char* types[] = {
-            "OTHER", "WORD", "CHARACTER", "LITERAL"
-        };
-        std::ostringstream out;
-        out << "TextTag("
-            << (type <= TT_LITERAL && type >= 0 ? types[type] : "UNKNOWN")
-            << ", " << start << ", " << end << ", \"" << value << "\")";
-        return out.str();
+    static tuple getinitargs(const TextTag& tag) {
+        return make_tuple(int(tag.type), tag.start, tag.end, tag.value);
     }
 };
 
-typedef std::vector<TextTag> TextTagList;
-
-string textTagListRepr(const TextTagList& list)
+shared_ptr<WordsDict> WordsDict_create(const string& filename,
+                                      size_t abbrMaxLen)
 {
-    std::ostringstream out;
-    out << "TextTagList(";
-    TextTagList::const_iterator e = list.end();
-    for(TextTagList::const_iterator it = list.begin(); it != e; ++it) {
-        if(it != list.begin())
-            out << ", ";
-        out << it->repr();
+    shared_ptr<WordsDict> words(new WordsDict(filename, abbrMaxLen));
+    if(!words->error().empty()) {
+        PyErr_SetString(PyExc_ValueError, words->error().c_str());
+        throw_error_already_set();
     }
-    out << ")";
-    return out.str();
+    return words;
 }
 
-struct TextTagPickeSuite: pickle_suite
+object TextTagList_toBytes(const TextTagList& tags)
 {
-    static tuple getinitargs(const TextTag& tag) {
-        return make_tuple(int(tag.type), tag.start, tag.end, tag.value);
+    string data = encodeTextTags(tags);
+    return object(handle<>(PyBytes_FromStringAndSize(
+                        data.data(), Py_ssize_t(data.size()))));
+}
+
+// Accepts any object supporting the buffer protocol
+TextTagList TextTagList_fromBytes(const object& data)
+{
+    Py_buffer view;
+    if(PyObject_GetBuffer(data.ptr(), &view, PyBUF_SIMPLE) != 0)
+        throw_error_already_set();
+
+    TextTagList tags;
+    bool ok = decodeTextTags(static_cast<const char*>(view.buf),
+                             size_t(view.len), tags);
+    PyBuffer_Release(&view);
+    if(!ok) {
+        PyErr_SetString(PyExc_ValueError, "invalid TextTagList data");
+        throw_error_already_set();
     }
-};
+    return tags;
+}
 
 struct TextTagListPickeSuite: pickle_suite
 {
-    static list getstate(const TextTagList& l) {
-        list ret; TextTagList::const_iterator e = l.end();
-        for(TextTagList::const_iterator it = l.begin(); it != e; ++it) {
-            ret.append(make_tuple(int(it->type), it->start, it->end, it->value));
-        }
-        return ret;
+    static object getstate(const TextTagList& l) {
+        return TextTagList_toBytes(l);
     }
-    static void setstate(TextTagList& l, list state) {
+    static void setstate(TextTagList& l, object state) {
+        // Lists of tuples were written by earlier versions
+        if(!PyList_Check(state.ptr())) {
+            l = TextTagList_fromBytes(state);
+            return;
+        }
         l.resize(len(state));
         size_t n = 0;
         for(stl_input_iterator<tuple> it(state), e; it != e; ++it) {
@@ -360,85 +117,94 @@ struct TextTagListPickeSuite: pickle_suite
     }
 };
 
-void _extractTextInfo(dict& result, const Node::ptr node,
-        const boost::regex& exclude_regex,
-        const string& workdir = string())
+dict extractTextInfoWrap(const Node::ptr node, const string& exclude_regex,
+                const string& workdir = string())
 {
-    size_t childrenCount = node->childrenCount();
-
-    if(childrenCount == 0) {
-        return;
-    }
-
-    string aWorkdir = absolutePath(workdir, string());
-    shared_ptr<string> lastFile;
-    TextTagList* tags = 0;
-    for(size_t n = 0; n < childrenCount; ++n) {
-        Node::ptr child = node->child(n);
-
-        // check type
-        TextTag::Type type;
-        if(child->type() == "text_word") {
-            type = TextTag::TT_WORD;
-        } else if(child->type() == "text_character" ||
-                  child->type() == "text_space") {
-            type = TextTag::TT_CHARACTER;
-        } else {
-            type = TextTag::TT_OTHER;
-        }
+    TextTagsMap tags;
+    boost::regex rx(exclude_regex, boost::regex::extended);
+    extractTextInfo(tags, node, rx, workdir);
 
-        if(type != TextTag::TT_OTHER) {
-            if(child->isOneFile()) {
-                shared_ptr<string> file = child->oneFile();
-                if(file && (file == lastFile ||
-                            isLocalFile(*file, workdir))) {
-                    if(file != lastFile || !tags) {
-                        lastFile = file;
-                        string ffile = absolutePath(*file, aWorkdir)
-                                        .substr(aWorkdir.size()+1);
-                        TextTagList& tl = extract<TextTagList&>(
-                            result.setdefault(ffile, TextTagList()));
-                        tags = &tl;
-                    }
-
-                    // Save the node
-                    std::pair<size_t, size_t> pos = child->sourcePos();
-                    tags->push_back(TextTag(type, pos.first, pos.second,
-                                                child->valueString()));
-                }
-            }
-        } else if(child->type().compare(0, 12, "environment_") == 0 &&
-                    !boost::regex_match(child->type(), exclude_regex)) {
-            _extractTextInfo(result, child, exclude_regex, workdir);
-            tags = 0; // XXX: it it really required ?
-        }
-    }
+    dict result;
+    for(TextTagsMap::const_iterator it = tags.begin(), e = tags.end();
+                            it != e; ++it)
+        result[it->first] = it->second;
+    return result;
 }
 
-dict extractTextInfo(const Node::ptr node, const string& exclude_regex,
+dict extractTextColumnsWrap(const Node::ptr node, const string& exclude_regex,
                 const string& workdir = string())
 {
-    dict result;
+    TextColumnsMap tags;
     boost::regex rx(exclude_regex, boost::regex::extended);
-    _extractTextInfo(result, node, rx, workdir);
+    extractTextColumns(tags, node, rx, workdir);
+
+    dict result;
+    for(TextColumnsMap::iterator it = tags.begin(), e = tags.end();
+                            it != e; ++it) {
+        shared_ptr<TextTagColumns> columns(new TextTagColumns);
+        columns->swap(it->second);
+        result[it->first] = columns;
+    }
     return result;
 }
 
-string getDocumentEncoding(const Node::ptr node)
+TextTag TextTagColumns_getitem(const TextTagColumns& tags, long n)
 {
-    string result;
-    const Node::ChildrenList& c = node->children();
-    for(Node::ChildrenList::const_iterator it = c.begin(), e = c.end();
-                            it != e; ++it) {
-        if(it->second->type() == "inputenc") {
-            result = it->second->valueString();
-            break;
-        }
+    if(n < 0) n += long(tags.size());
+    if(n < 0 || size_t(n) >= tags.size()) {
+        PyErr_SetString(PyExc_IndexError, "index out of range");
+        throw_error_already_set();
+    }
+    return tags.tag(n);
+}
+
+#define TEXT_TAG_COLUMN(name) \
+    ArrayView TextTagColumns_##name(shared_ptr<TextTagColumns> tags) { \
+        return ArrayView::fromVector(tags, tags->name()); \
+    }
+
+TEXT_TAG_COLUMN(types)
+TEXT_TAG_COLUMN(starts)
+TEXT_TAG_COLUMN(ends)
+TEXT_TAG_COLUMN(valueOffsets)
+
+#undef TEXT_TAG_COLUMN
+
+ArrayView TextTagColumns_valuePool(shared_ptr<TextTagColumns> tags)
+{
+    return ArrayView::fromString(tags, tags->valuePool());
+}
+
+// LiteralMatcher filled from python dictionaries
+struct LiteralMatcherWrap: LiteralMatcher
+{
+    LiteralMatcherWrap(const dict& literals, const dict& notLiterals,
+            const WordsDict* wordsDict, const Stemmer* stemmer,
+            const dict& whiteList = dict())
+        : LiteralMatcher(wordsDict, stemmer)
+    {
+        for(stl_input_iterator<string> it(literals.keys()), e;
+                                                it != e; ++it)
+            insert(*it);
+        for(stl_input_iterator<string> it(notLiterals.keys()), e;
+                                                it != e; ++it)
+            insertNotLiteral(*it);
+        for(stl_input_iterator<string> it(whiteList.keys()), e;
+                                                it != e; ++it)
+            insertWhiteListed(*it);
     }
-    if(!result.empty())
-        return result;
-    else
-        return string("ascii");
+};
+
+TextTagList LiteralMatcher_find(const LiteralMatcherWrap& matcher,
+        const TextTagList& tags, size_t maxChars = 0)
+{
+    return matcher.find(tags, maxChars);
+}
+
+TextTagList LiteralMatcher_findColumns(const LiteralMatcherWrap& matcher,
+        const TextTagColumns& tags, size_t maxChars = 0)
+{
+    return matcher.find(tags, maxChars);
 }
 
 TextTagList findLiterals(const TextTagList& tags,
@@ -446,119 +212,67 @@ TextTagList findLiterals(const TextTagList& tags,
         const WordsDict* wordsDict, const Stemmer* stemmer, const dict& whiteList,
         size_t maxChars = 0)
 {
-    TextTagList result;
-
-    // Detemine a maximum literal length
-    if(maxChars == 0) {
-        for(stl_input_iterator<str> it(literals.iterkeys()), e;
-                                                it != e; ++it) {
-            size_t l = len(*it);
-            if(l > maxChars)
-                maxChars = l;
-        }
-    }
+    return LiteralMatcherWrap(literals, notLiterals,
+                    wordsDict, stemmer, whiteList).find(tags, maxChars);
+}
 
-    // Process the text
-    size_t count = tags.size();
-    for(size_t n = 0; n < count; ++n) {
-        if(tags[n].type == TextTag::TT_CHARACTER) {
-            // Do not start from ignored character
-            if(_isIgnored(tags[n].value[0])) continue;
-        } else if(tags[n].type != TextTag::TT_WORD) {
-            // Ignore unknown tags
-            continue;
-        }
+long writeReplacedFileWrap(const string& sourceFile,
+        const string& outputFile, const TextTagList& tags,
+        const ReplacementTemplate& tmpl)
+{
+    return writeReplacedFile(sourceFile, outputFile, tags, tmpl);
+}
 
-        // If previous tag is character and is adjacent,
-        // then it should be a space
-        if(n && tags[n-1].end == tags[n].start &&
-                tags[n-1].type == TextTag::TT_CHARACTER &&
-                _isglue(tags[n-1].value[0])) {
-            continue;
-        }
+struct PipelineWrap: Pipeline
+{
+    PipelineWrap(const LiteralMatcherWrap* matcher,
+            const string& excludeRegex = EXCLUDED_ENVIRONMENTS,
+            const string& macro = "href")
+        : Pipeline(matcher, excludeRegex, macro) {}
+};
 
-        // Do not start on an article
-        if(_isIgnoredWord(tags[n].value)) {
-            continue;
-        }
+PipelineReport Pipeline_run(const PipelineWrap& pipeline,
+        const Node::ptr document, const string& workdir,
+        const string& outputDir)
+{
+    PipelineReport report;
+    pipeline.run(document, workdir, outputDir, report);
+    return report;
+}
 
-        string text;
-        size_t pos = tags[n].start;
-        std::vector<boost::tuple<string, size_t, size_t> > foundLiterals;
-
-        for(size_t k = n; k < count; ++k) {
-            const TextTag& tagk = tags[k];
-
-            // Stop if tag is not adjacent
-            if(tagk.start != pos) {
-                break;
-            }
-            pos = tagk.end;
-
-            text += tagk.value;
-            if(tagk.type == TextTag::TT_CHARACTER) {
-                // Skip ignored characters
-                if(_isIgnored(tagk.value[0])) continue;
-            } else if(tagk.type != TextTag::TT_WORD) {
-                // Stop on unknown tags
-                break;
-            }
-
-            // If next tag is character and is adjacent,
-            // then it should be a space
-            if(k+1 < count && tags[k+1].start == tags[k].end &&
-                    tags[k+1].type == TextTag::TT_CHARACTER &&
-                    _isglue(tags[k+1].value[0])) {
-                continue;
-            }
-
-            // Norm literal
-            string literal = normLiteral(text, wordsDict, stemmer, whiteList);
-            if(literal.size() > maxChars) {
-                continue; // XXX: can normLiteral size gets smaller ?
-            }
-
-            // Lookup in dictionary
-            if(literals.has_key(literal)) {
-                // Skip known non-literal words
-                if((!notLiterals.has_key(text)) &&
-                        (k+1>=count ||
-                         tags[k+1].type != TextTag::TT_CHARACTER ||
-                         tags[k+1].value[0] != '.' ||
-                         !notLiterals.has_key(text+'.'))) {
-                    foundLiterals.push_back(
-                            boost::make_tuple(literal, tagk.end, k));
-                }
-            }
-        }
+PipelineReport Pipeline_runFile(const PipelineWrap& pipeline,
+        const string& fileName, const string& outputDir)
+{
+    return pipeline.run(fileName, outputDir);
+}
 
-        if(!foundLiterals.empty()) { // XXX: return all found literals !
-            // Create a tag for the longest literal found
-            result.push_back(TextTag(TextTag::TT_LITERAL, tags[n].start,
-                                foundLiterals.back().get<1>(),
-                                foundLiterals.back().get<0>()));
-            n = foundLiterals.back().get<2>();
-        }
-    }
+list PipelineReport_stages(const PipelineReport& report)
+{
+    list result;
+    for(std::vector<PipelineReport::Stage>::const_iterator
+                it = report.stages.begin(), e = report.stages.end();
+                it != e; ++it)
+        result.append(boost::python::make_tuple(it->name, it->count,
+                    double(it->time) / 1e9));
+    return result;
+}
 
+dict PipelineReport_foundLiterals(const PipelineReport& report)
+{
+    dict result;
+    for(std::map<string, size_t>::const_iterator
+                it = report.foundLiterals.begin(),
+                e = report.foundLiterals.end(); it != e; ++it)
+        result[it->first] = it->second;
     return result;
 }
 
-string replaceLiterals(const string& source,
-                    const TextTagList& tags)
+list PipelineReport_errors(const PipelineReport& report)
 {
-    string result;
-    result.reserve(source.size() + source.size()/5);
-    size_t pos = 0;
-    TextTagList::const_iterator end = tags.end();
-    for(TextTagList::const_iterator it = tags.begin(); it != end; ++it) {
-        if(it->type == TextTag::TT_LITERAL) {
-            result += source.substr(pos, it->start - pos);
-            result += it->value;
-            pos = it->end;
-        }
-    }
-    result += source.substr(pos, source.size() - pos);
+    list result;
+    for(std::vector<string>::const_iterator it = report.errors.begin(),
+                e = report.errors.end(); it != e; ++it)
+        result.append(*it);
     return result;
 }
 
@@ -585,6 +299,11 @@ void export_TextTag()
     ;
 }
 
+BOOST_PYTHON_FUNCTION_OVERLOADS(
+    LiteralMatcher_find_overloads, LiteralMatcher_find, 2, 3)
+BOOST_PYTHON_FUNCTION_OVERLOADS(
+    LiteralMatcher_findColumns_overloads, LiteralMatcher_findColumns, 2, 3)
+
 BOOST_PYTHON_MODULE(_chrefliterals)
 {
     using namespace boost::python;
@@ -593,24 +312,102 @@ BOOST_PYTHON_MODULE(_chrefliterals)
     class_<TextTagList>("TextTagList")
         .def("__repr__", &textTagListRepr)
         .def(vector_indexing_suite<TextTagList>())
+        .def("to_bytes", &TextTagList_toBytes)
+        .def("from_bytes", &TextTagList_fromBytes)
+        .staticmethod("from_bytes")
         .def_pickle(TextTagListPickeSuite())
     ;
 
-    class_<Stemmer>("Stemmer", init<>())
+    // Column views need the ArrayView type registered by texpy
+    class_<TextTagColumns, shared_ptr<TextTagColumns> >("TextTagColumns")
+        .def(init<const TextTagList&>())
+        .def("__len__", &TextTagColumns::size)
+        .def("__getitem__", &TextTagColumns_getitem)
+        .def("tags", &TextTagColumns::tags)
+        .def("types", &TextTagColumns_types)
+        .def("starts", &TextTagColumns_starts)
+        .def("ends", &TextTagColumns_ends)
+        .def("valueOffsets", &TextTagColumns_valueOffsets)
+        .def("valuePool", &TextTagColumns_valuePool)
+    ;
+
+    class_<Stemmer, boost::noncopyable>("Stemmer", init<>())
         .def("stem", &Stemmer::stem)
     ;
 
-    class_<WordsDict>("WordsDict", init<string, size_t>())
+    class_<WordsDict, boost::noncopyable>("WordsDict", no_init)
+        .def("__init__", make_constructor(&WordsDict_create))
         .def("insert", &WordsDict::insert)
         .def("contains", &WordsDict::contains)
+        .def("compiled", &WordsDict::compiled)
+        .def("compile", &WordsDict::compile)
+        .staticmethod("compile")
+        .def("cacheHits", &WordsDict::cacheHits)
+        .def("cacheMisses", &WordsDict::cacheMisses)
+        .def("cacheSize", &WordsDict::cacheSize)
+        .def("cacheMaxSize", &WordsDict::cacheMaxSize)
+        .def("setCacheMaxSize", &WordsDict::setCacheMaxSize)
+        .def("clearCache", &WordsDict::clearCache)
+    ;
+
+    class_<LiteralMatcherWrap, boost::noncopyable>("LiteralMatcher",
+            init<dict, dict, const WordsDict*, const Stemmer*,
+                    optional<dict> >()[
+                with_custodian_and_ward<1, 4,
+                with_custodian_and_ward<1, 5> >()])
+        .def("insert", &LiteralMatcher::insert)
+        .def("insertNotLiteral", &LiteralMatcher::insertNotLiteral)
+        .def("insertWhiteListed", &LiteralMatcher::insertWhiteListed)
+        .def("contains", &LiteralMatcher::contains)
+        .def("__len__", &LiteralMatcher::size)
+        .def("find", &LiteralMatcher_find, LiteralMatcher_find_overloads())
+        .def("find", &LiteralMatcher_findColumns,
+                LiteralMatcher_findColumns_overloads())
+        .def("load", &LiteralMatcher::load)
+        .def("save", &LiteralMatcher::save)
+        .def("error", &LiteralMatcher::error,
+                return_value_policy<copy_const_reference>())
+    ;
+
+    class_<ReplacementTemplate>("ReplacementTemplate",
+            init<optional<string> >())
+        .def("pattern", &ReplacementTemplate::pattern,
+                return_value_policy<copy_const_reference>())
+        .def("expand", &ReplacementTemplate::expand)
+    ;
+
+    class_<PipelineReport>("PipelineReport")
+        .def_readonly("files", &PipelineReport::files)
+        .def_readonly("textTags", &PipelineReport::textTags)
+        .def_readonly("literals", &PipelineReport::literals)
+        .def_readonly("bytesRead", &PipelineReport::bytesRead)
+        .def_readonly("bytesWritten", &PipelineReport::bytesWritten)
+        .def("stages", &PipelineReport_stages)
+        .def("foundLiterals", &PipelineReport_foundLiterals)
+        .def("errors", &PipelineReport_errors)
+        .def("totalTime", &PipelineReport::totalTime)
+        .def("json", &PipelineReport::json)
+        .def("__str__", &PipelineReport::repr)
+    ;
+
+    class_<PipelineWrap, boost::noncopyable>("Pipeline",
+            init<const LiteralMatcherWrap*, optional<string, string> >()[
+                with_custodian_and_ward<1, 2>()])
+        .def("macro", &Pipeline::macro,
+                return_value_policy<copy_const_reference>())
+        .def("run", &Pipeline_run)
+        .def("runFile", &Pipeline_runFile)
     ;
 
     def("absolutePath", &absolutePath);
     def("isLocalFile", &isLocalFile);
-    def("normLiteral", &normLiteral);
-    def("extractTextInfo", &extractTextInfo);
+    def("normLiteral", &normLiteralWrap);
+    def("extractTextInfo", &extractTextInfoWrap);
+    def("extractTextColumns", &extractTextColumnsWrap);
     def("getDocumentEncoding", &getDocumentEncoding);
     def("findLiterals", &findLiterals);
     def("replaceLiterals", &replaceLiterals);
+    def("writeReplacedFile", &writeReplacedFileWrap);
+    def("compileConcepts", &compileConcepts);
 }
 
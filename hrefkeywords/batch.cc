@@ -0,0 +1,219 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "batch.h"
+
+#include <texpp/vfs.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <sstream>
+
+namespace hrefkeywords {
+
+namespace {
+
+namespace fs = boost::filesystem;
+
+bool endsWith(const string& str, const string& suffix)
+{
+    return str.size() >= suffix.size() &&
+        str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Queue of article indexes of a worker
+struct WorkQueue
+{
+    boost::mutex mutex;
+    std::deque<size_t> items;
+};
+
+struct BatchState
+{
+    BatchState(const std::vector<string>& i, const string& o,
+               BatchDriver::Callback c, size_t threads)
+        : inputs(i), outputRoot(o), callback(c), queues(threads) {
+        for(size_t n = 0; n < threads; ++n)
+            queues[n].reset(new WorkQueue);
+    }
+
+    // Own queue front first, then the back of the others
+    bool next(size_t worker, size_t& item) {
+        for(size_t n = 0; n < queues.size(); ++n) {
+            WorkQueue& queue = *queues[(worker + n) % queues.size()];
+            boost::mutex::scoped_lock lock(queue.mutex);
+            if(queue.items.empty()) continue;
+            if(n == 0) {
+                item = queue.items.front();
+                queue.items.pop_front();
+            } else {
+                item = queue.items.back();
+                queue.items.pop_back();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    const std::vector<string>& inputs;
+    const string& outputRoot;
+    BatchDriver::Callback callback;
+    std::vector<boost::shared_ptr<WorkQueue> > queues;
+    boost::mutex callbackMutex;
+};
+
+void worker(const BatchDriver* driver, BatchState* state, size_t id)
+{
+    WordCache cache;
+    size_t item;
+    while(state->next(id, item)) {
+        BatchResult result = driver->process(
+                    state->inputs[item], state->outputRoot, &cache);
+        boost::mutex::scoped_lock lock(state->callbackMutex);
+        if(state->callback) state->callback(result);
+    }
+}
+
+} // namespace
+
+string BatchResult::json() const
+{
+    std::ostringstream out;
+    out << "{\"input\": ";
+    jsonString(out, input);
+    out << ", \"main\": ";
+    jsonString(out, mainFile);
+    out << ", \"output\": ";
+    jsonString(out, outputDir);
+    out << ", \"ok\": " << (ok() ? "true" : "false")
+        << ", \"report\": " << report.json() << "}";
+    return out.str();
+}
+
+BatchDriver::BatchDriver(const Pipeline* pipeline, size_t threads)
+    : _pipeline(pipeline), _threads(threads)
+{
+    if(_threads == 0)
+        _threads = std::max(1u, boost::thread::hardware_concurrency());
+}
+
+void BatchDriver::run(const std::vector<string>& inputs,
+                const string& outputRoot, Callback callback) const
+{
+    size_t threads = std::min(_threads, std::max(inputs.size(), size_t(1)));
+    BatchState state(inputs, outputRoot, callback, threads);
+    for(size_t n = 0; n < inputs.size(); ++n)
+        state.queues[n % threads]->items.push_back(n);
+
+    boost::thread_group group;
+    for(size_t n = 0; n < threads; ++n)
+        group.create_thread(boost::bind(&worker, this, &state, n));
+    group.join_all();
+}
+
+BatchResult BatchDriver::process(const string& input,
+                const string& outputRoot, WordCache* cache) const
+{
+    BatchResult result;
+    result.input = input;
+    result.outputDir = (fs::path(outputRoot) / articleName(input)).string();
+
+    // Directories are read from disk, archives from memory. Both
+    // fall back to the real file system for packages.
+    string root = absolutePath(input, string());
+    texpp::Vfs::ptr vfs;
+    std::vector<string> fileNames;
+    boost::system::error_code ec;
+    if(fs::is_directory(root, ec)) {
+        vfs.reset(new texpp::FileSystemVfs);
+        for(fs::directory_iterator it(root, ec), e; !ec && it != e;
+                                                    it.increment(ec))
+            fileNames.push_back(it->path().string());
+    } else {
+        texpp::ArchiveVfs::ptr archive(new texpp::ArchiveVfs(
+                    texpp::Vfs::ptr(new texpp::FileSystemVfs)));
+        if(!archive->load(root, root)) {
+            result.report.errors.push_back("Can not read archive " + input);
+            return result;
+        }
+        // Only files at the top of the archive, as in directories
+        std::vector<string> names = archive->fileNames();
+        for(std::vector<string>::iterator it = names.begin();
+                                    it != names.end(); ++it)
+            if(fs::path(*it).parent_path() == fs::path(root))
+                fileNames.push_back(*it);
+        vfs = archive;
+    }
+
+    std::sort(fileNames.begin(), fileNames.end());
+    string mainFile = findMainFile(*vfs, fileNames);
+    if(mainFile.empty()) {
+        result.report.errors.push_back("Can not find main TeX file in " +
+                                        input);
+        return result;
+    }
+
+    result.mainFile = fs::path(mainFile).filename().string();
+    result.report = _pipeline->run(mainFile, result.outputDir, vfs, cache);
+    return result;
+}
+
+string BatchDriver::articleName(const string& input)
+{
+    // Resolved first, so that "." or "dir/.." are named after the
+    // directory they stand for
+    string name = fs::path(absolutePath(input, string())).filename().string();
+
+    const char* suffixes[] = { ".tar.gz", ".tgz", ".tar", ".gz", NULL };
+    for(const char** s = suffixes; *s; ++s) {
+        if(endsWith(name, *s) && name.size() > std::strlen(*s)) {
+            name.resize(name.size() - std::strlen(*s));
+            break;
+        }
+    }
+    return name;
+}
+
+string BatchDriver::findMainFile(texpp::Vfs& vfs,
+                const std::vector<string>& fileNames)
+{
+    for(std::vector<string>::const_iterator it = fileNames.begin(),
+                        e = fileNames.end(); it != e; ++it) {
+        if(!endsWith(*it, ".tex")) continue;
+        shared_ptr<std::istream> file = vfs.open(*it);
+        if(!file) continue;
+
+        string line;
+        while(std::getline(*file, line)) {
+            if(line.find("\\documentclass") != string::npos ||
+                    line.find("\\documentstyle") != string::npos)
+                return *it;
+        }
+    }
+    return string();
+}
+
+} // namespace hrefkeywords
+
@@ -0,0 +1,95 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __HREFKEYWORDS_BATCH_H
+#define __HREFKEYWORDS_BATCH_H
+
+#include <string>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "pipeline.h"
+
+namespace hrefkeywords {
+
+// Result of processing one article of a batch
+struct BatchResult
+{
+    string input;       // article directory or archive
+    string mainFile;    // main TeX file, relative to the article
+    string outputDir;
+    PipelineReport report;
+
+    bool ok() const { return !mainFile.empty() && report.errors.empty(); }
+
+    // Single line JSON object, the report fields are nested in it
+    string json() const;
+};
+
+// Runs a Pipeline over many articles on a pool of worker threads.
+// An article is either a directory or an archive as stored by arXiv:
+// a tar file, gzip compressed or not, or a gzipped single TeX file.
+// Archives are read in memory and never unpacked to disk.
+//
+// Articles are dealt to per-worker queues up front. A worker takes
+// articles from the front of its own queue and, once it runs empty,
+// steals from the back of the others, so that a few huge articles do
+// not leave the other workers idle. The pipeline, and so the literal
+// index, words dictionary and stemmer, are shared read-only between
+// workers; each worker keeps a word cache of its own.
+class BatchDriver: boost::noncopyable
+{
+public:
+    typedef boost::function<void (const BatchResult&)> Callback;
+
+    // threads is the number of workers, the number of cores if 0
+    explicit BatchDriver(const Pipeline* pipeline, size_t threads = 0);
+
+    size_t threads() const { return _threads; }
+
+    // Processes all inputs, the files of input X are written to
+    // outputRoot/articleName(X). The callback is called once for every
+    // article as soon as it is done, never by two workers at once.
+    void run(const std::vector<string>& inputs, const string& outputRoot,
+             Callback callback) const;
+
+    // Processes a single article in the calling thread
+    BatchResult process(const string& input, const string& outputRoot,
+                        WordCache* cache = NULL) const;
+
+    // Input name without directory and archive suffixes, "." and ".."
+    // are resolved first
+    static string articleName(const string& input);
+
+    // First .tex file of fileNames containing \documentclass or
+    // \documentstyle, as hreftest.py finds the main file of an article;
+    // an empty string if there is none
+    static string findMainFile(texpp::Vfs& vfs,
+                               const std::vector<string>& fileNames);
+
+protected:
+    const Pipeline* _pipeline;
+    size_t _threads;
+};
+
+} // namespace hrefkeywords
+
+#endif
+
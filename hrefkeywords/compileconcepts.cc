@@ -0,0 +1,76 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+
+#include "literals.h"
+
+static void usage(const char* program)
+{
+    std::cerr << "Usage: " << program
+              << " [-w wordsfile] [-a abbrmax] conceptsfile outfile"
+              << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    std::string wordsFile("/usr/share/dict/words");
+    size_t abbrMaxLen = 4;
+    std::vector<std::string> args;
+
+    for(int i = 1; i < argc; ++i) {
+        if((!std::strcmp(argv[i], "-w") ||
+                !std::strcmp(argv[i], "-a")) && i+1 < argc) {
+            if(argv[i][1] == 'w') wordsFile = argv[++i];
+            else abbrMaxLen = std::atoi(argv[++i]);
+        } else if(argv[i][0] == '-') {
+            usage(argv[0]);
+            return 255;
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+
+    if(args.size() != 2) {
+        usage(argv[0]);
+        return 255;
+    }
+
+    // Literals must be normalized exactly as hrefliterals.py does
+    hrefkeywords::Stemmer stemmer;
+    hrefkeywords::WordsDict words(wordsFile, abbrMaxLen);
+    if(!words.error().empty()) {
+        std::cerr << words.error() << std::endl;
+        return 1;
+    }
+    words.insert("I");
+    words.insert("a");
+
+    if(!hrefkeywords::compileConcepts(args[0], args[1], &words, &stemmer)) {
+        std::cerr << "Can not compile " << args[0]
+                  << " into " << args[1] << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
@@ -0,0 +1,32 @@
+#!/usr/bin/env python
+
+import sys
+
+from _chrefliterals import WordsDict
+
+ABBR_MAX = 4
+
+def main():
+    """ Main routine """
+
+    # Define command line options
+    from optparse import OptionParser
+    optparser = OptionParser(usage='%prog [options] wordsfile outfile')
+    optparser.add_option('-a', '--abbr-max', type='int', default=ABBR_MAX,
+                help='maximum abbreviation length (default: %d)' % ABBR_MAX)
+
+    # Parse command line options
+    opt, args = optparser.parse_args()
+
+    if len(args) != 2:
+        optparser.error('Wrong command line arguments')
+
+    # Compile the dictionary
+    if not WordsDict.compile(args[0], args[1], opt.abbr_max):
+        sys.stderr.write('Can not compile \'%s\' into \'%s\'\n' % \
+                                (args[0], args[1]))
+        sys.exit(1)
+
+if __name__ == '__main__':
+    main()
+
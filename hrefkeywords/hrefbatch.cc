@@ -0,0 +1,128 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+
+#include <boost/bind.hpp>
+
+#include "literals.h"
+#include "pipeline.h"
+#include "batch.h"
+
+using namespace hrefkeywords;
+
+static void usage(const char* program)
+{
+    std::cerr << "Usage: " << program
+              << " -c conceptsfile -o outputroot [-w wordsfile]"
+                 " [-m macro] [-j threads] [-l listfile] [article...]"
+              << std::endl;
+}
+
+static void printResult(std::ostream* out, bool* failed,
+                        const BatchResult& result)
+{
+    *out << result.json() << std::endl;
+    if(!result.ok()) *failed = true;
+}
+
+int main(int argc, char** argv)
+{
+    std::string conceptsFile, outputRoot, listFile;
+    std::string wordsFile("/usr/share/dict/words");
+    std::string macro("href");
+    size_t threads = 0;
+    std::vector<std::string> inputs;
+
+    for(int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if(arg.size() == 2 && arg[0] == '-' &&
+                std::strchr("cowmjl", arg[1]) && i+1 < argc) {
+            std::string value(argv[++i]);
+            switch(arg[1]) {
+                case 'c': conceptsFile = value; break;
+                case 'o': outputRoot = value; break;
+                case 'w': wordsFile = value; break;
+                case 'm': macro = value; break;
+                case 'j': threads = std::atoi(value.c_str()); break;
+                case 'l': listFile = value; break;
+            }
+        } else if(arg[0] == '-') {
+            usage(argv[0]);
+            return 255;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+
+    if(!listFile.empty()) {
+        std::ifstream list(listFile.c_str());
+        if(!list.good()) {
+            std::cerr << "Can not open list file " << listFile << std::endl;
+            return 1;
+        }
+        std::string line;
+        while(std::getline(list, line))
+            if(!line.empty()) inputs.push_back(line);
+    }
+
+    if(inputs.empty() || conceptsFile.empty() || outputRoot.empty()) {
+        usage(argv[0]);
+        return 255;
+    }
+
+    // Everything below is shared read-only by the workers
+    Stemmer stemmer;
+    WordsDict words(wordsFile, 4);
+    if(!words.error().empty()) {
+        std::cerr << words.error() << std::endl;
+        return 1;
+    }
+    words.insert("I");
+    words.insert("a");
+
+    LiteralMatcher matcher(&words, &stemmer);
+    if(!matcher.load(conceptsFile)) {
+        if(!matcher.error().empty()) {
+            std::cerr << matcher.error() << std::endl;
+            return 1;
+        }
+        if(!matcher.loadConcepts(conceptsFile)) {
+            std::cerr << "Can not open concepts file " << conceptsFile
+                      << std::endl;
+            return 1;
+        }
+    }
+    for(const char* const* n = KNOWN_NOT_LITERALS; *n; ++n)
+        matcher.insertNotLiteral(*n);
+
+    Pipeline pipeline(&matcher, EXCLUDED_ENVIRONMENTS, macro);
+    // The callback is never called by two workers at once
+    bool failed = false;
+    BatchDriver driver(&pipeline, threads);
+    driver.run(inputs, outputRoot,
+               boost::bind(&printResult, &std::cout, &failed, _1));
+
+    return failed ? 1 : 0;
+}
+
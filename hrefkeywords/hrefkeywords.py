@@ -37,13 +37,9 @@ def loadConcepts(conceptsfile):
     return concepts
 
 def parseDocument(filename, fileobj):
-    """ Parses the document using TeXpp """
-    parser = texpy.Parser(filename, fileobj, '', False, True)
-
-    # Mimic the most important parts of LaTeX style
-    latexstubs.initLaTeXstyle(parser)
-
-    # Do the real work
+    """ Parses the document using TeXpp with the native LaTeX stubs """
+    parser = texpy.Parser(filename, fileobj, '', False, True, None,
+                          texpy.Parser.Style.LATEX)
     return parser.parse()
 
 def doReplace(node, macro, concepts, filename):
@@ -3,16 +3,16 @@
 import sys
 import texpy
 
-import latexstubs
-
 import codecs
 import re
 import os
 
 from _chrefliterals import \
-    Stemmer, WordsDict, TextTag, TextTagList, \
-    absolutePath, isLocalFile, normLiteral, extractTextInfo, \
-    getDocumentEncoding, findLiterals, replaceLiterals
+    Stemmer, WordsDict, TextTag, TextTagList, TextTagColumns, \
+    LiteralMatcher, absolutePath, isLocalFile, normLiteral, \
+    extractTextInfo, extractTextColumns, \
+    getDocumentEncoding, findLiterals, replaceLiterals, compileConcepts, \
+    ReplacementTemplate, writeReplacedFile, Pipeline, PipelineReport
 
 ABBR_MAX = 4
 
@@ -40,19 +40,15 @@ def loadLiteralsFromConcepts4(conceptsfile, words, stemmer):
                     .replace('\\)', ')')
 
         literals.setdefault(
-                normLiteral(line1, words, stemmer), []) \
+                normLiteral(line1, words, stemmer, {}), []) \
             .append(line1)
 
     return literals
 
 def parseDocument(filename, fileobj, workdir):
-    """ Parses the document using TeXpp """
-    parser = texpy.Parser(filename, fileobj, workdir, False, True)
-
-    # Mimic the most important parts of LaTeX style
-    latexstubs.initLaTeXstyle(parser)
-
-    # Do the real work
+    """ Parses the document using TeXpp with the native LaTeX stubs """
+    parser = texpy.Parser(filename, fileobj, workdir, False, True, None,
+                          texpy.Parser.Style.LATEX)
     return parser.parse()
 
 def main():
@@ -61,12 +57,17 @@ def main():
     # Define command line options
     from optparse import OptionParser
     optparser = OptionParser(usage='%prog [options] texfile')
-    optparser.add_option('-c', '--concepts', type='string', help='concepts file')
+    optparser.add_option('-c', '--concepts', type='string',
+                help='concepts file, plain or compiled with compileconcepts')
     optparser.add_option('-o', '--output', type='string', help='output directory')
     optparser.add_option('-m', '--macro', type='string', default='href', 
                                     help='macro (default: href)')
     optparser.add_option('-s', '--stats', action='store_true', help='print stats')
     optparser.add_option('-t', '--timings', action='store_true', help='print timings')
+    optparser.add_option('-w', '--words', type='string',
+                default='/usr/share/dict/words',
+                help='words file, plain or compiled with compilewords.py ' + \
+                     '(default: /usr/share/dict/words)')
 
     # Parse command line options
     opt, args = optparser.parse_args()
@@ -110,12 +111,18 @@ def main():
 
     # Load words and create stemmer
     stemmer = Stemmer()
-    words = WordsDict('/usr/share/dict/words', ABBR_MAX)
+    words = WordsDict(opt.words, ABBR_MAX)
     words.insert('I')
     words.insert('a')
 
-    # Load concepts
-    literals = loadLiteralsFromConcepts4(conceptsfile, words, stemmer)
+    # Load concepts, either compiled with compileconcepts or as text
+    matcher = LiteralMatcher({}, knownNotLiterals, words, stemmer)
+    if not matcher.load(opt.concepts):
+        if matcher.error():
+            optparser.error(matcher.error())
+        literals = loadLiteralsFromConcepts4(conceptsfile, words, stemmer)
+        for literal in literals:
+            matcher.insert(literal)
     conceptsfile.close()
 
     import time
@@ -127,56 +134,23 @@ def main():
     timings.append('parseDocument: %f' % (time.time()-tm,))
     fileobj.close()
 
-    # Extract text tags
-    tm = time.time()
-    textTags = extractTextInfo(document, excludedEnvironments, workdir)
-    timings.append('extractTextInfo: %f' % (time.time()-tm,))
-
-    # Find literals in each file
-    replaced = {}
-    foundLiterals = {}
-    for f, tags in textTags.iteritems():
-        assert f is not None and isLocalFile(f, workdir)
-        tm = time.time()
-        literalTags = findLiterals(tags, literals, knownNotLiterals,
-                                            words, stemmer, 0)
-        timings.append('findLiterals: %f' % (time.time()-tm,))
-        tm = time.time()
-        source = open(os.path.join(workdir, f), 'r').read()
-        timings.append('readSourceFile: %f' % (time.time()-tm,))
-        tm = time.time()
-        for t in literalTags:
-            foundLiterals[t.value] = foundLiterals.get(t.value, 0) + 1
-            t.value = ''.join(('\\href{', t.value, '}{',
-                            source[t.start:t.end], '}'))
-        timings.append('prepareReplacements: %f' % (time.time()-tm,))
-        tm = time.time()
-        replaced[f] = replaceLiterals(source, literalTags)
-        timings.append('replaceLiterals: %f' % (time.time()-tm,))
-
-    # Save results
-    for f, s in replaced.iteritems():
-        assert f is not None and isLocalFile(f, workdir)
-        fname = os.path.join(opt.output, f)
-        try:
-            outfile = open(fname, 'w')
-        except IOError, e:
-            sys.stdout('Can not open output file (\'%s\'): %s' % \
-                                (fname, str(e)))
-            continue
-        tm = time.time()
-        outfile.write(s)
-        outfile.close()
-        timings.append('writeSourceFile: %f' % (time.time()-tm,))
+    # Find literals and write the replaced source files
+    pipeline = Pipeline(matcher, excludedEnvironments, opt.macro)
+    report = pipeline.run(document, workdir, opt.output)
+    for error in report.errors():
+        sys.stderr.write(error + '\n')
 
     # Stats
     if opt.stats:
-        for w,n in foundLiterals.iteritems():
-            print 'Concept <%s> replaced %f times' % (w, n)
+        for w,n in report.foundLiterals().iteritems():
+            print 'Concept <%s> replaced %d times' % (w, n)
+        print 'Word cache: %d hits, %d misses' % \
+                    (words.cacheHits(), words.cacheMisses())
 
     if opt.timings:
         for l in timings:
             print l
+        print str(report),
 
 if __name__ == '__main__':
     main()
@@ -0,0 +1,122 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdlib>
+#include <cstring>
+
+#include "literals.h"
+#include "pipeline.h"
+
+using namespace hrefkeywords;
+
+static void usage(const char* program)
+{
+    std::cerr << "Usage: " << program
+              << " -c conceptsfile -o outputdir [-w wordsfile]"
+                 " [-m macro] [-s] [-t] texfile" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    std::string conceptsFile, outputDir;
+    std::string wordsFile("/usr/share/dict/words");
+    std::string macro("href");
+    bool stats = false, timings = false;
+    std::vector<std::string> args;
+
+    for(int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if(arg.size() == 2 && arg[0] == '-' &&
+                std::strchr("cowm", arg[1]) && i+1 < argc) {
+            std::string value(argv[++i]);
+            switch(arg[1]) {
+                case 'c': conceptsFile = value; break;
+                case 'o': outputDir = value; break;
+                case 'w': wordsFile = value; break;
+                case 'm': macro = value; break;
+            }
+        } else if(arg == "-s") {
+            stats = true;
+        } else if(arg == "-t") {
+            timings = true;
+        } else if(arg[0] == '-') {
+            usage(argv[0]);
+            return 255;
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    if(args.size() != 1 || conceptsFile.empty() || outputDir.empty()) {
+        usage(argv[0]);
+        return 255;
+    }
+
+    // Load words and create stemmer
+    Stemmer stemmer;
+    WordsDict words(wordsFile, 4);
+    if(!words.error().empty()) {
+        std::cerr << words.error() << std::endl;
+        return 1;
+    }
+    words.insert("I");
+    words.insert("a");
+
+    // Load concepts, either compiled with compileconcepts or as text
+    LiteralMatcher matcher(&words, &stemmer);
+    if(!matcher.load(conceptsFile)) {
+        if(!matcher.error().empty()) {
+            std::cerr << matcher.error() << std::endl;
+            return 1;
+        }
+        if(!matcher.loadConcepts(conceptsFile)) {
+            std::cerr << "Can not open concepts file " << conceptsFile
+                      << std::endl;
+            return 1;
+        }
+    }
+    for(const char* const* n = KNOWN_NOT_LITERALS; *n; ++n)
+        matcher.insertNotLiteral(*n);
+
+    Pipeline pipeline(&matcher, EXCLUDED_ENVIRONMENTS, macro);
+    PipelineReport report = pipeline.run(args[0], outputDir);
+
+    if(stats) {
+        for(std::map<std::string, size_t>::const_iterator
+                    it = report.foundLiterals.begin(),
+                    e = report.foundLiterals.end(); it != e; ++it)
+            std::cout << "Concept <" << it->first << "> replaced "
+                      << it->second << " times" << std::endl;
+        std::cout << "Word cache: " << words.cacheHits() << " hits, "
+                  << words.cacheMisses() << " misses" << std::endl;
+    }
+
+    if(timings)
+        std::cout << report.repr();
+
+    for(std::vector<std::string>::const_iterator it = report.errors.begin(),
+                e = report.errors.end(); it != e; ++it)
+        std::cerr << *it << std::endl;
+
+    return report.errors.empty() ? 0 : 1;
+}
+
@@ -150,7 +150,7 @@ class InputCommand(texpy.Command):
         if fname == 'xy':
             return True
 
-        fullname = texpy.kpsewhich(fname, parser.workdir())
+        fullname = parser.resolveFile(fname)
 
         parser.input(fname, fullname)
         return True
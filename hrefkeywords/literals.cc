@@ -0,0 +1,1275 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "literals.h"
+
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdio>
+#include <cctype>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+
+extern "C" {
+extern struct stemmer * create_stemmer(void);
+extern void free_stemmer(struct stemmer * z);
+
+extern int stem(struct stemmer * z, char * b, int k);
+}
+
+namespace hrefkeywords {
+
+namespace {
+
+inline bool _islower(char ch) { return ch >= 'a' && ch <= 'z'; }
+inline bool _isupper(char ch) { return ch >= 'A' && ch <= 'Z'; }
+
+inline bool _isglue(char ch) {
+    return isdigit(ch) || ch == '-' || ch == '/';
+}
+
+inline bool _isIgnored(char ch) {
+    return ch == ' ' || ch == '~' || ch == '-' || ch == '/';
+}
+
+inline bool _isIgnoredWord(const char* word, size_t size) {
+    switch(size) {
+        case 1: return word[0] == 'a' || word[0] == 'A';
+        case 2: return (word[0] == 'a' || word[0] == 'A') && word[1] == 'n';
+        case 3: return (word[0] == 't' || word[0] == 'T') &&
+                       word[1] == 'h' && word[2] == 'e';
+        default: return false;
+    }
+}
+
+inline bool _isIgnoredWord(const string& word) {
+    return _isIgnoredWord(word.data(), word.size());
+}
+
+// Accessors of TextTagColumns over a TextTagList
+struct TextTagListView
+{
+    explicit TextTagListView(const TextTagList& t): tags(t) {}
+
+    size_t size() const { return tags.size(); }
+    int type(size_t n) const { return tags[n].type; }
+    size_t start(size_t n) const { return tags[n].start; }
+    size_t end(size_t n) const { return tags[n].end; }
+    const char* valueData(size_t n) const { return tags[n].value.data(); }
+    size_t valueSize(size_t n) const { return tags[n].value.size(); }
+
+    const TextTagList& tags;
+};
+
+template<class Tags>
+inline char firstChar(const Tags& tags, size_t n) {
+    return tags.valueSize(n) ? tags.valueData(n)[0] : '\0';
+}
+
+inline bool acceptWord(const string& word, size_t abbrMaxLen)
+{
+    size_t s = word.size();
+    return s > 1 && s <= abbrMaxLen &&
+                (s < 2 || word.substr(s-2) != "'s");
+}
+
+inline boost::uint32_t hashWord(const char* str, size_t size)
+{
+    // FNV-1a
+    boost::uint32_t h = 2166136261U;
+    for(size_t n = 0; n < size; ++n) {
+        h ^= (unsigned char) str[n];
+        h *= 16777619U;
+    }
+    return h;
+}
+
+// Order independent combination of word hashes
+inline boost::uint64_t mixHash(boost::uint32_t h)
+{
+    boost::uint64_t x = (boost::uint64_t(h) + 1) * 0x9E3779B97F4A7C15ULL;
+    return x ^ (x >> 29);
+}
+
+const char WORDSDICT_MAGIC[8] = { 'T', 'X', 'P', 'W', 'O', 'R', 'D', 'S' };
+const boost::uint32_t WORDSDICT_VERSION = 2;
+
+const char LITERALS_MAGIC[8] = { 'T', 'X', 'P', 'L', 'I', 'T', 'R', 'S' };
+const boost::uint32_t LITERALS_VERSION = 2;
+
+const char TEXT_TAGS_MAGIC[8] = { 'T', 'X', 'P', 'T', 'A', 'G', 'S', '1' };
+
+inline void putVarint(string& out, boost::uint64_t value)
+{
+    while(value >= 0x80) {
+        out += char((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out += char(value);
+}
+
+inline bool getVarint(const char*& p, const char* end,
+                      boost::uint64_t& value)
+{
+    value = 0;
+    for(unsigned shift = 0; p < end && shift < 64; shift += 7) {
+        unsigned char ch = *p++;
+        value |= boost::uint64_t(ch & 0x7f) << shift;
+        if(!(ch & 0x80)) return true;
+    }
+    return false;
+}
+
+// Offsets are size_t, so differences wrap around and npos is -1
+inline boost::uint64_t zigzag(boost::uint64_t delta)
+{
+    return (delta << 1) ^ boost::uint64_t(boost::int64_t(delta) >> 63);
+}
+
+inline boost::uint64_t unzigzag(boost::uint64_t value)
+{
+    return (value >> 1) ^ (~(value & 1) + 1);
+}
+
+} // namespace
+
+string Stemmer::stem(string word) const
+{
+    if(word.empty()) return word;
+    // The stemmer state lives only for the call, which keeps stem()
+    // reentrant; it is only called for words missing from the cache
+    struct stemmer* z = create_stemmer();
+    int n = ::stem(z, &word[0], int(word.size())-1);
+    free_stemmer(z);
+    word.resize(n+1);
+    return word;
+}
+
+bool MappedFile::open(const string& fileName,
+                      const char* magic, size_t magicSize)
+{
+    close();
+
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+
+    struct stat st;
+    std::vector<char> head(magicSize + 1);
+    if(::fstat(fd, &st) != 0 || st.st_size == 0 ||
+            size_t(st.st_size) < magicSize ||
+            ::read(fd, &head[0], magicSize) != ssize_t(magicSize) ||
+            std::memcmp(&head[0], magic, magicSize) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* data = ::mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(data == MAP_FAILED) return false;
+
+    _data = static_cast<const char*>(data);
+    _size = st.st_size;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if(_data)
+        ::munmap(const_cast<char*>(_data), _size);
+    _data = NULL;
+    _size = 0;
+}
+
+bool MappedFile::replace(const string& fileName, const string& data)
+{
+    string tmpName = fileName + ".tmp." +
+                boost::lexical_cast<string>(::getpid());
+    std::ofstream out(tmpName.c_str(), std::ios::binary);
+    out.write(data.data(), data.size());
+    out.close();
+
+    if(!out || std::rename(tmpName.c_str(), fileName.c_str()) != 0) {
+        std::remove(tmpName.c_str());
+        return false;
+    }
+    return true;
+}
+
+const string* WordCache::find(const string& word)
+{
+    Index::iterator it = _index.find(word);
+    if(it == _index.end()) {
+        ++_misses;
+        return NULL;
+    }
+    ++_hits;
+    _entries.splice(_entries.begin(), _entries, it->second);
+    return &it->second->second;
+}
+
+void WordCache::insert(const string& word, const string& value)
+{
+    if(_maxSize == 0) return;
+    Index::iterator it = _index.find(word);
+    if(it != _index.end()) {
+        it->second->second = value;
+        _entries.splice(_entries.begin(), _entries, it->second);
+        return;
+    }
+    _entries.push_front(std::make_pair(word, value));
+    _index.insert(std::make_pair(word, _entries.begin()));
+    shrink();
+}
+
+void WordCache::shrink()
+{
+    while(_index.size() > _maxSize) {
+        _index.erase(_entries.back().first);
+        _entries.pop_back();
+    }
+}
+
+// Compiled layout: Header, Lengths[abbrMaxLen], Slot[slotCount],
+// string pool. Slots form an open addressing hash table with linear
+// probing, slotCount is a power of two and empty slots have zero
+// length. Lengths[n] is the fingerprint of the words of at most n+1
+// characters, so that it never needs to be computed at load time.
+struct WordsDict::Header
+{
+    char            magic[8];
+    boost::uint32_t version;
+    boost::uint32_t abbrMaxLen;
+    boost::uint32_t wordCount;
+    boost::uint32_t slotCount;
+    boost::uint64_t stringsSize;
+    boost::uint64_t wordsHash;
+};
+
+struct WordsDict::Lengths
+{
+    boost::uint32_t wordCount;
+    boost::uint32_t reserved;
+    boost::uint64_t wordsHash;
+};
+
+struct WordsDict::Slot
+{
+    boost::uint32_t hash;
+    boost::uint32_t offset;
+    boost::uint32_t length;
+};
+
+WordsDict::WordsDict(const string& filename, size_t abbrMaxLen)
+    : _abbrMaxLen(abbrMaxLen), _header(NULL), _lengths(NULL), _slots(NULL),
+      _strings(NULL)
+{
+    if(_file.open(filename, WORDSDICT_MAGIC, sizeof(WORDSDICT_MAGIC))) {
+        // A compiled dictionary is never reread as a word list
+        if(_file.size() < sizeof(Header)) {
+            _error = "truncated compiled dictionary";
+        } else {
+            const Header* header =
+                    reinterpret_cast<const Header*>(_file.data());
+            boost::uint64_t expected = sizeof(Header) +
+                    boost::uint64_t(header->abbrMaxLen) * sizeof(Lengths) +
+                    boost::uint64_t(header->slotCount) * sizeof(Slot) +
+                    header->stringsSize;
+            const Lengths* lengths = reinterpret_cast<const Lengths*>(
+                                    _file.data() + sizeof(Header));
+
+            if(header->version != WORDSDICT_VERSION) {
+                _error = "unsupported compiled dictionary version";
+            } else if(expected != _file.size() || header->slotCount == 0 ||
+                    (header->slotCount & (header->slotCount - 1)) != 0 ||
+                    (header->abbrMaxLen > 0 &&
+                     (lengths[header->abbrMaxLen-1].wordCount !=
+                                                header->wordCount ||
+                      lengths[header->abbrMaxLen-1].wordsHash !=
+                                                header->wordsHash))) {
+                _error = "corrupt compiled dictionary";
+            } else if(header->abbrMaxLen < abbrMaxLen) {
+                _error = "dictionary compiled with abbrMaxLen " +
+                    boost::lexical_cast<string>(header->abbrMaxLen) +
+                    ", at least " + boost::lexical_cast<string>(abbrMaxLen) +
+                    " is needed";
+            } else {
+                _header = header;
+                _lengths = lengths;
+                _slots = reinterpret_cast<const Slot*>(
+                                    lengths + header->abbrMaxLen);
+                _strings = reinterpret_cast<const char*>(
+                                    _slots + header->slotCount);
+                return;
+            }
+        }
+        _error = filename + ": " + _error;
+        _file.close();
+        return;
+    }
+
+    std::ifstream wordsfile(filename.c_str());
+    string word;
+    while(wordsfile.good()) {
+        std::getline(wordsfile, word);
+        if(acceptWord(word, abbrMaxLen)) {
+            _words.insert(word);
+        }
+    }
+}
+
+bool WordsDict::lookup(const string& word) const
+{
+    boost::uint32_t h = hashWord(word.data(), word.size());
+    boost::uint32_t mask = _header->slotCount - 1;
+    boost::uint32_t n = h & mask;
+    for(boost::uint32_t probes = 0; probes <= mask; ++probes) {
+        const Slot& slot = _slots[n];
+        if(slot.length == 0)
+            return false;
+        if(slot.hash == h && slot.length == word.size() &&
+                boost::uint64_t(slot.offset) + slot.length <=
+                                            _header->stringsSize &&
+                std::memcmp(_strings + slot.offset,
+                            word.data(), slot.length) == 0)
+            return true;
+        n = (n + 1) & mask;
+    }
+    return false;
+}
+
+WordsFingerprint WordsDict::fingerprint() const
+{
+    WordsFingerprint result;
+    result.abbrMaxLen = _abbrMaxLen;
+
+    // Compiled words are summed up in the file, only words added with
+    // insert() are left
+    if(_header && _abbrMaxLen > 0) {
+        result.wordCount = _lengths[_abbrMaxLen-1].wordCount;
+        result.hash = _lengths[_abbrMaxLen-1].wordsHash;
+    }
+
+    // Words longer than abbrMaxLen are never looked up
+    std::tr1::unordered_set<string>::const_iterator end = _words.end();
+    for(std::tr1::unordered_set<string>::const_iterator it = _words.begin();
+                                                    it != end; ++it) {
+        if(it->size() > _abbrMaxLen || (_header && lookup(*it)))
+            continue;
+        ++result.wordCount;
+        result.hash += mixHash(hashWord(it->data(), it->size()));
+    }
+    return result;
+}
+
+bool WordsDict::compile(const string& filename, const string& outFilename,
+                        size_t abbrMaxLen)
+{
+    std::ifstream wordsfile(filename.c_str());
+    if(!wordsfile.good())
+        return false;
+
+    std::set<string> words;
+    string word;
+    while(wordsfile.good()) {
+        std::getline(wordsfile, word);
+        if(acceptWord(word, abbrMaxLen)) {
+            words.insert(word);
+        }
+    }
+
+    boost::uint32_t slotCount = 1;
+    while(slotCount < 2*words.size()) slotCount <<= 1;
+
+    std::vector<Slot> slots(slotCount, Slot());
+    std::vector<Lengths> lengths(abbrMaxLen + 1, Lengths());
+    string strings;
+
+    for(std::set<string>::const_iterator it = words.begin();
+                                it != words.end(); ++it) {
+        boost::uint32_t h = hashWord(it->data(), it->size());
+        ++lengths[it->size()].wordCount;
+        lengths[it->size()].wordsHash += mixHash(h);
+
+        boost::uint32_t n = h & (slotCount - 1);
+        while(slots[n].length != 0)
+            n = (n + 1) & (slotCount - 1);
+        slots[n].hash = h;
+        slots[n].offset = strings.size();
+        slots[n].length = it->size();
+        strings += *it;
+    }
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, WORDSDICT_MAGIC, sizeof(WORDSDICT_MAGIC));
+    header.version = WORDSDICT_VERSION;
+    header.abbrMaxLen = abbrMaxLen;
+    header.wordCount = words.size();
+    header.slotCount = slotCount;
+    header.stringsSize = strings.size();
+
+    // lengths[n] holds the words of n characters until here, and those
+    // of at most n characters after it
+    for(size_t n = 1; n <= abbrMaxLen; ++n) {
+        lengths[n].wordCount += lengths[n-1].wordCount;
+        lengths[n].wordsHash += lengths[n-1].wordsHash;
+    }
+    header.wordsHash = lengths[abbrMaxLen].wordsHash;
+
+    string data(reinterpret_cast<const char*>(&header), sizeof(header));
+    data.append(reinterpret_cast<const char*>(&lengths[0] + 1),
+                                    abbrMaxLen * sizeof(Lengths));
+    data.append(reinterpret_cast<const char*>(&slots[0]),
+                                    slotCount * sizeof(Slot));
+    data += strings;
+    return MappedFile::replace(outFilename, data);
+}
+
+string normLiteral(const string& literal,
+                   const WordsDict* wordsDict, const Stemmer* stemmer)
+{
+    LiteralNormalizer normalizer(wordsDict, stemmer);
+    normalizer.append(literal);
+    return normalizer.normalized() + normalizer.tail();
+}
+
+void LiteralNormalizer::clear()
+{
+    _text.clear();
+    _normalized.clear();
+    _state = State();
+}
+
+void LiteralNormalizer::append(const char* text, size_t size)
+{
+    _text.append(text, size);
+    run(_state, _normalized, false);
+}
+
+string LiteralNormalizer::tail() const
+{
+    string result;
+    State state(_state);
+    run(state, result, true);
+    return result;
+}
+
+void LiteralNormalizer::run(State& state, string& nliteral, bool final) const
+{
+    /* TODO: support arbitrary stemmers and wordDicts */
+    /* TODO: unicode and locales */
+    const string& literal = _text;
+    size_t s = literal.size();
+    size_t& n = state.n;
+    size_t& wordStart = state.wordStart;
+    size_t& lastDot = state.lastDot;
+
+    /* TODO: handle 's */
+    for(; ; ++n) {
+        // Wait for the rest of the text unless it ends here
+        if(!final && (n >= s || (literal[n] == '\'' && n+2 >= s)))
+            return;
+
+        char ch = n < s ? literal[n] : 0;
+
+        if(wordStart < n) { // inside a word
+            if(_islower(ch) || _isupper(ch) || std::isdigit(ch)) {
+                // add to current word
+            } else if(ch == '.') {
+                // add to current word but remember the dot position
+                lastDot = n;
+            } else { // end of the word
+
+                // re-read current char next time
+                --n;
+                
+                // check for the dot
+                if(lastDot < n) {
+                    // dot is present but not the last char
+                    n = lastDot;
+                }
+
+                // extract the word
+                size_t wordSize = n + 1 - wordStart;
+                std::string word(literal, wordStart, wordSize);
+
+                // reset the word
+                wordStart = lastDot = string::npos;
+
+                if(n+1 < s && _isIgnoredWord(word)) {
+                    // Skip articles, but not at the end
+                    continue;
+                }
+
+                // process the word
+                const string* nword = _cache->find(word);
+                if(nword) {
+                    nliteral += *nword;
+                } else {
+                    string value = normWord(word);
+                    _cache->insert(word, value);
+                    nliteral += value;
+                }
+            }
+        } else { // not inside a word
+            if(_isIgnored(ch)) {
+                continue; // ignore these chars
+            } else if(_islower(ch) || _isupper(ch) || std::isdigit(ch)) {
+                wordStart = n;
+            } else if(ch == '\'' && n+1 < s && (literal[n+1] == 's') &&
+                    n != 0 && (_islower(literal[n-1]) ||
+                               _isupper(literal[n-1]))) {
+                if(n+2==s) break;
+                char ch2 = literal[n+2];
+                if(_islower(ch2) || _isupper(ch2) || std::isdigit(ch2)
+                                                    || ch2 == '.')
+                    nliteral += literal[n];
+                else
+                    ++n;
+            } else if(n >= s) {
+                break;
+            } else {
+                nliteral += literal[n]; // use character as-is
+            }
+        }
+    }
+}
+
+// Normalizes a single word. A dot may only be its last character.
+string LiteralNormalizer::normWord(string word) const
+{
+    // lower the word
+    bool isAbbr = false;
+    size_t lastUpper = string::npos;
+    size_t firstLower = string::npos;
+    size_t wordSize = word.size();
+    bool hasDot = wordSize && word[wordSize-1] == '.';
+    std::string word1(word);
+
+    for(size_t k = 0; k < wordSize; ++k) {
+        if(_isupper(word1[k])) {
+            word1[k] += ('a' - 'A');
+            lastUpper = k;
+            if(k != 0) isAbbr = true;
+        } else if(_islower(word1[k])) {
+            if(firstLower > k) firstLower = k;
+        } else { // digit or dot
+            isAbbr = true;
+        }
+    }
+
+    // check for abbr in dictionary
+    if(!isAbbr && wordSize <= _wordsDict->abbrMaxLen()) {
+        isAbbr = !_wordsDict->contains(word);
+        if(isAbbr && lastUpper == 0)
+            isAbbr = !_wordsDict->contains(word1);
+    }
+
+    if(!isAbbr)
+        return _stemmer->stem(word1);
+
+    string nword;
+    if(!hasDot) {
+        // Stem plural forms for uppercase abbrevations
+        if(wordSize > 2 && firstLower == wordSize-2 &&
+                word[wordSize-2] == 'e' &&
+                word[wordSize-1] == 's') {
+            --wordSize; --wordSize;
+            word.resize(wordSize);
+        } else if(wordSize > 1 && firstLower == wordSize-1 &&
+                word[wordSize-1] == 's') {
+            word.resize(--wordSize);
+        }
+        nword.resize(2*wordSize);
+        for(size_t k=0; k<wordSize; ++k) {
+            nword[k<<1] = _islower(word[k]) ?
+                                word[k] - ('a' - 'A') : word[k];
+            nword[(k<<1) + 1] = '.';
+        }
+    } else {
+        nword.resize(wordSize);
+        for(size_t k=0; k<wordSize; ++k) {
+            nword[k] = _islower(word[k]) ?
+                                word[k] - ('a' - 'A') : word[k];
+        }
+    }
+    return nword;
+}
+
+string lowerLiteral(string literal)
+{
+    for(size_t i = 0; i < literal.size(); ++i)
+        if(_isupper(literal[i])) literal[i] -= 'A'-'a';
+    return literal;
+}
+
+string absolutePath(const string& str, const string& workdir)
+{
+    using boost::filesystem::path;
+    path p = path(str);
+    if(!p.is_complete()) {
+        if(!workdir.empty()) {
+            path w = path(workdir);
+            if(!w.is_complete()) 
+                w = boost::filesystem::current_path() / w;
+            p = w / p;
+        } else {
+            p = boost::filesystem::current_path() / p;
+        }
+    }
+
+    string result = p.normalize().string(); 
+    if(result.size() > 2 && 0==result.compare(result.size()-2, 2, "/."))
+        result.resize(result.size()-2);
+    return result;
+}
+
+bool isLocalFile(const string& str, const string& workdir)
+{
+    string aWorkdir = absolutePath(workdir, string());
+    return absolutePath(str, aWorkdir)
+            .compare(0, aWorkdir.size(), aWorkdir) == 0;
+}
+
+string TextTag::repr() const
+{
+    static const char* types[] = {
+        "OTHER", "WORD", "CHARACTER", "LITERAL"
+    };
+    std::ostringstream out;
+    out << "TextTag("
+        << (type <= TT_LITERAL && type >= 0 ? types[type] : "UNKNOWN")
+        << ", " << start << ", " << end << ", \"" << value << "\")";
+    return out.str();
+}
+
+string textTagListRepr(const TextTagList& list)
+{
+    std::ostringstream out;
+    out << "TextTagList(";
+    TextTagList::const_iterator e = list.end();
+    for(TextTagList::const_iterator it = list.begin(); it != e; ++it) {
+        if(it != list.begin())
+            out << ", ";
+        out << it->repr();
+    }
+    out << ")";
+    return out.str();
+}
+
+string encodeTextTags(const TextTagList& tags)
+{
+    std::tr1::unordered_map<string, size_t> ids;
+    std::vector<const string*> values;
+    std::vector<size_t> tagValues;
+    tagValues.reserve(tags.size());
+    for(TextTagList::const_iterator it = tags.begin(), e = tags.end();
+                            it != e; ++it) {
+        std::pair<std::tr1::unordered_map<string, size_t>::iterator, bool>
+            r = ids.insert(std::make_pair(it->value, values.size()));
+        if(r.second) values.push_back(&r.first->first);
+        tagValues.push_back(r.first->second);
+    }
+
+    string out(TEXT_TAGS_MAGIC, sizeof(TEXT_TAGS_MAGIC));
+    putVarint(out, values.size());
+    for(size_t n = 0; n < values.size(); ++n) {
+        putVarint(out, values[n]->size());
+        out += *values[n];
+    }
+
+    putVarint(out, tags.size());
+    boost::uint64_t prevEnd = 0;
+    for(size_t n = 0; n < tags.size(); ++n) {
+        const TextTag& tag = tags[n];
+        putVarint(out, boost::uint64_t(tag.type));
+        putVarint(out, zigzag(boost::uint64_t(tag.start) - prevEnd));
+        putVarint(out, zigzag(boost::uint64_t(tag.end) - tag.start));
+        putVarint(out, tagValues[n]);
+        prevEnd = tag.end;
+    }
+    return out;
+}
+
+bool decodeTextTags(const char* data, size_t size, TextTagList& tags)
+{
+    tags.clear();
+    const char* p = data;
+    const char* end = data + size;
+    if(size < sizeof(TEXT_TAGS_MAGIC) || std::memcmp(data,
+                    TEXT_TAGS_MAGIC, sizeof(TEXT_TAGS_MAGIC)) != 0)
+        return false;
+    p += sizeof(TEXT_TAGS_MAGIC);
+
+    boost::uint64_t count, length;
+    if(!getVarint(p, end, count) || count > size_t(end - p))
+        return false;
+    std::vector<string> values(count);
+    for(size_t n = 0; n < count; ++n) {
+        if(!getVarint(p, end, length) || length > size_t(end - p))
+            return false;
+        values[n].assign(p, length);
+        p += length;
+    }
+
+    // Every tag takes at least four bytes
+    if(!getVarint(p, end, count) || count > size_t(end - p) / 4)
+        return false;
+    tags.reserve(count);
+    boost::uint64_t prevEnd = 0;
+    for(size_t n = 0; n < count; ++n) {
+        boost::uint64_t type, start, len, value;
+        if(!getVarint(p, end, type) || type > TextTag::TT_LITERAL ||
+                !getVarint(p, end, start) || !getVarint(p, end, len) ||
+                !getVarint(p, end, value) || value >= values.size()) {
+            tags.clear();
+            return false;
+        }
+        start = prevEnd + unzigzag(start);
+        prevEnd = start + unzigzag(len);
+        tags.push_back(TextTag(int(type), size_t(start), size_t(prevEnd),
+                               values[value]));
+    }
+
+    if(p != end) {
+        tags.clear();
+        return false;
+    }
+    return true;
+}
+
+TextTagColumns::TextTagColumns(const TextTagList& tags)
+{
+    clear();
+    _types.reserve(tags.size());
+    _starts.reserve(tags.size());
+    _ends.reserve(tags.size());
+    _valueOffsets.reserve(tags.size() + 1);
+    for(TextTagList::const_iterator it = tags.begin(), e = tags.end();
+                            it != e; ++it)
+        push_back(*it);
+}
+
+void TextTagColumns::clear()
+{
+    _types.clear();
+    _starts.clear();
+    _ends.clear();
+    _valueOffsets.clear();
+    _valuePool.clear();
+    _valueOffsets.push_back(0);
+}
+
+void TextTagColumns::swap(TextTagColumns& other)
+{
+    _types.swap(other._types);
+    _starts.swap(other._starts);
+    _ends.swap(other._ends);
+    _valueOffsets.swap(other._valueOffsets);
+    _valuePool.swap(other._valuePool);
+}
+
+void TextTagColumns::push_back(int type, size_t start, size_t end,
+                               const char* value, size_t valueSize)
+{
+    _types.push_back(Type(type));
+    _starts.push_back(Offset(start));
+    _ends.push_back(Offset(end));
+    _valuePool.append(value, valueSize);
+    _valueOffsets.push_back(Offset(_valuePool.size()));
+}
+
+TextTagList TextTagColumns::tags() const
+{
+    TextTagList result;
+    result.reserve(size());
+    for(size_t n = 0; n < size(); ++n)
+        result.push_back(tag(n));
+    return result;
+}
+
+const LiteralTrie::Index LiteralTrie::ROOT;
+const LiteralTrie::Index LiteralTrie::NONE;
+
+// Compiled layout: Header, Edge[edgeSlots], char terminal[nodeCount]
+struct LiteralTrie::Header
+{
+    char            magic[8];
+    boost::uint32_t version;
+    boost::uint32_t literalCount;
+    boost::uint32_t nodeCount;
+    boost::uint32_t edgeSlots;
+    boost::uint32_t edgeCount;
+    boost::uint32_t abbrMaxLen;     // WordsFingerprint of the dictionary
+    boost::uint32_t wordCount;      // the literals are normalized with
+    boost::uint32_t reserved;
+    boost::uint64_t wordsHash;
+};
+
+void LiteralTrie::clear()
+{
+    _file.close();
+    _ownEdges.assign(16, Edge());
+    _ownTerminal.assign(1, false);
+    _edgeCount = 0;
+    _size = 0;
+    attach();
+}
+
+void LiteralTrie::attach()
+{
+    _edges = &_ownEdges[0];
+    _edgeMask = _ownEdges.size() - 1;
+    _terminal = &_ownTerminal[0];
+    _nodeCount = _ownTerminal.size();
+}
+
+void LiteralTrie::detach()
+{
+    if(!_file.data()) return;
+    _ownEdges.assign(_edges, _edges + _edgeMask + 1);
+    _ownTerminal.assign(_terminal, _terminal + _nodeCount);
+    _file.close();
+    attach();
+}
+
+void LiteralTrie::rehash(size_t slots)
+{
+    std::vector<Edge> edges(slots, Edge());
+    _edgeMask = slots - 1;
+    for(size_t n = 0; n < _ownEdges.size(); ++n) {
+        const Edge& edge = _ownEdges[n];
+        if(edge.child == ROOT) continue;
+        size_t i = slot(edge.key);
+        while(edges[i].child != ROOT)
+            i = (i + 1) & _edgeMask;
+        edges[i] = edge;
+    }
+    _ownEdges.swap(edges);
+    attach();
+}
+
+void LiteralTrie::insert(const string& literal)
+{
+    detach();
+
+    Index node = ROOT;
+    for(size_t n = 0; n < literal.size(); ++n) {
+        Index child = step(node, literal[n]);
+        if(child == NONE) {
+            // Keep the table at most half full
+            if(2*(_edgeCount + 1) > _ownEdges.size())
+                rehash(2*_ownEdges.size());
+
+            child = Index(_ownTerminal.size());
+            _ownTerminal.push_back(false);
+
+            Edge edge;
+            edge.key = edgeKey(node, literal[n]);
+            edge.child = child;
+            edge.reserved = 0;
+
+            size_t i = slot(edge.key);
+            while(_ownEdges[i].child != ROOT)
+                i = (i + 1) & _edgeMask;
+            _ownEdges[i] = edge;
+            ++_edgeCount;
+            attach();
+        }
+        node = child;
+    }
+
+    if(!_ownTerminal[node]) {
+        _ownTerminal[node] = true;
+        ++_size;
+    }
+}
+
+LiteralTrie::Index LiteralTrie::step(Index node, char ch) const
+{
+    if(node == NONE) return NONE;
+    boost::uint64_t key = edgeKey(node, ch);
+    size_t i = slot(key);
+    for(size_t probes = 0; probes <= _edgeMask; ++probes) {
+        const Edge& edge = _edges[i];
+        if(edge.child == ROOT || edge.child >= _nodeCount)
+            return NONE;
+        if(edge.key == key)
+            return edge.child;
+        i = (i + 1) & _edgeMask;
+    }
+    return NONE;
+}
+
+bool LiteralTrie::save(const string& fileName,
+                       const WordsFingerprint& words) const
+{
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, LITERALS_MAGIC, sizeof(LITERALS_MAGIC));
+    header.version = LITERALS_VERSION;
+    header.literalCount = _size;
+    header.nodeCount = _nodeCount;
+    header.edgeSlots = _edgeMask + 1;
+    header.edgeCount = _edgeCount;
+    header.abbrMaxLen = words.abbrMaxLen;
+    header.wordCount = words.wordCount;
+    header.wordsHash = words.hash;
+
+    string data(reinterpret_cast<const char*>(&header), sizeof(header));
+    data.append(reinterpret_cast<const char*>(_edges),
+                                (_edgeMask + 1) * sizeof(Edge));
+    data.append(_terminal, _nodeCount);
+    return MappedFile::replace(fileName, data);
+}
+
+bool LiteralTrie::load(const string& fileName,
+                       const WordsFingerprint& words, string* error)
+{
+    MappedFile file;
+    if(!file.open(fileName, LITERALS_MAGIC, sizeof(LITERALS_MAGIC)))
+        return false;
+
+    string reason;
+    const Header* header = reinterpret_cast<const Header*>(file.data());
+    if(file.size() < sizeof(Header)) {
+        reason = "truncated literal index";
+    } else if(header->version != LITERALS_VERSION) {
+        reason = "unsupported literal index version";
+    } else if(sizeof(Header) + boost::uint64_t(header->edgeSlots) *
+                    sizeof(Edge) + header->nodeCount != file.size() ||
+            header->nodeCount == 0 || header->edgeSlots == 0 ||
+            (header->edgeSlots & (header->edgeSlots - 1)) != 0 ||
+            header->edgeCount >= header->edgeSlots) {
+        reason = "corrupt literal index";
+    } else if(header->abbrMaxLen != words.abbrMaxLen ||
+            header->wordCount != words.wordCount ||
+            header->wordsHash != words.hash) {
+        reason = "literal index compiled with a different words "
+                 "dictionary or abbrMaxLen";
+    }
+
+    if(!reason.empty()) {
+        if(error) *error = fileName + ": " + reason;
+        return false;
+    }
+
+    _ownEdges.clear();
+    _ownTerminal.clear();
+
+    _edges = reinterpret_cast<const Edge*>(file.data() + sizeof(Header));
+    _edgeMask = header->edgeSlots - 1;
+    _edgeCount = header->edgeCount;
+    _terminal = reinterpret_cast<const char*>(_edges + header->edgeSlots);
+    _nodeCount = header->nodeCount;
+    _size = header->literalCount;
+
+    _file.swap(file);
+    return true;
+}
+
+bool LiteralMatcher::load(const string& fileName)
+{
+    _error.clear();
+    return _literals.load(fileName, _wordsDict ?
+                _wordsDict->fingerprint() : WordsFingerprint(), &_error);
+}
+
+bool LiteralMatcher::save(const string& fileName) const
+{
+    return _literals.save(fileName, _wordsDict ?
+                _wordsDict->fingerprint() : WordsFingerprint());
+}
+
+TextTagList LiteralMatcher::find(const TextTagList& tags,
+                                 size_t maxChars, WordCache* cache) const
+{
+    return _find(TextTagListView(tags), maxChars, cache);
+}
+
+TextTagList LiteralMatcher::find(const TextTagColumns& tags,
+                                 size_t maxChars, WordCache* cache) const
+{
+    return _find(tags, maxChars, cache);
+}
+
+template<class Tags>
+TextTagList LiteralMatcher::_find(const Tags& tags,
+                                  size_t maxChars, WordCache* cache) const
+{
+    typedef LiteralTrie::Index Index;
+    TextTagList result;
+    LiteralNormalizer normalizer(_wordsDict, _stemmer, cache);
+
+    // Process the text
+    size_t count = tags.size();
+    for(size_t n = 0; n < count; ++n) {
+        if(tags.type(n) == TextTag::TT_CHARACTER) {
+            // Do not start from ignored character
+            if(_isIgnored(firstChar(tags, n))) continue;
+        } else if(tags.type(n) != TextTag::TT_WORD) {
+            // Ignore unknown tags
+            continue;
+        }
+
+        // If previous tag is character and is adjacent,
+        // then it should be a space
+        if(n && tags.end(n-1) == tags.start(n) &&
+                tags.type(n-1) == TextTag::TT_CHARACTER &&
+                _isglue(firstChar(tags, n-1))) {
+            continue;
+        }
+
+        // Do not start on an article
+        if(_isIgnoredWord(tags.valueData(n), tags.valueSize(n))) {
+            continue;
+        }
+
+        normalizer.clear();
+        Index node = LiteralTrie::ROOT;
+        Index wnode = _whiteList.size() ? Index(LiteralTrie::ROOT)
+                                        : Index(LiteralTrie::NONE);
+        size_t walked = 0;
+
+        size_t pos = tags.start(n);
+        bool found = false;
+        string foundLiteral;
+        size_t foundEnd = 0, foundK = 0;
+
+        for(size_t k = n; k < count; ++k) {
+            // Stop if tag is not adjacent
+            if(tags.start(k) != pos) {
+                break;
+            }
+            pos = tags.end(k);
+
+            const char* value = tags.valueData(k);
+            size_t valueSize = tags.valueSize(k);
+            normalizer.append(value, valueSize);
+            node = _literals.walk(node, normalizer.normalized(), walked);
+            walked = normalizer.normalized().size();
+            for(size_t i = 0; i < valueSize; ++i) {
+                char ch = value[i];
+                if(_isupper(ch)) ch -= 'A'-'a';
+                wnode = _whiteList.step(wnode, ch);
+            }
+
+            // Stop if no literal starts with the text
+            if(node == LiteralTrie::NONE && wnode == LiteralTrie::NONE) {
+                break;
+            }
+
+            if(tags.type(k) == TextTag::TT_CHARACTER) {
+                // Skip ignored characters
+                if(_isIgnored(firstChar(tags, k))) continue;
+            } else if(tags.type(k) != TextTag::TT_WORD) {
+                // Stop on unknown tags
+                break;
+            }
+
+            // If next tag is character and is adjacent,
+            // then it should be a space
+            if(k+1 < count && tags.start(k+1) == tags.end(k) &&
+                    tags.type(k+1) == TextTag::TT_CHARACTER &&
+                    _isglue(firstChar(tags, k+1))) {
+                continue;
+            }
+
+            // Norm literal and lookup in the trie
+            const string& text = normalizer.text();
+            string literal;
+            if(_whiteList.terminal(wnode)) {
+                if(!_literals.contains(text)) continue;
+                literal = text;
+            } else {
+                string tail = normalizer.tail();
+                if(!_literals.terminal(_literals.walk(node, tail))) continue;
+                literal = normalizer.normalized() + tail;
+            }
+
+            if(maxChars && literal.size() > maxChars) {
+                continue;
+            }
+
+            // Skip known non-literal words
+            if((!_notLiterals.count(text)) &&
+                    (k+1>=count ||
+                     tags.type(k+1) != TextTag::TT_CHARACTER ||
+                     firstChar(tags, k+1) != '.' ||
+                     !_notLiterals.count(text+'.'))) {
+                found = true;
+                foundLiteral = literal;
+                foundEnd = tags.end(k);
+                foundK = k;
+            }
+        }
+
+        if(found) { // XXX: return all found literals !
+            // Create a tag for the longest literal found
+            result.push_back(TextTag(TextTag::TT_LITERAL, tags.start(n),
+                                foundEnd, foundLiteral));
+            n = foundK;
+        }
+    }
+
+    return result;
+}
+
+bool LiteralMatcher::loadConcepts(const string& conceptsFile)
+{
+    std::ifstream concepts(conceptsFile.c_str());
+    if(!concepts.good())
+        return false;
+
+    string line;
+    while(std::getline(concepts, line)) {
+        size_t b = line.find_first_not_of(" \n\r");
+        size_t e = line.find_last_not_of(" \n\r");
+        if(b == string::npos) continue;
+        line = lowerLiteral(line.substr(b, e + 1 - b));
+
+        // Unescape the characters escaped in concept files
+        string concept;
+        for(size_t n = 0; n < line.size(); ++n) {
+            if(line[n] == '\\' && n+1 < line.size() && (line[n+1] == '-' ||
+                            line[n+1] == '(' || line[n+1] == ')'))
+                ++n;
+            concept += line[n];
+        }
+
+        insert(normLiteral(concept, _wordsDict, _stemmer));
+    }
+
+    return true;
+}
+
+bool compileConcepts(const string& conceptsFile, const string& outFile,
+                     const WordsDict* wordsDict, const Stemmer* stemmer)
+{
+    LiteralMatcher matcher(wordsDict, stemmer);
+    return matcher.loadConcepts(conceptsFile) && matcher.save(outFile);
+}
+
+string replaceLiterals(const string& source,
+                    const TextTagList& tags)
+{
+    string result;
+    result.reserve(source.size() + source.size()/5);
+    size_t pos = 0;
+    TextTagList::const_iterator end = tags.end();
+    for(TextTagList::const_iterator it = tags.begin(); it != end; ++it) {
+        if(it->type == TextTag::TT_LITERAL) {
+            result.append(source, pos, it->start - pos);
+            result += it->value;
+            pos = it->end;
+        }
+    }
+    result.append(source, pos, string::npos);
+    return result;
+}
+
+ReplacementTemplate::ReplacementTemplate(const string& pattern)
+    : _pattern(pattern)
+{
+    string str;
+    for(size_t n = 0; n < pattern.size(); ++n) {
+        char ch = pattern[n];
+        if(ch == '%' && n+1 < pattern.size()) {
+            char next = pattern[n+1];
+            if(next == 'l' || next == 't') {
+                if(!str.empty())
+                    _parts.push_back(Part(PART_STRING, str));
+                str.clear();
+                _parts.push_back(Part(next == 'l' ? PART_LITERAL : PART_TEXT));
+                ++n;
+                continue;
+            } else if(next == '%') {
+                ++n;
+            }
+        }
+        str += ch;
+    }
+    if(!str.empty())
+        _parts.push_back(Part(PART_STRING, str));
+}
+
+size_t ReplacementTemplate::write(std::ostream& out, const string& literal,
+                                  const char* text, size_t textSize) const
+{
+    size_t size = 0;
+    for(std::vector<Part>::const_iterator it = _parts.begin(),
+                        e = _parts.end(); it != e; ++it) {
+        switch(it->type) {
+            case PART_STRING:
+                out.write(it->str.data(), it->str.size());
+                size += it->str.size();
+                break;
+            case PART_LITERAL:
+                out.write(literal.data(), literal.size());
+                size += literal.size();
+                break;
+            case PART_TEXT:
+                out.write(text, textSize);
+                size += textSize;
+                break;
+        }
+    }
+    return size;
+}
+
+string ReplacementTemplate::expand(const string& literal,
+                                   const string& text) const
+{
+    std::ostringstream out;
+    write(out, literal, text.data(), text.size());
+    return out.str();
+}
+
+size_t writeReplacedLiterals(std::ostream& out,
+                const char* source, size_t size,
+                const TextTagList& tags, const ReplacementTemplate& tmpl)
+{
+    size_t written = 0;
+    size_t pos = 0;
+    TextTagList::const_iterator end = tags.end();
+    for(TextTagList::const_iterator it = tags.begin(); it != end; ++it) {
+        if(it->type != TextTag::TT_LITERAL || it->start < pos ||
+                it->end < it->start || it->end > size)
+            continue;
+        out.write(source + pos, it->start - pos);
+        written += it->start - pos;
+        written += tmpl.write(out, it->value, source + it->start,
+                              it->end - it->start);
+        pos = it->end;
+    }
+    out.write(source + pos, size - pos);
+    written += size - pos;
+    return written;
+}
+
+} // namespace hrefkeywords
+
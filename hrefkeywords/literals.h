@@ -0,0 +1,533 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#ifndef __HREFKEYWORDS_LITERALS_H
+#define __HREFKEYWORDS_LITERALS_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <set>
+#include <algorithm>
+#include <ostream>
+#include <tr1/unordered_map>
+#include <tr1/unordered_set>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace hrefkeywords {
+
+using std::string;
+
+// Porter stemmer, may be shared between threads
+class Stemmer: boost::noncopyable
+{
+public:
+    string stem(string word) const;
+};
+
+// Read-only memory mapping of a file
+class MappedFile: boost::noncopyable
+{
+public:
+    MappedFile(): _data(NULL), _size(0) {}
+    ~MappedFile() { close(); }
+
+    // Maps the file if it starts with the given magic, any non-empty
+    // file if magicSize is 0
+    bool open(const string& fileName, const char* magic, size_t magicSize);
+    void close();
+
+    const char* data() const { return _data; }
+    size_t size() const { return _size; }
+
+    void swap(MappedFile& other) {
+        std::swap(_data, other._data);
+        std::swap(_size, other._size);
+    }
+
+    // Writes a new file and renames it into place, so that processes
+    // which have the old one mapped keep a consistent view
+    static bool replace(const string& fileName, const string& data);
+
+protected:
+    const char* _data;
+    size_t      _size;
+};
+
+// Bounded LRU cache of normalized words
+class WordCache
+{
+public:
+    explicit WordCache(size_t maxSize = 65536)
+        : _maxSize(maxSize), _hits(0), _misses(0) {}
+
+    // Returns the cached value or NULL
+    const string* find(const string& word);
+    void insert(const string& word, const string& value);
+
+    void clear() { _entries.clear(); _index.clear(); }
+    void resetStats() { _hits = _misses = 0; }
+
+    size_t size() const { return _index.size(); }
+    size_t maxSize() const { return _maxSize; }
+    void setMaxSize(size_t maxSize) { _maxSize = maxSize; shrink(); }
+
+    size_t hits() const { return _hits; }
+    size_t misses() const { return _misses; }
+
+protected:
+    typedef std::list<std::pair<string, string> > Entries;
+    typedef std::tr1::unordered_map<string, Entries::iterator> Index;
+
+    void shrink();
+
+    Entries _entries;
+    Index _index;
+    size_t _maxSize;
+    size_t _hits;
+    size_t _misses;
+};
+
+// Identifies what normalization takes from a WordsDict: its
+// abbrMaxLen and its words of at most that many characters
+struct WordsFingerprint
+{
+    WordsFingerprint(): abbrMaxLen(0), wordCount(0), hash(0) {}
+
+    bool operator==(const WordsFingerprint& other) const {
+        return abbrMaxLen == other.abbrMaxLen &&
+               wordCount == other.wordCount && hash == other.hash;
+    }
+    bool operator!=(const WordsFingerprint& other) const {
+        return !(*this == other);
+    }
+
+    boost::uint32_t abbrMaxLen;
+    boost::uint32_t wordCount;
+    boost::uint64_t hash;
+};
+
+// Dictionary of known words up to abbrMaxLen characters, used to tell
+// abbreviations from words. Loaded either from a plain word list, one
+// word per line, or from a compiled dictionary (see compile()) which
+// is memory mapped as is. Words added with insert() are kept aside.
+class WordsDict: boost::noncopyable
+{
+public:
+    WordsDict(const string& filename, size_t abbrMaxLen);
+
+    size_t abbrMaxLen() const { return _abbrMaxLen; }
+
+    void insert(const string& word) { _words.insert(word); _cache.clear(); }
+    bool contains(const string& word) const {
+        return _words.count(word) ||
+               (_header && word.size() <= _abbrMaxLen && lookup(word));
+    }
+
+    // True if the dictionary was loaded from a compiled file
+    bool compiled() const { return _header; }
+
+    // Read from the file for compiled dictionaries, plus the words
+    // added with insert(); takes time proportional to the dictionary
+    // size for plain word lists only
+    WordsFingerprint fingerprint() const;
+
+    // Why a compiled dictionary was rejected, in which case the
+    // dictionary is empty. Empty on success.
+    const string& error() const { return _error; }
+
+    // Writes a compiled dictionary of the words from a plain word list.
+    // It can be used with any abbrMaxLen up to the one it is compiled
+    // with, loading it with a larger one fails.
+    static bool compile(const string& filename, const string& outFilename,
+                        size_t abbrMaxLen);
+
+    // Normalized forms of words, which depend on the dictionary
+    WordCache& cache() const { return _cache; }
+
+    size_t cacheHits() const { return _cache.hits(); }
+    size_t cacheMisses() const { return _cache.misses(); }
+    size_t cacheSize() const { return _cache.size(); }
+    size_t cacheMaxSize() const { return _cache.maxSize(); }
+    void setCacheMaxSize(size_t maxSize) { _cache.setMaxSize(maxSize); }
+    void clearCache() { _cache.clear(); _cache.resetStats(); }
+
+protected:
+    struct Header;
+    struct Lengths;
+    struct Slot;
+
+    bool lookup(const string& word) const;
+
+    std::tr1::unordered_set<string> _words;
+    size_t _abbrMaxLen;
+    string _error;
+    mutable WordCache _cache;
+
+    MappedFile    _file;
+    const Header* _header;
+    const Lengths* _lengths;
+    const Slot*   _slots;
+    const char*   _strings;
+};
+
+// Normalizes a literal for dictionary lookups: abbreviations are
+// uppercased and dotted, other words are lowercased and stemmed,
+// articles and ignored characters are dropped.
+string normLiteral(const string& literal,
+                   const WordsDict* wordsDict, const Stemmer* stemmer);
+
+// Incremental form of normLiteral: the text may be appended piece by
+// piece and everything that does not depend on the rest of the text is
+// normalized only once. normalized() + tail() is always equal to the
+// normalization of the whole text appended so far.
+class LiteralNormalizer
+{
+public:
+    // Normalized words are cached in cache, or in the cache of
+    // wordsDict if it is NULL
+    LiteralNormalizer(const WordsDict* wordsDict, const Stemmer* stemmer,
+                      WordCache* cache = NULL)
+        : _wordsDict(wordsDict), _stemmer(stemmer),
+          _cache(cache ? cache : &wordsDict->cache()) { clear(); }
+
+    void clear();
+    void append(const string& text) { append(text.data(), text.size()); }
+    void append(const char* text, size_t size);
+
+    const string& text() const { return _text; }
+
+    // Normalized part of the text that can not change any more
+    const string& normalized() const { return _normalized; }
+
+    // Normalization of the rest of the text if it ends here
+    string tail() const;
+
+protected:
+    struct State {
+        State(): n(0), wordStart(string::npos), lastDot(string::npos) {}
+        size_t n;
+        size_t wordStart;
+        size_t lastDot;
+    };
+
+    void run(State& state, string& nliteral, bool final) const;
+    string normWord(string word) const;
+
+    const WordsDict* _wordsDict;
+    const Stemmer* _stemmer;
+    WordCache* _cache;
+
+    string _text;
+    string _normalized;
+    State _state;
+};
+
+string lowerLiteral(string literal);
+
+string absolutePath(const string& str, const string& workdir);
+bool isLocalFile(const string& str, const string& workdir);
+
+struct TextTag
+{
+    enum Type {
+        TT_OTHER = 0,
+        TT_WORD, TT_CHARACTER, TT_LITERAL
+    };
+
+    Type   type;
+    size_t start;
+    size_t end;
+    string value;
+
+    // XXX: boost::python does not support pickling of enums
+    explicit TextTag(int t = TT_OTHER, size_t s = 0, size_t e = 0,
+                            const string& val = string())
+        : type(Type(t)), start(s), end(e), value(val) {}
+
+    bool operator==(const TextTag& o) const {
+        return o.type == type && o.start == start &&
+               o.end == end && o.value == value;
+    }
+
+    bool operator!=(const TextTag& o) const {
+        return o.type != type || o.start != start ||
+               o.end != end || o.value != value;
+    }
+
+    string repr() const;
+};
+
+typedef std::vector<TextTag> TextTagList;
+
+string textTagListRepr(const TextTagList& list);
+
+// Compact binary form of a tag list, used to cache extraction results.
+// After the "TXPTAGS1" magic come the distinct tag values (count, then
+// size and bytes of each) and the tags (count, then for each tag its
+// type, start relative to the previous tag end, length and value
+// index). All numbers are varints, relative offsets are zigzag coded.
+string encodeTextTags(const TextTagList& tags);
+
+// Returns false and leaves tags empty if data is not a valid encoding
+bool decodeTextTags(const char* data, size_t size, TextTagList& tags);
+
+// Text tags stored column by column, one packed array per field. All
+// columns have one entry per tag except valueOffsets which has size()+1
+// entries: the value of tag i is valuePool[valueOffsets[i] ..
+// valueOffsets[i+1]). Offsets of tags without a source position are -1.
+class TextTagColumns
+{
+public:
+    typedef boost::int32_t Type;
+    typedef boost::int64_t Offset;
+
+    TextTagColumns() { clear(); }
+    explicit TextTagColumns(const TextTagList& tags);
+
+    void clear();
+    void swap(TextTagColumns& other);
+
+    void push_back(int type, size_t start, size_t end,
+                   const char* value, size_t valueSize);
+    void push_back(const TextTag& tag) {
+        push_back(tag.type, tag.start, tag.end,
+                  tag.value.data(), tag.value.size());
+    }
+
+    size_t size() const { return _types.size(); }
+    bool empty() const { return _types.empty(); }
+
+    int type(size_t n) const { return _types[n]; }
+    size_t start(size_t n) const { return size_t(_starts[n]); }
+    size_t end(size_t n) const { return size_t(_ends[n]); }
+    const char* valueData(size_t n) const {
+        return _valuePool.data() + _valueOffsets[n];
+    }
+    size_t valueSize(size_t n) const {
+        return size_t(_valueOffsets[n+1] - _valueOffsets[n]);
+    }
+    string value(size_t n) const {
+        return string(valueData(n), valueSize(n));
+    }
+
+    TextTag tag(size_t n) const {
+        return TextTag(type(n), start(n), end(n), value(n));
+    }
+    TextTagList tags() const;
+
+    // Columns
+    const std::vector<Type>& types() const { return _types; }
+    const std::vector<Offset>& starts() const { return _starts; }
+    const std::vector<Offset>& ends() const { return _ends; }
+    const std::vector<Offset>& valueOffsets() const { return _valueOffsets; }
+    const string& valuePool() const { return _valuePool; }
+
+protected:
+    std::vector<Type>   _types;
+    std::vector<Offset> _starts;
+    std::vector<Offset> _ends;
+    std::vector<Offset> _valueOffsets;
+    string              _valuePool;
+};
+
+// Character trie of literals. The trie is stored as an open addressing
+// table of edges, so that a compiled trie (see save()) can be memory
+// mapped and used as is. A mapped trie is copied on first insert().
+class LiteralTrie: boost::noncopyable
+{
+public:
+    typedef boost::uint32_t Index;
+    static const Index ROOT = 0;
+    static const Index NONE = Index(-1);
+
+    LiteralTrie() { clear(); }
+
+    void clear();
+    void insert(const string& literal);
+
+    Index step(Index node, char ch) const;
+
+    Index walk(Index node, const string& str, size_t from = 0) const {
+        for(size_t i = from; i < str.size() && node != NONE; ++i)
+            node = step(node, str[i]);
+        return node;
+    }
+
+    bool terminal(Index node) const {
+        return node != NONE && _terminal[node];
+    }
+
+    bool contains(const string& literal) const {
+        return terminal(walk(ROOT, literal));
+    }
+
+    size_t size() const { return _size; }
+
+    // Compiled tries, recording the words dictionary their literals
+    // were normalized with. Loading fails if the file is not a compiled
+    // trie. It also fails, setting error, if the file is damaged or was
+    // compiled with another dictionary.
+    bool save(const string& fileName,
+              const WordsFingerprint& words = WordsFingerprint()) const;
+    bool load(const string& fileName,
+              const WordsFingerprint& words = WordsFingerprint(),
+              string* error = NULL);
+    bool mapped() const { return _file.data(); }
+
+protected:
+    struct Header;
+
+    struct Edge {
+        boost::uint64_t key;
+        Index child; // ROOT for empty slots
+        Index reserved;
+    };
+
+    static boost::uint64_t edgeKey(Index node, char ch) {
+        return (boost::uint64_t(node) << 8) | (unsigned char)(ch);
+    }
+
+    size_t slot(boost::uint64_t key) const {
+        return size_t((key * 0x9E3779B97F4A7C15ULL) >> 32) & _edgeMask;
+    }
+
+    void detach();
+    void rehash(size_t slots);
+    void attach();
+
+    std::vector<Edge> _ownEdges;
+    std::vector<char> _ownTerminal;
+
+    const Edge* _edges;
+    size_t      _edgeMask;
+    size_t      _edgeCount;
+    const char* _terminal;
+    size_t      _nodeCount;
+    size_t      _size;
+
+    MappedFile  _file;
+};
+
+// Finds the longest literal at each position of a text in a single
+// pass. Literals are kept in a trie of their normalized forms and the
+// text is normalized incrementally while walking it, so no prefix is
+// normalized twice and the walk stops as soon as no literal can match.
+class LiteralMatcher: boost::noncopyable
+{
+public:
+    LiteralMatcher(const WordsDict* wordsDict, const Stemmer* stemmer)
+        : _wordsDict(wordsDict), _stemmer(stemmer) {}
+
+    void insert(const string& literal) { _literals.insert(literal); }
+    void insertNotLiteral(const string& text) { _notLiterals.insert(text); }
+    void insertWhiteListed(const string& text) {
+        _whiteList.insert(lowerLiteral(text));
+    }
+
+    bool contains(const string& literal) const {
+        return _literals.contains(literal);
+    }
+
+    size_t size() const { return _literals.size(); }
+
+    // Literal index written by save() or compileConcepts(). Returns
+    // false and keeps the current literals if the file is not an index
+    // or is a damaged index or one built with a different words
+    // dictionary or abbrMaxLen. error() tells the latter cases apart.
+    bool load(const string& fileName);
+    bool save(const string& fileName) const;
+    const string& error() const { return _error; }
+
+    // Inserts the literals of a concepts file, one concept per line
+    bool loadConcepts(const string& conceptsFile);
+
+    // Threads sharing the matcher should pass a cache of their own
+    TextTagList find(const TextTagList& tags, size_t maxChars = 0,
+                     WordCache* cache = NULL) const;
+    TextTagList find(const TextTagColumns& tags, size_t maxChars = 0,
+                     WordCache* cache = NULL) const;
+
+protected:
+    template<class Tags>
+    TextTagList _find(const Tags& tags, size_t maxChars,
+                      WordCache* cache) const;
+
+    const WordsDict* _wordsDict;
+    const Stemmer* _stemmer;
+
+    LiteralTrie _literals;
+    LiteralTrie _whiteList;
+    std::set<string> _notLiterals;
+
+    string _error;
+};
+
+// Compiles a concepts file, one concept per line, into a literal index
+bool compileConcepts(const string& conceptsFile, const string& outFile,
+                     const WordsDict* wordsDict, const Stemmer* stemmer);
+
+// Returns source with the span of each literal tag replaced by the tag
+// value. Tags must be sorted and must not overlap.
+string replaceLiterals(const string& source, const TextTagList& tags);
+
+// Replacement of a literal in the source text. In the pattern %l
+// stands for the literal, %t for the replaced text and %% for a single
+// percent sign, for example \href{%l}{%t}.
+class ReplacementTemplate
+{
+public:
+    explicit ReplacementTemplate(const string& pattern = "%t");
+
+    const string& pattern() const { return _pattern; }
+
+    // Writes the replacement and returns its size
+    size_t write(std::ostream& out, const string& literal,
+                 const char* text, size_t textSize) const;
+
+    string expand(const string& literal, const string& text) const;
+
+protected:
+    enum PartType { PART_STRING, PART_LITERAL, PART_TEXT };
+
+    struct Part {
+        explicit Part(PartType t, const string& s = string())
+            : type(t), str(s) {}
+        PartType type;
+        string str;
+    };
+
+    string _pattern;
+    std::vector<Part> _parts;
+};
+
+// Streams source to out with the span of each literal tag replaced by
+// tmpl, without building the result in memory. Tags must be sorted;
+// tags overlapping a previous one or the end of the source are ignored.
+// Returns the number of bytes written.
+size_t writeReplacedLiterals(std::ostream& out,
+                const char* source, size_t size,
+                const TextTagList& tags, const ReplacementTemplate& tmpl);
+
+} // namespace hrefkeywords
+
+#endif
+
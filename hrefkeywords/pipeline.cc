@@ -0,0 +1,456 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "pipeline.h"
+
+#include <texpp/parser.h>
+#include <texpp/profiler.h>
+#include <texpp/outputsink.h>
+#include <texpp/vfs.h>
+
+#include <boost/filesystem.hpp>
+
+#include <tr1/unordered_map>
+
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
+namespace hrefkeywords {
+
+using texpp::Node;
+
+const char* const EXCLUDED_ENVIRONMENTS =
+    ".*math.*|.*equation.*|.*eqn.*|.*array.*|"
+    ".*align.*|.*multiline.*|.*gather.*|"
+    ".*verbatim.*|.*biblio.*";
+
+const char* const KNOWN_NOT_LITERALS[] = {
+    "i.e.", "ie.",
+    "c.f.", "cf.", "cf",
+    "e.g.", "eg.",
+    "de", "De", // for de in the names of Universities
+    NULL
+};
+
+namespace {
+
+bool openOutput(std::ofstream& out, const string& fileName)
+{
+    boost::system::error_code ec;
+    boost::filesystem::create_directories(
+                boost::filesystem::path(fileName).parent_path(), ec);
+    out.open(fileName.c_str(), std::ios::out | std::ios::binary);
+    return out.good();
+}
+
+string seconds(boost::uint64_t time)
+{
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%f", double(time) / 1e9);
+    return buf;
+}
+
+inline void appendTag(TextTagList& tags, int type,
+            const std::pair<size_t, size_t>& pos, const string& value)
+{
+    tags.push_back(TextTag(type, pos.first, pos.second, value));
+}
+
+inline void appendTag(TextTagColumns& tags, int type,
+            const std::pair<size_t, size_t>& pos, const string& value)
+{
+    tags.push_back(type, pos.first, pos.second, value.data(), value.size());
+}
+
+// Collects the text tags of a document for extractTextInfo() and
+// extractTextColumns(). Each source file is resolved to its tags (or to
+// none for files outside of workdir) and each node type to the way it
+// is handled only once, so the exclude regex runs once per type.
+template<class Map>
+class TextExtractor
+{
+public:
+    typedef typename Map::mapped_type Tags;
+
+    TextExtractor(Map& result, const boost::regex& excludeRegex,
+                  const string& workdir)
+        : _result(result), _excludeRegex(excludeRegex), _workdir(workdir),
+          _aWorkdir(absolutePath(workdir, string())) {}
+
+    void extract(const Node::ptr& node);
+
+protected:
+    // Node kinds besides TextTag types
+    enum { ENVIRONMENT = -1 };
+
+    int kind(const string& type);
+    Tags* tags(const shared_ptr<string>& file);
+
+    Map& _result;
+    const boost::regex& _excludeRegex;
+    const string& _workdir;
+    string _aWorkdir;
+
+    std::tr1::unordered_map<string, int> _kinds;
+    std::tr1::unordered_map<const string*, Tags*> _files;
+};
+
+template<class Map>
+int TextExtractor<Map>::kind(const string& type)
+{
+    std::tr1::unordered_map<string, int>::iterator it = _kinds.find(type);
+    if(it != _kinds.end()) return it->second;
+
+    int k = TextTag::TT_OTHER;
+    if(type == "text_word") {
+        k = TextTag::TT_WORD;
+    } else if(type == "text_character" || type == "text_space") {
+        k = TextTag::TT_CHARACTER;
+    } else if(type.compare(0, 12, "environment_") == 0 &&
+                !boost::regex_match(type, _excludeRegex)) {
+        k = ENVIRONMENT;
+    }
+    _kinds.insert(std::make_pair(type, k));
+    return k;
+}
+
+template<class Map>
+typename TextExtractor<Map>::Tags*
+TextExtractor<Map>::tags(const shared_ptr<string>& file)
+{
+    typename std::tr1::unordered_map<const string*, Tags*>::iterator it =
+                    _files.find(file.get());
+    if(it != _files.end()) return it->second;
+
+    Tags* t = NULL;
+    if(isLocalFile(*file, _workdir)) {
+        string ffile = absolutePath(*file, _aWorkdir)
+                            .substr(_aWorkdir.size()+1);
+        t = &_result[ffile];
+    }
+    _files.insert(std::make_pair(file.get(), t));
+    return t;
+}
+
+template<class Map>
+void TextExtractor<Map>::extract(const Node::ptr& node)
+{
+    const Node::ChildrenList& children = node->children();
+    for(Node::ChildrenList::const_iterator it = children.begin(),
+                        e = children.end(); it != e; ++it) {
+        const Node::ptr& child = it->second;
+        int k = kind(child->type());
+        if(k == ENVIRONMENT) {
+            extract(child);
+        } else if(k != TextTag::TT_OTHER && child->isOneFile()) {
+            shared_ptr<string> file = child->oneFile();
+            if(!file) continue;
+            if(Tags* t = tags(file))
+                appendTag(*t, k, child->sourcePos(), child->valueString());
+        }
+    }
+}
+
+} // namespace
+
+void extractTextInfo(TextTagsMap& result, Node::ptr node,
+                const boost::regex& excludeRegex, const string& workdir)
+{
+    TextExtractor<TextTagsMap>(result, excludeRegex, workdir).extract(node);
+}
+
+void extractTextColumns(TextColumnsMap& result, Node::ptr node,
+                const boost::regex& excludeRegex, const string& workdir)
+{
+    TextExtractor<TextColumnsMap>(result, excludeRegex, workdir)
+                    .extract(node);
+}
+
+void jsonString(std::ostream& out, const string& str)
+{
+    static const char hex[] = "0123456789abcdef";
+    out << '"';
+    for(string::const_iterator it = str.begin(); it != str.end(); ++it) {
+        unsigned char ch = *it;
+        switch(ch) {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\r': out << "\\r"; break;
+            case '\t': out << "\\t"; break;
+            default:
+                if(ch < 0x20)
+                    out << "\\u00" << hex[ch >> 4] << hex[ch & 15];
+                else
+                    out << ch;
+        }
+    }
+    out << '"';
+}
+
+string getDocumentEncoding(Node::ptr node)
+{
+    string result;
+    const Node::ChildrenList& c = node->children();
+    for(Node::ChildrenList::const_iterator it = c.begin(), e = c.end();
+                            it != e; ++it) {
+        if(it->second->type() == "inputenc") {
+            result = it->second->valueString();
+            break;
+        }
+    }
+    if(!result.empty())
+        return result;
+    else
+        return string("ascii");
+}
+
+PipelineReport::Stage& PipelineReport::stage(const string& name)
+{
+    for(std::vector<Stage>::iterator it = stages.begin(),
+                        e = stages.end(); it != e; ++it)
+        if(it->name == name) return *it;
+    stages.push_back(Stage(name));
+    return stages.back();
+}
+
+boost::uint64_t PipelineReport::totalTime() const
+{
+    boost::uint64_t total = 0;
+    for(std::vector<Stage>::const_iterator it = stages.begin(),
+                        e = stages.end(); it != e; ++it)
+        total += it->time;
+    return total;
+}
+
+string PipelineReport::repr() const
+{
+    std::ostringstream out;
+    for(std::vector<Stage>::const_iterator it = stages.begin(),
+                        e = stages.end(); it != e; ++it)
+        out << it->name << ": " << seconds(it->time)
+            << " (" << it->count << ")\n";
+    out << "total: " << seconds(totalTime()) << "\n";
+    out << "files: " << files << ", text tags: " << textTags
+        << ", literals: " << literals << ", bytes read: " << bytesRead
+        << ", bytes written: " << bytesWritten << "\n";
+    return out.str();
+}
+
+string PipelineReport::json() const
+{
+    std::ostringstream out;
+    out << "{\"files\": " << files << ", \"textTags\": " << textTags
+        << ", \"literals\": " << literals
+        << ", \"bytesRead\": " << bytesRead
+        << ", \"bytesWritten\": " << bytesWritten
+        << ", \"time\": " << seconds(totalTime()) << ", \"stages\": {";
+    for(std::vector<Stage>::const_iterator it = stages.begin(),
+                        e = stages.end(); it != e; ++it) {
+        if(it != stages.begin()) out << ", ";
+        jsonString(out, it->name);
+        out << ": {\"count\": " << it->count
+            << ", \"time\": " << seconds(it->time) << "}";
+    }
+    out << "}, \"foundLiterals\": {";
+    for(std::map<string, size_t>::const_iterator
+                it = foundLiterals.begin(); it != foundLiterals.end(); ++it) {
+        if(it != foundLiterals.begin()) out << ", ";
+        jsonString(out, it->first);
+        out << ": " << it->second;
+    }
+    out << "}, \"errors\": [";
+    for(std::vector<string>::const_iterator it = errors.begin(),
+                        e = errors.end(); it != e; ++it) {
+        if(it != errors.begin()) out << ", ";
+        jsonString(out, *it);
+    }
+    out << "]}";
+    return out.str();
+}
+
+bool SourceBuffer::open(const string& fileName, shared_ptr<texpp::Vfs> vfs)
+{
+    close();
+
+    if(!vfs) {
+        if(_file.open(fileName, "", 0))
+            return true;
+        // Empty files can not be mapped
+        return boost::filesystem::exists(fileName) &&
+               boost::filesystem::is_regular_file(fileName) &&
+               boost::filesystem::file_size(fileName) == 0;
+    }
+
+    shared_ptr<std::istream> file = vfs->open(fileName);
+    if(!file || !file->good())
+        return false;
+    std::ostringstream buf;
+    buf << file->rdbuf();
+    _buffer = buf.str();
+    return !file->bad();
+}
+
+void SourceBuffer::close()
+{
+    _file.close();
+    string().swap(_buffer);
+}
+
+long writeReplacedFile(const string& sourceFile, const string& outputFile,
+            const TextTagList& tags, const ReplacementTemplate& tmpl,
+            shared_ptr<texpp::Vfs> vfs)
+{
+    SourceBuffer source;
+    if(!source.open(sourceFile, vfs))
+        return -1;
+
+    std::ofstream out;
+    if(!openOutput(out, outputFile))
+        return -1;
+    size_t written = writeReplacedLiterals(out, source.data(),
+                            source.size(), tags, tmpl);
+    out.close();
+    return out.fail() ? -1 : long(written);
+}
+
+StageTimer::StageTimer(PipelineReport& report, const string& name)
+    : _stage(report.stage(name)), _start(texpp::Profiler::now())
+{
+}
+
+StageTimer::~StageTimer()
+{
+    _stage.time += texpp::Profiler::now() - _start;
+    _stage.count += 1;
+}
+
+Pipeline::Pipeline(const LiteralMatcher* matcher,
+                   const string& excludeRegex, const string& macro)
+    : _matcher(matcher),
+      _excludeRegex(excludeRegex, boost::regex::extended),
+      _macro(macro), _replacement("\\" + macro + "{%l}{%t}")
+{
+}
+
+Node::ptr Pipeline::parse(const string& fileName,
+            PipelineReport& report, shared_ptr<texpp::Vfs> vfs) const
+{
+    StageTimer timer(report, "parseDocument");
+
+    shared_ptr<std::istream> file;
+    if(vfs) file = vfs->open(fileName);
+    else file.reset(new std::ifstream(fileName.c_str()));
+    if(!file || !file->good()) {
+        report.errors.push_back("Can not open input file " + fileName);
+        return Node::ptr();
+    }
+
+    // Token file names must be absolute to be matched against workdir
+    boost::filesystem::path path(absolutePath(fileName, string()));
+    texpp::Parser parser(path.string(), file,
+                    path.parent_path().string(), false, true,
+                    shared_ptr<texpp::Logger>(), texpp::Parser::STYLE_LATEX);
+    if(vfs) {
+        parser.setVfs(vfs);
+        parser.setOutputSink(texpp::OutputSink::ptr(
+                        new texpp::MemoryOutputSink));
+    }
+    return parser.parse();
+}
+
+PipelineReport Pipeline::run(const string& fileName, const string& outputDir,
+            shared_ptr<texpp::Vfs> vfs, WordCache* cache) const
+{
+    PipelineReport report;
+    Node::ptr document = parse(fileName, report, vfs);
+    if(document) {
+        boost::filesystem::path path(absolutePath(fileName, string()));
+        run(document, path.parent_path().string(), outputDir,
+                        report, vfs, cache);
+    }
+    return report;
+}
+
+void Pipeline::run(Node::ptr document, const string& workdir,
+            const string& outputDir, PipelineReport& report,
+            shared_ptr<texpp::Vfs> vfs, WordCache* cache) const
+{
+    TextColumnsMap textTags;
+    {
+        StageTimer timer(report, "extractTextInfo");
+        extractTextColumns(textTags, document, _excludeRegex, workdir);
+    }
+
+    for(TextColumnsMap::iterator it = textTags.begin(),
+                        e = textTags.end(); it != e; ++it) {
+        report.files += 1;
+        report.textTags += it->second.size();
+
+        TextTagList literalTags;
+        {
+            StageTimer timer(report, "findLiterals");
+            literalTags = _matcher->find(it->second, 0, cache);
+        }
+
+        SourceBuffer source;
+        {
+            StageTimer timer(report, "readSourceFile");
+            string fileName = (boost::filesystem::path(workdir)
+                                    / it->first).string();
+            if(!source.open(fileName, vfs)) {
+                report.errors.push_back(
+                        "Can not read source file " + fileName);
+                continue;
+            }
+            report.bytesRead += source.size();
+        }
+
+        {
+            StageTimer timer(report, "countLiterals");
+            for(TextTagList::const_iterator t = literalTags.begin(),
+                        te = literalTags.end(); t != te; ++t)
+                report.foundLiterals[t->value] += 1;
+            report.literals += literalTags.size();
+        }
+
+        {
+            // Replacements are streamed straight into the output file
+            StageTimer timer(report, "writeSourceFile");
+            string fileName = (boost::filesystem::path(outputDir)
+                                    / it->first).string();
+            std::ofstream out;
+            size_t written = 0;
+            if(openOutput(out, fileName)) {
+                written = writeReplacedLiterals(out, source.data(),
+                                source.size(), literalTags, _replacement);
+                out.close();
+            }
+            if(out.fail()) {
+                report.errors.push_back(
+                        "Can not write output file " + fileName);
+                continue;
+            }
+            report.bytesWritten += written;
+        }
+    }
+}
+
+} // namespace hrefkeywords
+
@@ -0,0 +1,197 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __HREFKEYWORDS_PIPELINE_H
+#define __HREFKEYWORDS_PIPELINE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <ostream>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/regex.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "literals.h"
+
+namespace texpp {
+    class Node;
+    class Vfs;
+}
+
+namespace hrefkeywords {
+
+using boost::shared_ptr;
+
+// Environments whose text is never searched for literals
+extern const char* const EXCLUDED_ENVIRONMENTS;
+
+// Words that look like abbreviations but are never literals,
+// terminated by NULL
+extern const char* const KNOWN_NOT_LITERALS[];
+
+// Text tags of each local source file, relative to the document workdir
+typedef std::map<string, TextTagList> TextTagsMap;
+
+void extractTextInfo(TextTagsMap& result, shared_ptr<texpp::Node> node,
+                const boost::regex& excludeRegex,
+                const string& workdir = string());
+
+// Same text tags in columnar form, ready for LiteralMatcher::find
+typedef std::map<string, TextTagColumns> TextColumnsMap;
+
+void extractTextColumns(TextColumnsMap& result, shared_ptr<texpp::Node> node,
+                const boost::regex& excludeRegex,
+                const string& workdir = string());
+
+// Writes str as a JSON string literal
+void jsonString(std::ostream& out, const string& str);
+
+// Value of the inputenc node, ascii if there is none
+string getDocumentEncoding(shared_ptr<texpp::Node> node);
+
+// Contents of a source file, memory mapped when it is read from disk
+// and kept in a single buffer when it is read from a vfs
+class SourceBuffer: boost::noncopyable
+{
+public:
+    SourceBuffer() {}
+
+    bool open(const string& fileName,
+              shared_ptr<texpp::Vfs> vfs = shared_ptr<texpp::Vfs>());
+    void close();
+
+    const char* data() const {
+        return _file.data() ? _file.data() : _buffer.data();
+    }
+    size_t size() const {
+        return _file.data() ? _file.size() : _buffer.size();
+    }
+
+protected:
+    MappedFile _file;
+    string _buffer;
+};
+
+// Copies sourceFile to outputFile, creating its directory, with the
+// literal tags replaced by tmpl. Returns the number of bytes written,
+// or -1 if the source can not be read or the output written.
+long writeReplacedFile(const string& sourceFile, const string& outputFile,
+            const TextTagList& tags, const ReplacementTemplate& tmpl,
+            shared_ptr<texpp::Vfs> vfs = shared_ptr<texpp::Vfs>());
+
+// Times and counters of a Pipeline run. Times are in nanoseconds.
+struct PipelineReport
+{
+    struct Stage
+    {
+        explicit Stage(const string& n = string())
+            : name(n), count(0), time(0) {}
+
+        string  name;
+        size_t  count;
+        boost::uint64_t time;
+    };
+
+    PipelineReport()
+        : files(0), textTags(0), literals(0),
+          bytesRead(0), bytesWritten(0) {}
+
+    // Stages in the order they first ran
+    std::vector<Stage> stages;
+
+    size_t files;
+    size_t textTags;
+    size_t literals;
+    size_t bytesRead;
+    size_t bytesWritten;
+
+    // Number of replacements of each literal
+    std::map<string, size_t> foundLiterals;
+
+    // Files that could not be read or written
+    std::vector<string> errors;
+
+    Stage& stage(const string& name);
+    boost::uint64_t totalTime() const;
+
+    // Human readable summary
+    string repr() const;
+
+    // Single line JSON object, times in seconds
+    string json() const;
+};
+
+// Adds its own lifetime to a stage of the report
+class StageTimer: boost::noncopyable
+{
+public:
+    StageTimer(PipelineReport& report, const string& name);
+    ~StageTimer();
+
+protected:
+    PipelineReport::Stage& _stage;
+    boost::uint64_t _start;
+};
+
+// Whole literal annotation flow over one document: parse, extract text
+// tags, find literals, and write a copy of every local source file with
+// each literal wrapped into \macro{literal}{text}.
+class Pipeline: boost::noncopyable
+{
+public:
+    Pipeline(const LiteralMatcher* matcher,
+             const string& excludeRegex = EXCLUDED_ENVIRONMENTS,
+             const string& macro = "href");
+
+    const string& macro() const { return _macro; }
+
+    // Replacement of each literal: \macro{%l}{%t}
+    const ReplacementTemplate& replacement() const { return _replacement; }
+
+    // Parses the document with a texpp::Parser in LaTeX style. If vfs
+    // is given the document is read from it and the files the document
+    // writes are kept in memory.
+    shared_ptr<texpp::Node> parse(const string& fileName,
+                PipelineReport& report,
+                shared_ptr<texpp::Vfs> vfs = shared_ptr<texpp::Vfs>()) const;
+
+    // Threads sharing the pipeline should pass a word cache of their own
+    PipelineReport run(const string& fileName, const string& outputDir,
+                shared_ptr<texpp::Vfs> vfs = shared_ptr<texpp::Vfs>(),
+                WordCache* cache = NULL) const;
+
+    // Runs the stages after parsing on an already parsed document
+    void run(shared_ptr<texpp::Node> document, const string& workdir,
+                const string& outputDir, PipelineReport& report,
+                shared_ptr<texpp::Vfs> vfs = shared_ptr<texpp::Vfs>(),
+                WordCache* cache = NULL) const;
+
+protected:
+    const LiteralMatcher* _matcher;
+    boost::regex _excludeRegex;
+    string _macro;
+    ReplacementTemplate _replacement;
+};
+
+} // namespace hrefkeywords
+
+#endif
+
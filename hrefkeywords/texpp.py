@@ -4,15 +4,15 @@ import sys
 import texpy
 
 def get_text(node, whitelist):
-    text = ''
+    """ Returns the text of all text nodes below node which are
+        only nested in whitelisted nodes, if whitelist is given """
+    selector = 'text_word|text_character|text_space'
+    if whitelist:
+        selector += ':not-under(!%s)' % '|'.join(
+                        [texpy.NodeQuery.escape(name) for name in whitelist])
 
-    for name, child in node.children():
-        if child.type() in ('text_word', 'text_character', 'text_space'):
-            text += child.value()
-        elif not whitelist or child.type() in whitelist:
-            text += get_text(child, whitelist)
-
-    return text
+    return ''.join([child.value()
+                    for child in texpy.NodeQuery(selector).nodes(node)])
 
 def main():
     """ Main routine """
@@ -9,6 +9,7 @@ sys.argv = sys.argv[0:1] + sys.argv[4:]
 import hrefliterals
 import StringIO
 import unittest
+import pickle
 import os
 
 class NormLiteralTest(unittest.TestCase):
@@ -102,6 +103,40 @@ class NormLiteralTest(unittest.TestCase):
         self.assertEqual(self.normLiteral('hello+world'), 'hello+world')
         self.assertEqual(self.normLiteral('test SET'), 'testS.E.T.')
 
+    def testWordCache(self):
+        self.words.clearCache()
+        self.assertEqual(hrefliterals.normLiteral('hello SETs',
+                            self.words, self.stemmer, {}), 'helloS.E.T.')
+        self.assertEqual(self.words.cacheMisses(), 2)
+        self.assertEqual(self.words.cacheHits(), 0)
+        self.assertEqual(hrefliterals.normLiteral('SETs hello',
+                            self.words, self.stemmer, {}), 'S.E.T.hello')
+        self.assertEqual(self.words.cacheMisses(), 2)
+        self.assertEqual(self.words.cacheHits(), 2)
+        self.words.setCacheMaxSize(1)
+        self.assertEqual(self.words.cacheSize(), 1)
+
+class WordsDictTest(unittest.TestCase):
+    def testCompiled(self):
+        fname = os.tmpnam()
+        self.assertTrue(hrefliterals.WordsDict.compile(
+                    '/usr/share/dict/words', fname, 4))
+        try:
+            plain = hrefliterals.WordsDict('/usr/share/dict/words', 4)
+            compiled = hrefliterals.WordsDict(fname, 4)
+            self.assertFalse(plain.compiled())
+            self.assertTrue(compiled.compiled())
+            for word in ('set', 'Ada', 'dof', 'or', 'xxxx', 'electron'):
+                self.assertEqual(compiled.contains(word), plain.contains(word))
+            self.assertFalse(compiled.contains('qqq'))
+            compiled.insert('qqq')
+            self.assertTrue(compiled.contains('qqq'))
+            self.assertRaises(ValueError, hrefliterals.WordsDict, fname, 5)
+            open(fname, 'r+b').truncate(12)
+            self.assertRaises(ValueError, hrefliterals.WordsDict, fname, 4)
+        finally:
+            os.remove(fname)
+
 class LiteralFunctionsTest(unittest.TestCase):
     def __init__(self, *args, **kwargs):
         super(LiteralFunctionsTest, self).__init__(*args, **kwargs)
@@ -160,6 +195,20 @@ class LiteralFunctionsTest(unittest.TestCase):
         self.assertEqual(literalTags[2], hrefliterals.TextTag(
                     hrefliterals.TextTag.Type.LITERAL, 43, 72, 'word'))
 
+    def testTagsBytes(self):
+        textTags = hrefliterals.extractTextInfo(
+                self.document, self.exclude_re, '')
+        data = textTags['f'].to_bytes()
+        for buf in (data, bytearray(data), buffer(data)):
+            self.assertEqual(
+                    list(hrefliterals.TextTagList.from_bytes(buf)),
+                    list(textTags['f']))
+        self.assertRaises(ValueError,
+                hrefliterals.TextTagList.from_bytes, data[:-1])
+        self.assertEqual(
+                list(pickle.loads(pickle.dumps(textTags['f'], 2))),
+                list(textTags['f']))
+
     def testReplaceTags(self):
         textTags = hrefliterals.extractTextInfo(
                 self.document, self.exclude_re, '')
@@ -177,6 +226,35 @@ class LiteralFunctionsTest(unittest.TestCase):
         """
         self.assertEqual(replaced, rsource)
 
+    def testWriteReplacedFile(self):
+        textTags = hrefliterals.extractTextInfo(
+                self.document, self.exclude_re, '')
+        literals = {'word':None, 'W.O.R.D.2.':None}
+        literalTags = hrefliterals.findLiterals(
+                textTags['f'], literals, {}, self.words, self.stemmer, 0)
+        href = hrefliterals.ReplacementTemplate('\\href{%l}{%t}')
+        self.assertEqual(href.expand('word', 'Words'), '\\href{word}{Words}')
+
+        source = os.tmpnam()
+        output = os.tmpnam()
+        open(source, 'w').write(self.source)
+        try:
+            written = hrefliterals.writeReplacedFile(
+                            source, output, literalTags, href)
+            replaced = open(output).read()
+            self.assertEqual(written, len(replaced))
+            for tag in literalTags:
+                tag.value = href.expand(tag.value,
+                                        self.source[tag.start:tag.end])
+            self.assertEqual(replaced,
+                    hrefliterals.replaceLiterals(self.source, literalTags))
+            self.assertEqual(hrefliterals.writeReplacedFile(
+                    source + '.none', output, literalTags, href), -1)
+        finally:
+            os.remove(source)
+            if os.path.exists(output):
+                os.remove(output)
+
 class LiteralsTest(unittest.TestCase):
     def __init__(self, *args, **kwargs):
         super(LiteralsTest, self).__init__(*args, **kwargs)
@@ -212,6 +290,76 @@ class LiteralsTest(unittest.TestCase):
         self.assertEqual(literalTags[0], hrefliterals.TextTag(
                     hrefliterals.TextTag.Type.LITERAL, 0, 3, 'D.E.'))
 
+    def testMatcher(self):
+        source = ' spin -spin spin- spin-1 spin-12 the DE de i.e. '
+        literals = dict.fromkeys(('spin', 'spin1.', 'D.E.', 'I.E.'))
+        notLiterals = dict.fromkeys(('de', 'i.e.'))
+        document = hrefliterals.parseDocument('f', StringIO.StringIO(source),
+                                                os.getcwd())
+        textTags = hrefliterals.extractTextInfo(document, self.exclude_re, '')
+        matcher = hrefliterals.LiteralMatcher(literals, notLiterals,
+                                                self.words, self.stemmer)
+        self.assertEqual(len(matcher), 4)
+        self.assertTrue(matcher.contains('spin1.'))
+        # The first tag also covers the leading space, see testAdjacentChars
+        LITERAL = hrefliterals.TextTag.Type.LITERAL
+        spin1 = source.index('spin-1')
+        de = source.index('DE')
+        self.assertEqual(list(matcher.find(textTags['f'])), [
+                hrefliterals.TextTag(LITERAL, 0, 5, 'spin'),
+                hrefliterals.TextTag(LITERAL, spin1, spin1 + 6, 'spin1.'),
+                hrefliterals.TextTag(LITERAL, de, de + 2, 'D.E.')])
+
+    def testTextColumns(self):
+        source = ' spin -spin spin- spin-1 spin-12 the DE de i.e. '
+        literals = dict.fromkeys(('spin', 'spin1.', 'D.E.', 'I.E.'))
+        notLiterals = dict.fromkeys(('de', 'i.e.'))
+        document = hrefliterals.parseDocument('f', StringIO.StringIO(source),
+                                                os.getcwd())
+        textTags = hrefliterals.extractTextInfo(document, self.exclude_re, '')
+        columns = hrefliterals.extractTextColumns(document,
+                                                self.exclude_re, '')
+        self.assertEqual(columns.keys(), ['f'])
+        self.assertEqual(len(columns['f']), len(textTags['f']))
+        self.assertEqual(list(columns['f'].tags()), list(textTags['f']))
+        self.assertEqual(columns['f'][-1], textTags['f'][-1])
+        self.assertEqual(len(columns['f'].starts()), len(textTags['f']))
+        self.assertEqual(len(columns['f'].valueOffsets()),
+                         len(textTags['f']) + 1)
+        self.assertEqual(str(buffer(columns['f'].valuePool())),
+                         ''.join(t.value for t in textTags['f']))
+
+        matcher = hrefliterals.LiteralMatcher(literals, notLiterals,
+                                                self.words, self.stemmer)
+        self.assertEqual(list(matcher.find(columns['f'])),
+                         list(matcher.find(textTags['f'])))
+
+    def testCompiledConcepts(self):
+        concepts = os.tmpnam()
+        index = os.tmpnam()
+        open(concepts, 'w').write('Spin\nspin-1\nDE\ni.e.\n')
+        try:
+            self.assertTrue(hrefliterals.compileConcepts(
+                    concepts, index, self.words, self.stemmer))
+            matcher = hrefliterals.LiteralMatcher({}, {},
+                                                self.words, self.stemmer)
+            self.assertTrue(matcher.load(index))
+            self.assertFalse(matcher.load(concepts))
+            self.assertEqual(matcher.error(), '')
+
+            # Indexes only load with the dictionary they were built with
+            other = hrefliterals.WordsDict('/usr/share/dict/words', 3)
+            otherMatcher = hrefliterals.LiteralMatcher({}, {},
+                                                other, self.stemmer)
+            self.assertFalse(otherMatcher.load(index))
+            self.assertTrue(otherMatcher.error())
+            self.assertEqual(len(matcher), 4)
+            self.assertTrue(matcher.contains('spin1.'))
+            self.assertTrue(matcher.contains('D.E.'))
+        finally:
+            os.remove(concepts)
+            os.remove(index)
+
 if __name__ == '__main__':
     unittest.main()
 
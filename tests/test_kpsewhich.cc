@@ -0,0 +1,210 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#define BOOST_TEST_MODULE kpsewhich_test_suite
+#include <boost/test/included/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <texpp/kpsewhich.h>
+#include <cstdlib>
+
+using namespace texpp;
+namespace fs = boost::filesystem;
+
+// Fake texmf installation in a temporary directory:
+//   texmf/         main tree, indexed by ls-R
+//   texmf-local/   tree without ls-R, searched on disk
+//   work/          document directory
+struct TexmfFixture
+{
+    TexmfFixture()
+    {
+        char tmpl[] = "/tmp/texpp_kpsewhich_XXXXXX";
+        root = mkdtemp(tmpl);
+
+        write("texmf/tex/latex/foo/foo.sty");
+        write("texmf/tex/plain/bar.tex");
+        write("texmf/tex/plain/sub/inner.tex");
+        write("texmf/bibtex/bib/refs.bib");
+        write("texmf/bibtex/bib/unlisted.bib");
+        write("texmf-local/tex/deep/a/b/local.tex");
+        write("texmf-local/tex/foo.sty");
+        write("work/doc.tex");
+
+        write("texmf/ls-R",
+            "% ls-R -- filename database for kpathsea; do not change this line.\n"
+            "./:\nls-R\ntex\nbibtex\n\n"
+            "./tex:\nlatex\nplain\n\n"
+            "./tex/latex:\nfoo\n\n"
+            "./tex/latex/foo:\nfoo.sty\n\n"
+            "./tex/plain:\nbar.tex\nsub\n\n"
+            "./tex/plain/sub:\ninner.tex\n\n"
+            "./bibtex/bib:\nrefs.bib\n");
+
+        write("web2c/texmf.cnf",
+            "% fake texmf.cnf\n"
+            "TEXMFMAIN = " + root + "/texmf\n"
+            "TEXMFLOCAL = " + root + "/texmf-local\n"
+            "TEXMF = {$TEXMFMAIN,$TEXMFLOCAL}\n"
+            "TEXMFDBS = $TEXMFMAIN\n"
+            "TEXMFDOTDIR = .\n"
+            "TEXINPUTS = $TEXMFDOTDIR;$TEXMF/tex// % comment\n"
+            "TEXINPUTS.latex = /nonexistent\n"
+            "TEXINPUTS = /overridden\n"
+            "BIBINPUTS = .;!!$TEXMFMAIN/bibtex/bib//\n"
+            "LONG = a\\\n"
+            "       b\n");
+    }
+
+    ~TexmfFixture()
+    {
+        fs::remove_all(root);
+    }
+
+    void write(const std::string& name,
+               const std::string& content = std::string())
+    {
+        fs::path path = fs::path(root) / name;
+        fs::create_directories(path.parent_path());
+        fs::ofstream file(path);
+        file << content;
+    }
+
+    std::string root;
+};
+
+BOOST_FIXTURE_TEST_CASE( kpsewhich_config, TexmfFixture )
+{
+    KpseResolver resolver(root + "/web2c", false);
+    BOOST_CHECK(resolver.configured());
+    BOOST_CHECK_EQUAL(resolver.expand("$TEXMFDOTDIR"), ".");
+    BOOST_CHECK_EQUAL(resolver.expand("${TEXMFDOTDIR}/x"), "./x");
+    BOOST_CHECK_EQUAL(resolver.expand("$LONG"), "ab");
+    BOOST_CHECK_EQUAL(resolver.expand("$TEXINPUTS"),
+            ".:{" + root + "/texmf," + root + "/texmf-local}/tex//");
+
+    KpseResolver missing(root + "/nonexistent", false);
+    BOOST_CHECK(!missing.configured());
+}
+
+BOOST_FIXTURE_TEST_CASE( kpsewhich_find, TexmfFixture )
+{
+    KpseResolver resolver(root + "/web2c", false);
+
+    // ls-R lookups, recursive and with a directory part
+    BOOST_CHECK_EQUAL(resolver.find("foo.sty"),
+                        root + "/texmf/tex/latex/foo/foo.sty");
+    BOOST_CHECK_EQUAL(resolver.find("bar"),
+                        root + "/texmf/tex/plain/bar.tex");
+    BOOST_CHECK_EQUAL(resolver.find("sub/inner"),
+                        root + "/texmf/tex/plain/sub/inner.tex");
+
+    // Tree without ls-R
+    BOOST_CHECK_EQUAL(resolver.find("local.tex"),
+                        root + "/texmf-local/tex/deep/a/b/local.tex");
+    BOOST_CHECK_EQUAL(resolver.find("b/local.tex"),
+                        root + "/texmf-local/tex/deep/a/b/local.tex");
+
+    // Relative path elements are relative to dir
+    BOOST_CHECK_EQUAL(resolver.find("doc", root + "/work"), "./doc.tex");
+    BOOST_CHECK_EQUAL(resolver.find("doc"), "");
+    BOOST_CHECK_EQUAL(resolver.find("./doc.tex", root + "/work"),
+                        "./doc.tex");
+
+    // !! restricts the search to ls-R
+    BOOST_CHECK_EQUAL(resolver.find("refs.bib"),
+                        root + "/texmf/bibtex/bib/refs.bib");
+    BOOST_CHECK_EQUAL(resolver.find("unlisted.bib"), "");
+
+    BOOST_CHECK_EQUAL(resolver.find(root + "/work/doc"),
+                        root + "/work/doc.tex");
+}
+
+BOOST_FIXTURE_TEST_CASE( kpsewhich_cache, TexmfFixture )
+{
+    KpseResolver resolver(root + "/web2c", false);
+
+    BOOST_CHECK_EQUAL(resolver.find("later.tex"), "");
+    BOOST_CHECK_EQUAL(resolver.find("bar.tex"),
+                        root + "/texmf/tex/plain/bar.tex");
+
+    // Both answers are remembered
+    write("texmf-local/tex/later.tex");
+    fs::remove(fs::path(root) / "texmf/tex/plain/bar.tex");
+    BOOST_CHECK_EQUAL(resolver.find("later.tex"), "");
+    BOOST_CHECK_EQUAL(resolver.find("bar.tex"),
+                        root + "/texmf/tex/plain/bar.tex");
+
+    resolver.clearCache();
+    BOOST_CHECK_EQUAL(resolver.find("later.tex"),
+                        root + "/texmf-local/tex/later.tex");
+    BOOST_CHECK_EQUAL(resolver.find("bar.tex"), "");
+}
+
+BOOST_FIXTURE_TEST_CASE( kpsewhich_persistent_cache, TexmfFixture )
+{
+    std::string cacheName = root + "/kpse.cache";
+    {
+        KpseResolver resolver(root + "/web2c", false);
+        BOOST_REQUIRE(resolver.setPersistentCache(cacheName));
+        BOOST_CHECK_EQUAL(resolver.persistentCache()->size(), 0);
+
+        resolver.find("foo.sty");
+        resolver.find("local.tex");
+        resolver.find("missing.tex");
+        resolver.find("doc", root + "/work");
+    }
+    BOOST_REQUIRE(fs::exists(cacheName));
+
+    KpseResolver resolver(root + "/web2c", false);
+    BOOST_REQUIRE(resolver.setPersistentCache(cacheName));
+    KpseCache::ptr cache = resolver.persistentCache();
+    BOOST_CHECK_EQUAL(cache->size(), 4);
+
+    std::string result;
+    BOOST_CHECK(cache->lookup("\nfoo.sty", result));
+    BOOST_CHECK_EQUAL(result, root + "/texmf/tex/latex/foo/foo.sty");
+    BOOST_CHECK(cache->lookup("\nlocal.tex", result));
+    BOOST_CHECK_EQUAL(result, root + "/texmf-local/tex/deep/a/b/local.tex");
+    BOOST_CHECK(cache->lookup(root + "/work\ndoc", result));
+    BOOST_CHECK_EQUAL(result, "./doc.tex");
+    BOOST_CHECK(cache->lookup("\nmissing.tex", result));
+    BOOST_CHECK_EQUAL(result, "");
+
+    // Changing a directory a lookup depended on invalidates it
+    write("texmf-local/tex/deep/missing.tex");
+    KpseResolver changed(root + "/web2c", false);
+    BOOST_REQUIRE(changed.setPersistentCache(cacheName));
+    cache = changed.persistentCache();
+    BOOST_CHECK(cache->lookup("\nfoo.sty", result));
+    BOOST_CHECK(!cache->lookup("\nmissing.tex", result));
+    BOOST_CHECK_EQUAL(changed.find("missing.tex"),
+                        root + "/texmf-local/tex/deep/missing.tex");
+    BOOST_CHECK(changed.savePersistentCache());
+    BOOST_CHECK_EQUAL(cache->size(), 4);
+    BOOST_CHECK(cache->lookup("\nmissing.tex", result));
+    BOOST_CHECK_EQUAL(result, root + "/texmf-local/tex/deep/missing.tex");
+
+    // A different configuration ignores the whole file
+    write("web2c/texmf.cnf", "TEXINPUTS = .\n");
+    KpseResolver other(root + "/web2c", false);
+    BOOST_REQUIRE(other.setPersistentCache(cacheName));
+    BOOST_CHECK_EQUAL(other.persistentCache()->size(), 0);
+}
+
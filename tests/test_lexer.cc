@@ -23,6 +23,7 @@
 #include <boost/lambda/bind.hpp>
 
 #include <texpp/lexer.h>
+#include <texpp/tokentable.h>
 #include <iostream>
 #include <sstream>
 
@@ -50,11 +51,11 @@ void check_output(Token* tokens, size_t count, vector<Token::ptr> output,
     using namespace boost::lambda;
     vector<string> tokens_repr(count);
     std::transform(tokens, tokens+count,
-            tokens_repr.begin(), bind(&Token::repr, boost::lambda::_1));
+            tokens_repr.begin(), boost::lambda::bind(&Token::repr, boost::lambda::_1));
 
     vector<string> output_repr(output.size());
     std::transform(output.begin(), output.end(),
-            output_repr.begin(), bind(&Token::repr, *boost::lambda::_1));
+            output_repr.begin(), boost::lambda::bind(&Token::repr, *boost::lambda::_1));
 
     if(print)
         std::for_each(output_repr.begin(), output_repr.end(),
@@ -306,3 +307,31 @@ BOOST_AUTO_TEST_CASE( lexer_other )
 }
 
 
+BOOST_AUTO_TEST_CASE( lexer_token_table )
+{
+    const string input = "\\a b{ab}%c\n\\a\n";
+    vector<Token::ptr> tokens = run_lexer(create_lexer(input));
+
+    TokenTable table;
+    shared_ptr<Lexer> lexer = create_lexer(input);
+    BOOST_CHECK_EQUAL(table.lex(*lexer, 3), 3u);
+    BOOST_CHECK_EQUAL(table.lex(*lexer), tokens.size() - 3);
+    BOOST_CHECK_EQUAL(table.lex(*lexer), 0u);
+
+    BOOST_REQUIRE_EQUAL(table.size(), tokens.size());
+    for(size_t i = 0; i < tokens.size(); ++i) {
+        const Token& token = *tokens[i];
+        BOOST_CHECK_EQUAL(table.types()[i], token.type());
+        BOOST_CHECK_EQUAL(table.catCodes()[i], token.catCode());
+        BOOST_CHECK_EQUAL(table.valueNames()[table.values()[i]],
+                          token.value());
+        BOOST_CHECK_EQUAL(size_t(table.lineNos()[i]), token.lineNo());
+        BOOST_CHECK_EQUAL(input.substr(table.starts()[i],
+                    table.ends()[i] - table.starts()[i]), token.source());
+    }
+
+    // Repeated values share one entry
+    BOOST_CHECK_EQUAL(table.values()[0], table.values()[table.size()-2]);
+    BOOST_CHECK(table.valueNames().size() < table.size());
+}
+
@@ -0,0 +1,495 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#define BOOST_TEST_MODULE literals_test_suite
+#include <boost/test/included/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <texpp/parser.h>
+
+#include <hrefkeywords/literals.h>
+#include <hrefkeywords/pipeline.h>
+#include <hrefkeywords/batch.h>
+#include <cstdlib>
+#include <cctype>
+#include <sstream>
+#include <map>
+
+using namespace hrefkeywords;
+namespace fs = boost::filesystem;
+
+// Words dictionary, concepts file and documents in a temporary directory
+struct LiteralsFixture
+{
+    LiteralsFixture()
+    {
+        char tmpl[] = "/tmp/texpp_literals_XXXXXX";
+        root = mkdtemp(tmpl);
+
+        write("words", "Ada\nI\na\nboy\nelectron\nhello\nor\nset\nsets\n"
+                       "spin\ntest\nthe\nworld\n");
+        write("concepts", "Spin\nspin-1\n\nDE\ni.e.\n"
+                          "SU\\(2\\)\nhello world\n");
+
+        words.reset(new WordsDict(path("words"), 4));
+    }
+
+    ~LiteralsFixture()
+    {
+        fs::remove_all(root);
+    }
+
+    void write(const string& name, const string& content)
+    {
+        fs::path path = fs::path(root) / name;
+        fs::create_directories(path.parent_path());
+        fs::ofstream file(path);
+        file << content;
+    }
+
+    string path(const string& name) const
+    {
+        return (fs::path(root) / name).string();
+    }
+
+    string norm(const string& literal) const
+    {
+        return normLiteral(literal, words.get(), &stemmer);
+    }
+
+    // Splits a text into word and character tags
+    static TextTagList tags(const string& text)
+    {
+        TextTagList result;
+        for(size_t n = 0; n < text.size(); ) {
+            size_t e = n;
+            while(e < text.size() && std::isalnum(text[e])) ++e;
+            if(e == n) {
+                result.push_back(TextTag(TextTag::TT_CHARACTER,
+                                    n, n+1, text.substr(n, 1)));
+                n = n+1;
+            } else {
+                result.push_back(TextTag(TextTag::TT_WORD,
+                                    n, e, text.substr(n, e-n)));
+                n = e;
+            }
+        }
+        return result;
+    }
+
+    string root;
+    Stemmer stemmer;
+    boost::scoped_ptr<WordsDict> words;
+};
+
+BOOST_FIXTURE_TEST_CASE( literals_norm, LiteralsFixture )
+{
+    BOOST_CHECK_EQUAL(norm("electrons"), "electron");
+    BOOST_CHECK_EQUAL(norm("xxxxxxxxx"), "xxxxxxxxx");
+    BOOST_CHECK_EQUAL(norm("sets"), "set");
+    BOOST_CHECK_EQUAL(norm("SET"), "S.E.T.");
+    BOOST_CHECK_EQUAL(norm("s.e.t."), "S.E.T.");
+    BOOST_CHECK_EQUAL(norm("dof"), "D.O.F.");
+    BOOST_CHECK_EQUAL(norm("Ada"), "ada");
+    BOOST_CHECK_EQUAL(norm("ada"), "A.D.A.");
+    BOOST_CHECK_EQUAL(norm("SU(2)"), "S.U.(2.)");
+    BOOST_CHECK_EQUAL(norm("hello-world"), "helloworld");
+    BOOST_CHECK_EQUAL(norm("test SETs"), "testS.E.T.");
+}
+
+BOOST_FIXTURE_TEST_CASE( literals_cache, LiteralsFixture )
+{
+    words->clearCache();
+    BOOST_CHECK_EQUAL(norm("hello SETs"), "helloS.E.T.");
+    BOOST_CHECK_EQUAL(words->cacheMisses(), 2u);
+    BOOST_CHECK_EQUAL(words->cacheHits(), 0u);
+    BOOST_CHECK_EQUAL(norm("SETs hello"), "S.E.T.hello");
+    BOOST_CHECK_EQUAL(words->cacheHits(), 2u);
+
+    // Inserted words change normalization
+    words->insert("dof");
+    BOOST_CHECK_EQUAL(words->cacheSize(), 0u);
+    BOOST_CHECK_EQUAL(norm("dof"), "dof");
+}
+
+BOOST_FIXTURE_TEST_CASE( literals_compiled_words, LiteralsFixture )
+{
+    BOOST_REQUIRE(WordsDict::compile(path("words"), path("words.bin"), 4));
+    WordsDict compiled(path("words.bin"), 4);
+    BOOST_CHECK(!words->compiled());
+    BOOST_CHECK(compiled.compiled());
+
+    const char* probe[] = { "set", "Ada", "ada", "dof", "or", "spin",
+                            "electron", "" };
+    for(const char** w = probe; **w; ++w)
+        BOOST_CHECK_EQUAL(compiled.contains(*w), words->contains(*w));
+    BOOST_CHECK(compiled.error().empty());
+    BOOST_CHECK(compiled.fingerprint() == words->fingerprint());
+    BOOST_CHECK_EQUAL(words->fingerprint().wordCount, 8u);
+
+    // Usable with any abbrMaxLen up to the compiled one, the stored
+    // fingerprint is that of a plain list with the same words
+    WordsDict shorter(path("words.bin"), 3);
+    WordsDict shorterList(path("words"), 3);
+    BOOST_CHECK(shorter.error().empty());
+    BOOST_CHECK(shorter.fingerprint() == shorterList.fingerprint());
+    BOOST_CHECK(shorter.fingerprint() != compiled.fingerprint());
+    shorter.insert("spn");
+    shorter.insert("set");
+    shorterList.insert("spn");
+    BOOST_CHECK(shorter.fingerprint() == shorterList.fingerprint());
+    WordsDict larger(path("words.bin"), 5);
+    BOOST_CHECK(!larger.error().empty());
+    BOOST_CHECK(!larger.compiled());
+    BOOST_CHECK(!larger.contains("set"));
+
+    // Damaged dictionaries are rejected rather than read as word lists
+    fs::ifstream in(fs::path(path("words.bin")));
+    std::ostringstream data;
+    data << in.rdbuf();
+    write("truncated.bin", data.str().substr(0, 12));
+    write("corrupt.bin", data.str() + "\nset\n");
+    string mismatch = data.str();
+    mismatch[32] ^= 1; // header wordsHash
+    write("mismatch.bin", mismatch);
+
+    const char* damaged[] = { "truncated.bin", "corrupt.bin",
+                              "mismatch.bin", "" };
+    for(const char** f = damaged; **f; ++f) {
+        WordsDict dict(path(*f), 4);
+        BOOST_CHECK_MESSAGE(!dict.error().empty(), *f);
+        BOOST_CHECK(!dict.compiled());
+        BOOST_CHECK(!dict.contains("set"));
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE( literals_tags_encoding, LiteralsFixture )
+{
+    TextTagList list = tags("spin of the spin, the spin-1");
+    list.push_back(TextTag(TextTag::TT_LITERAL, 5, 3, "back"));
+    list.push_back(TextTag(TextTag::TT_OTHER, size_t(-1), size_t(-1)));
+
+    string data = encodeTextTags(list);
+    TextTagList decoded;
+    BOOST_REQUIRE(decodeTextTags(data.data(), data.size(), decoded));
+    BOOST_CHECK(decoded == list);
+
+    // Repeated values are stored once, small offsets take one byte
+    TextTagList repeated;
+    for(size_t n = 0; n < 100; ++n)
+        repeated.push_back(TextTag(TextTag::TT_WORD, n*5, n*5 + 4, "spin"));
+    BOOST_CHECK_EQUAL(encodeTextTags(repeated).size(), 8 + 6 + 1 + 4*100);
+
+    BOOST_CHECK(decodeTextTags(encodeTextTags(TextTagList()).data(),
+                               8 + 2, decoded));
+    BOOST_CHECK(decoded.empty());
+
+    BOOST_CHECK(!decodeTextTags(data.data(), data.size() - 1, decoded));
+    BOOST_CHECK(decoded.empty());
+    string junk = data + "x";
+    BOOST_CHECK(!decodeTextTags(junk.data(), junk.size(), decoded));
+    BOOST_CHECK(!decodeTextTags("TXPWORDS", 8, decoded));
+}
+
+BOOST_FIXTURE_TEST_CASE( literals_trie, LiteralsFixture )
+{
+    LiteralTrie trie;
+    trie.insert("spin");
+    trie.insert("spin1.");
+    trie.insert("spin");
+    BOOST_CHECK_EQUAL(trie.size(), 2u);
+    BOOST_CHECK(trie.contains("spin"));
+    BOOST_CHECK(!trie.contains("spi"));
+    BOOST_CHECK(!trie.contains("spin1"));
+
+    BOOST_REQUIRE(trie.save(path("trie")));
+    LiteralTrie mapped;
+    BOOST_REQUIRE(mapped.load(path("trie")));
+    BOOST_CHECK(mapped.mapped());
+    BOOST_CHECK_EQUAL(mapped.size(), 2u);
+    BOOST_CHECK(mapped.contains("spin1."));
+    BOOST_CHECK(!mapped.contains("spin1"));
+
+    // Inserting into a mapped trie copies it
+    mapped.insert("spin2.");
+    BOOST_CHECK(!mapped.mapped());
+    BOOST_CHECK_EQUAL(mapped.size(), 3u);
+    BOOST_CHECK(mapped.contains("spin"));
+
+    BOOST_CHECK(!mapped.load(path("words")));
+    BOOST_CHECK_EQUAL(mapped.size(), 3u);
+}
+
+BOOST_FIXTURE_TEST_CASE( literals_matcher, LiteralsFixture )
+{
+    LiteralMatcher matcher(words.get(), &stemmer);
+    matcher.insert("spin");
+    matcher.insert("spin1.");
+    matcher.insert("D.E.");
+    matcher.insert("I.E.");
+    matcher.insertNotLiteral("de");
+
+    string text = " spin -spin spin- spin-1 DE de i.e. ";
+    TextTagList found = matcher.find(tags(text));
+    BOOST_REQUIRE_EQUAL(found.size(), 4u);
+    BOOST_CHECK(found[0] == TextTag(TextTag::TT_LITERAL, 1, 5, "spin"));
+    BOOST_CHECK(found[1] == TextTag(TextTag::TT_LITERAL, 18, 24, "spin1."));
+    BOOST_CHECK(found[2] == TextTag(TextTag::TT_LITERAL, 25, 27, "D.E."));
+    BOOST_CHECK(found[3] == TextTag(TextTag::TT_LITERAL, 31, 35, "I.E."));
+
+    BOOST_CHECK_EQUAL(replaceLiterals(text, found),
+                      " spin -spin spin- spin1. D.E. de I.E. ");
+}
+
+BOOST_FIXTURE_TEST_CASE( literals_replacement, LiteralsFixture )
+{
+    ReplacementTemplate href("\\href{%l}{%t}");
+    BOOST_CHECK_EQUAL(href.expand("spin1.", "Spin-1"),
+                      "\\href{spin1.}{Spin-1}");
+    BOOST_CHECK_EQUAL(ReplacementTemplate("%t 100%% %x%").expand("a", "b"),
+                      "b 100% %x%");
+    BOOST_CHECK_EQUAL(ReplacementTemplate().expand("a", "b"), "b");
+
+    string text = "a spin and Spin-1.";
+    TextTagList found;
+    found.push_back(TextTag(TextTag::TT_LITERAL, 2, 6, "spin"));
+    found.push_back(TextTag(TextTag::TT_WORD, 7, 10, "and"));
+    found.push_back(TextTag(TextTag::TT_LITERAL, 11, 17, "spin1."));
+
+    std::ostringstream out;
+    size_t written = writeReplacedLiterals(out, text.data(), text.size(),
+                                           found, href);
+    BOOST_CHECK_EQUAL(out.str(),
+            "a \\href{spin}{spin} and \\href{spin1.}{Spin-1}.");
+    BOOST_CHECK_EQUAL(written, out.str().size());
+
+    // Overlapping tags and tags past the end are left out
+    found.push_back(TextTag(TextTag::TT_LITERAL, 15, 17, "x"));
+    found.push_back(TextTag(TextTag::TT_LITERAL, 17, 30, "y"));
+    std::ostringstream out2;
+    writeReplacedLiterals(out2, text.data(), text.size(), found, href);
+    BOOST_CHECK_EQUAL(out2.str(), out.str());
+
+    write("src/a.tex", text);
+    write("src/empty.tex", "");
+    BOOST_CHECK_EQUAL(writeReplacedFile(path("src/a.tex"),
+                        path("out/sub/a.tex"), found, href),
+                      long(written));
+    fs::ifstream result(fs::path(path("out/sub/a.tex")));
+    std::ostringstream content;
+    content << result.rdbuf();
+    BOOST_CHECK_EQUAL(content.str(), out.str());
+
+    BOOST_CHECK_EQUAL(writeReplacedFile(path("src/empty.tex"),
+                        path("out/empty.tex"), found, href), 0);
+    BOOST_CHECK(fs::exists(path("out/empty.tex")));
+    BOOST_CHECK_EQUAL(writeReplacedFile(path("src/none.tex"),
+                        path("out/none.tex"), found, href), -1);
+}
+
+BOOST_FIXTURE_TEST_CASE( literals_compile_concepts, LiteralsFixture )
+{
+    BOOST_REQUIRE(compileConcepts(path("concepts"), path("index"),
+                                  words.get(), &stemmer));
+    BOOST_CHECK(!compileConcepts(path("nonexistent"), path("index2"),
+                                  words.get(), &stemmer));
+
+    LiteralMatcher matcher(words.get(), &stemmer);
+    BOOST_REQUIRE(matcher.load(path("index")));
+    BOOST_CHECK_EQUAL(matcher.size(), 6u);
+    BOOST_CHECK(matcher.contains(norm("spin")));
+    BOOST_CHECK(matcher.contains(norm("spin-1")));
+    BOOST_CHECK(matcher.contains(norm("de")));
+    BOOST_CHECK(matcher.contains(norm("su(2)")));
+    BOOST_CHECK(matcher.contains(norm("hello world")));
+
+    // Matches never start with an article
+    string text = "the spins of hello-world";
+    TextTagList found = matcher.find(tags(text));
+    BOOST_REQUIRE_EQUAL(found.size(), 2u);
+    BOOST_CHECK(found[0] == TextTag(TextTag::TT_LITERAL, 4, 9, "spin"));
+    BOOST_CHECK(found[1] == TextTag(TextTag::TT_LITERAL, 13, 24,
+                                    "helloworld"));
+
+    // The index only loads with the dictionary it was built with,
+    // compiled or not
+    BOOST_REQUIRE(WordsDict::compile(path("words"), path("words.bin"), 6));
+    WordsDict compiled(path("words.bin"), 4);
+    LiteralMatcher compiledMatcher(&compiled, &stemmer);
+    BOOST_CHECK(compiledMatcher.load(path("index")));
+    BOOST_CHECK(compiledMatcher.error().empty());
+
+    WordsDict shorter(path("words"), 3);
+    LiteralMatcher shorterMatcher(&shorter, &stemmer);
+    BOOST_CHECK(!shorterMatcher.load(path("index")));
+    BOOST_CHECK(!shorterMatcher.error().empty());
+
+    WordsDict other(path("words"), 4);
+    other.insert("spn");
+    LiteralMatcher otherMatcher(&other, &stemmer);
+    BOOST_CHECK(!otherMatcher.load(path("index")));
+    BOOST_CHECK(!otherMatcher.error().empty());
+    BOOST_CHECK_EQUAL(otherMatcher.size(), 0u);
+
+    // Damaged indexes are errors, other files are not indexes
+    fs::ifstream in(fs::path(path("index")));
+    std::ostringstream data;
+    data << in.rdbuf();
+    write("truncated", data.str().substr(0, 20));
+    BOOST_CHECK(!matcher.load(path("truncated")));
+    BOOST_CHECK(!matcher.error().empty());
+    BOOST_CHECK(!matcher.load(path("concepts")));
+    BOOST_CHECK(matcher.error().empty());
+    BOOST_CHECK_EQUAL(matcher.size(), 6u);
+}
+
+BOOST_FIXTURE_TEST_CASE( literals_pipeline, LiteralsFixture )
+{
+    write("doc/main.tex", "The spin of the electron.\n"
+                          "Spin-1 systems and DE.\n"
+                          "\\bye\n");
+
+    LiteralMatcher matcher(words.get(), &stemmer);
+    matcher.insert("spin");
+    matcher.insert("spin1.");
+    matcher.insert("electron");
+    for(const char* const* n = KNOWN_NOT_LITERALS; *n; ++n)
+        matcher.insertNotLiteral(*n);
+
+    Pipeline pipeline(&matcher, EXCLUDED_ENVIRONMENTS, "testhref");
+    PipelineReport report = pipeline.run(path("doc/main.tex"), path("out"));
+
+    BOOST_CHECK(report.errors.empty());
+    BOOST_CHECK_EQUAL(report.files, 1u);
+    BOOST_CHECK_EQUAL(report.literals, 3u);
+    BOOST_CHECK_EQUAL(report.foundLiterals["spin"], 1u);
+    BOOST_CHECK_EQUAL(report.foundLiterals["spin1."], 1u);
+    BOOST_CHECK_EQUAL(report.bytesRead, 54u);
+    BOOST_CHECK_EQUAL(report.stage("parseDocument").count, 1u);
+    BOOST_CHECK_EQUAL(report.stage("writeSourceFile").count, 1u);
+
+    fs::ifstream out(fs::path(path("out/main.tex")));
+    std::ostringstream result;
+    result << out.rdbuf();
+    BOOST_CHECK_EQUAL(result.str(),
+            "The \\testhref{spin}{spin} of the "
+            "\\testhref{electron}{electron}.\n"
+            "\\testhref{spin1.}{Spin-1} systems and DE.\n"
+            "\\bye\n");
+    BOOST_CHECK_EQUAL(report.bytesWritten, result.str().size());
+
+    PipelineReport missing = pipeline.run(path("doc/none.tex"), path("out"));
+    BOOST_CHECK_EQUAL(missing.errors.size(), 1u);
+    BOOST_CHECK_EQUAL(missing.files, 0u);
+}
+
+BOOST_FIXTURE_TEST_CASE( literals_text_columns, LiteralsFixture )
+{
+    write("doc/main.tex", "The spin of the electron.\n"
+                          "Spin-1 systems and DE.\n"
+                          "\\bye\n");
+
+    LiteralMatcher matcher(words.get(), &stemmer);
+    matcher.insert("spin");
+    matcher.insert("spin1.");
+    matcher.insert("electron");
+
+    Pipeline pipeline(&matcher);
+    PipelineReport report;
+    texpp::Node::ptr document = pipeline.parse(path("doc/main.tex"), report);
+    BOOST_REQUIRE(document);
+
+    boost::regex rx(EXCLUDED_ENVIRONMENTS, boost::regex::extended);
+    TextTagsMap lists;
+    TextColumnsMap columns;
+    extractTextInfo(lists, document, rx, path("doc"));
+    extractTextColumns(columns, document, rx, path("doc"));
+
+    BOOST_REQUIRE_EQUAL(lists.size(), 1u);
+    BOOST_REQUIRE_EQUAL(columns.size(), 1u);
+    const TextTagList& list = lists["main.tex"];
+    const TextTagColumns& cols = columns["main.tex"];
+
+    BOOST_REQUIRE_EQUAL(cols.size(), list.size());
+    BOOST_CHECK_EQUAL(cols.valueOffsets().size(), list.size() + 1);
+    BOOST_CHECK(cols.tags() == list);
+    BOOST_CHECK(TextTagColumns(list).tags() == list);
+    BOOST_CHECK_EQUAL(cols.value(0), "The");
+    BOOST_CHECK_EQUAL(cols.type(0), int(TextTag::TT_WORD));
+
+    TextTagList found = matcher.find(cols);
+    BOOST_CHECK(found == matcher.find(list));
+    BOOST_CHECK_EQUAL(found.size(), 3u);
+}
+
+static void collectResult(std::map<string, BatchResult>* results,
+                          const BatchResult& result)
+{
+    (*results)[BatchDriver::articleName(result.input)] = result;
+}
+
+BOOST_FIXTURE_TEST_CASE( literals_batch, LiteralsFixture )
+{
+    BOOST_CHECK_EQUAL(BatchDriver::articleName("/a/b/1234.tar.gz"), "1234");
+    BOOST_CHECK_EQUAL(BatchDriver::articleName("a/5678.gz"), "5678");
+    BOOST_CHECK_EQUAL(BatchDriver::articleName("a/dir/"), "dir");
+    BOOST_CHECK_EQUAL(BatchDriver::articleName("a/dir/."), "dir");
+    BOOST_CHECK_EQUAL(BatchDriver::articleName("a/dir/b/.."), "dir");
+    BOOST_CHECK_EQUAL(BatchDriver::articleName("."),
+                      fs::current_path().filename().string());
+
+    std::vector<string> inputs;
+    for(int n = 0; n < 5; ++n) {
+        string name = "corpus/a" + boost::lexical_cast<string>(n);
+        write(name + "/notes.tex", "The spin.\n");
+        write(name + "/paper.tex", "\\documentclass{article}\n"
+                                   "The spin of the electron.\n");
+        inputs.push_back(path(name));
+    }
+    write("corpus/empty/notes.tex", "The spin.\n");
+    inputs.push_back(path("corpus/empty"));
+    inputs.push_back(path("corpus/none.tar.gz"));
+
+    LiteralMatcher matcher(words.get(), &stemmer);
+    matcher.insert("spin");
+    matcher.insert("electron");
+    Pipeline pipeline(&matcher);
+
+    std::map<string, BatchResult> results;
+    BatchDriver driver(&pipeline, 3);
+    BOOST_CHECK_EQUAL(driver.threads(), 3u);
+    driver.run(inputs, path("out"), boost::bind(&collectResult, &results, _1));
+
+    BOOST_REQUIRE_EQUAL(results.size(), inputs.size());
+    for(int n = 0; n < 5; ++n) {
+        const BatchResult& r = results["a" + boost::lexical_cast<string>(n)];
+        BOOST_CHECK(r.ok());
+        BOOST_CHECK_EQUAL(r.mainFile, "paper.tex");
+        BOOST_CHECK_EQUAL(r.report.literals, 2u);
+        BOOST_CHECK(fs::exists(fs::path(r.outputDir) / "paper.tex"));
+    }
+    BOOST_CHECK(!results["empty"].ok());
+    BOOST_CHECK(!results["none"].ok());
+    BOOST_CHECK_EQUAL(results["none"].report.errors.size(), 1u);
+    BOOST_CHECK(results["a0"].json().find("\"ok\": true") != string::npos);
+}
+
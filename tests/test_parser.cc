@@ -24,9 +24,22 @@
 
 #include <texpp/parser.h>
 #include <texpp/logger.h>
+#include <texpp/asynclogger.h>
+#include <texpp/nodetable.h>
+#include <texpp/nodequery.h>
+#include <texpp/profiler.h>
+#include <texpp/prefetch.h>
+#include <texpp/outputsink.h>
 #include <texpp/command.h>
+#include <texpp/latex/latex.h>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
 #include <iostream>
 #include <sstream>
+#include <fstream>
+#include <cstdlib>
+#include <algorithm>
+#include <unistd.h>
 
 using namespace texpp;
 
@@ -355,3 +368,449 @@ BOOST_AUTO_TEST_CASE( parser_expansion )
         BOOST_CHECK_EQUAL(tokens[0]->repr(), token.repr());
 }
 
+
+BOOST_AUTO_TEST_CASE( parser_node_table )
+{
+    shared_ptr<Parser> parser = create_parser("ab{c}");
+    parser->lexer()->setCatcode('{', Token::CC_BGROUP);
+    parser->lexer()->setCatcode('}', Token::CC_EGROUP);
+
+    Node::ptr document = parser->parse();
+    NodeTable table(document);
+
+    // Walk the tree in the same pre-order as the table
+    vector<Node::ptr> nodes;
+    vector<Node::ptr> stack(1, document);
+    while(!stack.empty()) {
+        Node::ptr node = stack.back(); stack.pop_back();
+        nodes.push_back(node);
+        for(size_t n = node->childrenCount(); n > 0; --n)
+            stack.push_back(node->child(n-1));
+    }
+
+    BOOST_REQUIRE_EQUAL(table.size(), nodes.size());
+    BOOST_REQUIRE_EQUAL(table.valueOffsets().size(), nodes.size()+1);
+    BOOST_CHECK_EQUAL(table.parents()[0], -1);
+    BOOST_CHECK_EQUAL(table.roles()[0], -1);
+
+    for(size_t i = 0; i < nodes.size(); ++i) {
+        BOOST_CHECK_EQUAL(table.typeNames()[table.types()[i]],
+                          nodes[i]->type());
+
+        std::pair<size_t, size_t> pos = nodes[i]->sourcePos();
+        BOOST_CHECK_EQUAL(table.starts()[i], pos.first == Token::npos ?
+                            NodeTable::Offset(-1) : NodeTable::Offset(pos.first));
+        BOOST_CHECK_EQUAL(table.ends()[i], pos.second == Token::npos ?
+                            NodeTable::Offset(-1) : NodeTable::Offset(pos.second));
+
+        BOOST_CHECK_EQUAL(table.valuePool().substr(table.valueOffsets()[i],
+                    table.valueOffsets()[i+1] - table.valueOffsets()[i]),
+                    nodes[i]->valueString());
+
+        if(i > 0) {
+            NodeTable::Index parent = table.parents()[i];
+            BOOST_REQUIRE(parent >= 0 && size_t(parent) < i);
+            const Node::ChildrenList& siblings = nodes[parent]->children();
+            bool found = false;
+            for(size_t n = 0; n < siblings.size(); ++n) {
+                if(siblings[n].second == nodes[i]) {
+                    BOOST_CHECK_EQUAL(table.roleNames()[table.roles()[i]],
+                                      siblings[n].first);
+                    found = true;
+                }
+            }
+            BOOST_CHECK(found);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( parser_async_logger )
+{
+    int fds[2];
+    BOOST_REQUIRE_EQUAL(pipe(fds), 0);
+
+    shared_ptr<Parser> parser = create_parser("");
+    {
+        AsyncLogger logger(fds[1], 16);
+        BOOST_CHECK_EQUAL(logger.bufferSize(), 16);
+
+        logger.log(Logger::MESSAGE, "hello", *parser, Token::ptr());
+        logger.log(Logger::MESSAGE, "does not fit in the buffer",
+                                        *parser, Token::ptr());
+        logger.flush();
+
+        BOOST_CHECK(logger.good());
+        BOOST_CHECK_EQUAL(logger.queued(), 1);
+        BOOST_CHECK_EQUAL(logger.dropped(), 1);
+        BOOST_CHECK_EQUAL(logger.droppedBytes(), 27);
+    }
+    close(fds[1]);
+
+    string output;
+    char buf[64];
+    ssize_t n;
+    while((n = read(fds[0], buf, sizeof(buf))) > 0)
+        output.append(buf, n);
+    close(fds[0]);
+
+    BOOST_CHECK_EQUAL(output, "hello\n");
+}
+
+BOOST_AUTO_TEST_CASE( parser_profiler )
+{
+    shared_ptr<Parser> parser = create_parser(
+                "\\def\\a{xy}\\edef\\b{\\a\\a}\\b");
+    parser->lexer()->setCatcode('{', Token::CC_BGROUP);
+    parser->lexer()->setCatcode('}', Token::CC_EGROUP);
+
+    Profiler::ptr profiler(new Profiler);
+    parser->setProfiler(profiler);
+    parser->parse();
+
+    std::map<string, Profiler::Entry> entries;
+    BOOST_FOREACH(const Profiler::Entry& e, profiler->entries())
+        entries[e.name] = e;
+
+    BOOST_CHECK_EQUAL(entries["\\def"].count, 1);
+    BOOST_CHECK_EQUAL(entries["\\edef"].count, 1);
+    BOOST_CHECK_EQUAL(entries["\\a"].count, 2);
+    BOOST_CHECK_EQUAL(entries["\\a"].tokens, 4);
+    BOOST_CHECK_EQUAL(entries["\\a"].maxDepth, 1);
+    BOOST_CHECK_EQUAL(entries["\\b"].count, 1);
+    BOOST_CHECK_EQUAL(entries["\\b"].tokens, 4);
+
+    BOOST_FOREACH(const Profiler::Entry& e, profiler->entries()) {
+        BOOST_CHECK(e.exclusive <= e.inclusive);
+        BOOST_CHECK_EQUAL(e.depth, 0);
+    }
+
+    // \a is expanded inside \edef
+    BOOST_CHECK(entries["\\edef"].inclusive >= entries["\\a"].inclusive);
+    BOOST_CHECK(profiler->report().find("\\edef") != string::npos);
+}
+
+
+BOOST_AUTO_TEST_CASE( parser_prefetch )
+{
+    string text = "\\input a \\input{b.tex}% \\input c\n"
+        "\\input{\\jobname.aux}\\%\\input\\x\\include{d}\\inputx e";
+    vector<string> names = Prefetcher::inputNames(text.data(), text.size());
+    BOOST_REQUIRE_EQUAL(names.size(), 3);
+    BOOST_CHECK_EQUAL(names[0], "a");
+    BOOST_CHECK_EQUAL(names[1], "b.tex");
+    BOOST_CHECK_EQUAL(names[2], "d");
+
+    char dirTemplate[] = "/tmp/texpp-prefetch-XXXXXX";
+    BOOST_REQUIRE(mkdtemp(dirTemplate));
+    string dir = dirTemplate;
+    std::ofstream(string(dir + "/main.tex").c_str()) << "\\input sub\n";
+    std::ofstream(string(dir + "/sub.tex").c_str()) << "\\input deep\n";
+    std::ofstream(string(dir + "/deep.tex").c_str()) << "x\n";
+
+    // Files named in the main document are found through TEXINPUTS
+    setenv("TEXINPUTS", ".", 1);
+
+    Prefetcher::ptr prefetcher(new Prefetcher(true));
+    prefetcher->prefetch(dir + "/main.tex", dir);
+    prefetcher->wait();
+    BOOST_CHECK_EQUAL(prefetcher->loadedBytes(), 11 + 12 + 2);
+
+    shared_ptr<std::istream> file = prefetcher->open(dir + "/main.tex");
+    BOOST_REQUIRE(file);
+
+    Parser parser(dir + "/main.tex", file, dir, false, true,
+                    shared_ptr<Logger>(new TestLogger));
+    parser.setPrefetcher(prefetcher);
+    parser.parse();
+
+    BOOST_CHECK_EQUAL(prefetcher->hits(), 3);
+    BOOST_CHECK_EQUAL(prefetcher->misses(), 0);
+    BOOST_CHECK_EQUAL(prefetcher->loadedBytes(), 0);
+
+    // Contents are handed out once, later opens read the disk
+    BOOST_CHECK(!prefetcher->open(dir + "/main.tex"));
+    BOOST_CHECK(!parser.openFile(dir + "/main.tex")->fail());
+    BOOST_CHECK_EQUAL(prefetcher->misses(), 2);
+
+    unlink(string(dir + "/main.tex").c_str());
+    unlink(string(dir + "/sub.tex").c_str());
+    unlink(string(dir + "/deep.tex").c_str());
+    rmdir(dir.c_str());
+}
+
+BOOST_AUTO_TEST_CASE( parser_output_sink )
+{
+    shared_ptr<Parser> parser = create_parser(
+                "\\immediate\\openout1=test.aux "
+                "\\immediate\\write1{a}\\immediate\\write1{b}"
+                "\\immediate\\closeout1"
+                "\\immediate\\openout2=other.aux "
+                "\\immediate\\write2{c}");
+    parser->lexer()->setCatcode('{', Token::CC_BGROUP);
+    parser->lexer()->setCatcode('}', Token::CC_EGROUP);
+
+    shared_ptr<MemoryOutputSink> sink(new MemoryOutputSink);
+    parser->setOutputSink(sink);
+    parser->parse();
+
+    vector<string> fileNames = sink->fileNames();
+    BOOST_REQUIRE_EQUAL(fileNames.size(), 2);
+    BOOST_CHECK_EQUAL(fileNames[0], "other.aux");
+    BOOST_CHECK_EQUAL(fileNames[1], "test.aux");
+
+    BOOST_CHECK_EQUAL(sink->contents("test.aux"), "a\nb\n");
+    BOOST_CHECK_EQUAL(sink->contents("other.aux"), "c\n");
+    BOOST_CHECK(!sink->exists("missing.aux"));
+}
+
+// Tree and written files of text, as parsed by a fresh parser
+string parse_result(const string& text)
+{
+    shared_ptr<Parser> parser = create_parser(text);
+    parser->lexer()->setCatcode('{', Token::CC_BGROUP);
+    parser->lexer()->setCatcode('}', Token::CC_EGROUP);
+    shared_ptr<MemoryOutputSink> sink(new MemoryOutputSink);
+    parser->setOutputSink(sink);
+
+    string result = parser->parse()->treeRepr();
+    BOOST_FOREACH(const string& fileName, sink->fileNames())
+        result += fileName + ": " + sink->contents(fileName) + "\n";
+    return result;
+}
+
+void parse_results(const string* text, vector<string>* results)
+{
+    for(size_t n = 0; n < results->size(); ++n)
+        (*results)[n] = parse_result(*text);
+}
+
+BOOST_AUTO_TEST_CASE( parser_concurrent )
+{
+    // Keywords and file names are parsed by every thread at once
+    string text =
+        "\\dimen0=1em \\dimen2=3truept \\dimen4=2cm "
+        "\\setbox0=\\hbox spread 1pt{a}\\setbox1=\\vbox to 2pt{}"
+        "\\immediate\\openout1=test.aux \\immediate\\write1{b}"
+        "\\immediate\\openin2=none.tex "
+        "\\font\\x=none at 5pt Text.";
+    string expected = parse_result(text);
+    BOOST_CHECK(expected.find("test.aux: b\n") != string::npos);
+
+    const size_t threads = 8;
+    vector< vector<string> > results(threads, vector<string>(10));
+    boost::thread_group group;
+    for(size_t n = 0; n < threads; ++n)
+        group.create_thread(boost::bind(&parse_results, &text, &results[n]));
+    group.join_all();
+
+    for(size_t n = 0; n < threads; ++n)
+        for(size_t m = 0; m < results[n].size(); ++m)
+            BOOST_CHECK_EQUAL(results[n][m], expected);
+}
+
+BOOST_AUTO_TEST_CASE( parser_reparse )
+{
+    string text =
+        "\\catcode`\\{=1 \\catcode`\\}=2\n"
+        "\\def\\a{A}\n"
+        "First paragraph \\a.\n"
+        "\n"
+        "\\count1=1\n"
+        "Second {paragraph} here.\n"
+        "\n"
+        "\\def\\b{B}\\b\n"
+        "Third paragraph.\n";
+
+    shared_ptr<Parser> parser = create_parser(text);
+    parser->setCheckpointInterval(1);
+    Node::ptr document = parser->parse();
+    BOOST_REQUIRE(parser->checkpointsCount() > 2);
+    BOOST_CHECK_EQUAL(parser->checkpointPos(0), 0);
+    Node::ptr firstChild = document->child(0);
+
+    // Replace "1" in "\count1=1"
+    size_t editBegin = text.find("=1\n") + 1;
+    string edited = text.substr(0, editBegin) + "22" +
+                        text.substr(editBegin + 1);
+
+    Node::ptr redocument = parser->reparse(
+        shared_ptr<std::istream>(new std::istringstream(edited)), editBegin);
+    BOOST_REQUIRE(redocument);
+    BOOST_CHECK(redocument->child(0) == firstChild);
+    BOOST_CHECK_EQUAL(parser->symbol("count1", int(0)), 22);
+
+    shared_ptr<Parser> fresh = create_parser(edited);
+    Node::ptr expected = fresh->parse();
+    BOOST_CHECK_EQUAL(redocument->treeRepr(), expected->treeRepr());
+    BOOST_CHECK_EQUAL(redocument->source(), edited);
+
+    // Edits at the very beginning and at the very end
+    Node::ptr redocument1 = parser->reparse(
+        shared_ptr<std::istream>(new std::istringstream("x" + edited)), 0);
+    BOOST_CHECK_EQUAL(redocument1->source(), "x" + edited);
+
+    Node::ptr redocument2 = parser->reparse(
+        shared_ptr<std::istream>(new std::istringstream(
+                "x" + edited + "More.\n")), edited.size() + 1);
+    BOOST_CHECK_EQUAL(redocument2->source(), "x" + edited + "More.\n");
+    BOOST_CHECK_EQUAL(redocument2->treeRepr(), create_parser(
+                "x" + edited + "More.\n")->parse()->treeRepr());
+}
+
+static void collect_types(Node::ptr node, vector<string>& types)
+{
+    types.push_back(node->type());
+    for(size_t n = 0; n < node->childrenCount(); ++n)
+        collect_types(node->child(n), types);
+}
+
+BOOST_AUTO_TEST_CASE( parser_latex_style )
+{
+    string input =
+        "\\documentclass[12pt]{article}\n"
+        "\\usepackage[latin1]{inputenc}\n"
+        "\\newcommand{\\foo}[1][x]{bar}\n"
+        "\\begin{document}\n"
+        "Text \\( x \\) and \\begin{equation}y\\end{equation} done.\n"
+        "\\end{document}\n";
+
+    shared_ptr<std::istream> ifile(new std::istringstream(input));
+    Parser parser("", ifile, "", false, false,
+                  shared_ptr<Logger>(new TestLogger), Parser::STYLE_LATEX);
+    BOOST_CHECK_EQUAL(parser.style(), Parser::STYLE_LATEX);
+    BOOST_CHECK_EQUAL(create_parser("")->style(), Parser::STYLE_PLAIN);
+    BOOST_CHECK_EQUAL(parser.symbol("catcode123", int(0)),
+                      int(Token::CC_BGROUP));
+
+    Node::ptr document = parser.parse();
+    BOOST_CHECK_EQUAL(document->source(), input);
+
+    vector<string> types;
+    collect_types(document, types);
+    BOOST_CHECK(std::count(types.begin(), types.end(),
+                           "environment_document") == 1);
+    BOOST_CHECK(std::count(types.begin(), types.end(),
+                           "environment_equation") == 1);
+    BOOST_CHECK(std::count(types.begin(), types.end(), "inputenc") == 1);
+
+    for(size_t n = 0; n < document->childrenCount(); ++n) {
+        Node::ptr child = document->child(n);
+        if(child->type() == "inputenc")
+            BOOST_CHECK_EQUAL(child->valueString(), "latin1");
+    }
+
+    // \newcommand is only recorded
+    BOOST_CHECK(!parser.symbol("\\foo", Command::ptr()));
+
+    Node::ptr arg = latex::parseOptionalArgs(*create_parser("  [a,b] c"));
+    BOOST_CHECK_EQUAL(arg->valueString(), "a,b");
+}
+
+Node::ptr add_node(Node::ptr parent, const string& type,
+                    const string& value = string())
+{
+    Node::ptr node(new Node(type));
+    if(!value.empty()) node->setValue(value);
+    parent->appendChild("child", node);
+    return node;
+}
+
+vector<string> query_values(const string& selector, Node::ptr root)
+{
+    NodeQuery query(selector);
+    BOOST_CHECK_MESSAGE(query.isValid(), selector + ": " + query.error());
+
+    vector<string> values;
+    BOOST_FOREACH(Node::ptr node, query.nodes(root))
+        values.push_back(node->valueString().empty() ?
+                            node->type() : node->valueString());
+    return values;
+}
+
+BOOST_AUTO_TEST_CASE( parser_node_query )
+{
+    Node::ptr root(new Node("document"));
+    Node::ptr group = add_node(root, "group");
+    add_node(group, "text_word", "a");
+    add_node(group, "text_space", " ");
+    add_node(group, "text_word", "b");
+    Node::ptr math = add_node(group, "environment_displaymath");
+    add_node(math, "text_word", "x");
+    add_node(group, "text_character", "c");
+    add_node(root, "text_word", "d");
+
+    const char* all[] = { "a", "b", "x", "d" };
+    vector<string> values = query_values("text_word", root);
+    BOOST_CHECK_EQUAL_COLLECTIONS(values.begin(), values.end(), all, all+4);
+
+    const char* top[] = { "d" };
+    values = query_values(" > text_word", root);
+    BOOST_CHECK_EQUAL_COLLECTIONS(values.begin(), values.end(), top, top+1);
+
+    const char* path[] = { "x" };
+    values = query_values("group>environment_* > text_word", root);
+    BOOST_CHECK_EQUAL_COLLECTIONS(values.begin(), values.end(),
+                                  path, path+1);
+
+    const char* text[] = { "a", "b", "d" };
+    values = query_values("text_word:not-under( *math* )", root);
+    BOOST_CHECK_EQUAL_COLLECTIONS(values.begin(), values.end(),
+                                  text, text+3);
+    BOOST_CHECK(query_values("group text_word:not-under(environment_*)",
+                             root).size() == 2);
+
+    const char* other[] = { "group", "environment_displaymath" };
+    values = query_values("!text_*", root);
+    BOOST_CHECK_EQUAL_COLLECTIONS(values.begin(), values.end(),
+                                  other, other+2);
+
+    // Escaped names match literally
+    Node::ptr odd = add_node(root, "odd*name|(x)");
+    add_node(odd, "text_word", "e");
+    BOOST_CHECK_EQUAL(NodeQuery::escape("odd*name|(x)"),
+                      "odd\\*name\\|\\(x\\)");
+    const char* escaped[] = { "e" };
+    values = query_values(NodeQuery::escape("odd*name|(x)") + " > text_word",
+                          root);
+    BOOST_CHECK_EQUAL_COLLECTIONS(values.begin(), values.end(),
+                                  escaped, escaped+1);
+    BOOST_CHECK(query_values("odd\\*", root).empty());
+    BOOST_CHECK(query_values(NodeQuery::escape("group") + " > text_word",
+                             root).size() == 2);
+    root->children().pop_back();
+
+    // Runs of siblings
+    NodeQuery runs("group > text_word|text_space|text_character+");
+    vector<NodeQuery::Match> matches = runs.select(root);
+    BOOST_REQUIRE_EQUAL(matches.size(), 2u);
+    BOOST_CHECK(matches[0].parent == group);
+    BOOST_CHECK_EQUAL(matches[0].index, 0u);
+    BOOST_CHECK_EQUAL(matches[0].count, 3u);
+    BOOST_CHECK_EQUAL(matches[1].index, 4u);
+    BOOST_CHECK_EQUAL(matches[1].count, 1u);
+
+    // Invalid selectors match nothing
+    const char* invalid[] = { "", "group >", "a+ b", "a:not-under(b",
+                              "a|", "a:b", "a\\" };
+    for(size_t n = 0; n < sizeof(invalid)/sizeof(invalid[0]); ++n) {
+        NodeQuery query(invalid[n]);
+        BOOST_CHECK_MESSAGE(!query.isValid(), invalid[n]);
+        BOOST_CHECK(!query.error().empty());
+        BOOST_CHECK(query.select(root).empty());
+    }
+
+    // Spans are the source positions of the matches
+    shared_ptr<Parser> parser = create_parser("ab {c}d");
+    parser->lexer()->setCatcode('{', Token::CC_BGROUP);
+    parser->lexer()->setCatcode('}', Token::CC_EGROUP);
+    Node::ptr document = parser->parse();
+
+    NodeQuery any("*");
+    vector<Node::ptr> nodes = any.nodes(document);
+    vector< std::pair<size_t, size_t> > spans = any.spans(document);
+    BOOST_REQUIRE_EQUAL(nodes.size(), spans.size());
+    BOOST_CHECK(!nodes.empty());
+    for(size_t n = 0; n < nodes.size(); ++n) {
+        BOOST_CHECK(nodes[n]->sourcePos() == spans[n]);
+    }
+}
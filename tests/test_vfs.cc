@@ -0,0 +1,161 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#define BOOST_TEST_MODULE vfs_test_suite
+#include <boost/test/included/unit_test.hpp>
+
+#include <texpp/vfs.h>
+#include <texpp/parser.h>
+#include <texpp/logger.h>
+
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+#include <zlib.h>
+
+using namespace texpp;
+
+// Appends a ustar member to an archive being built in memory
+void appendTarMember(string& tar, const string& name, const string& data)
+{
+    char header[512];
+    std::memset(header, 0, sizeof(header));
+    std::strncpy(header, name.c_str(), 100);
+    std::sprintf(header + 100, "%07o", 0644);
+    std::sprintf(header + 108, "%07o", 0);
+    std::sprintf(header + 116, "%07o", 0);
+    std::sprintf(header + 124, "%011o", unsigned(data.size()));
+    std::sprintf(header + 136, "%011o", 0);
+    std::memset(header + 148, ' ', 8);
+    header[156] = '0';
+    std::memcpy(header + 257, "ustar", 6);
+    std::memcpy(header + 263, "00", 2);
+
+    unsigned sum = 0;
+    for(size_t n = 0; n < sizeof(header); ++n)
+        sum += (unsigned char) header[n];
+    std::sprintf(header + 148, "%06o", sum);
+
+    tar.append(header, sizeof(header));
+    tar += data;
+    tar.append((512 - data.size() % 512) % 512, '\0');
+}
+
+string readAll(shared_ptr<std::istream> stream)
+{
+    std::ostringstream result;
+    if(stream) result << stream->rdbuf();
+    return result.str();
+}
+
+string writeGzip(const string& data)
+{
+    char tmpl[] = "/tmp/texpp_vfs_XXXXXX";
+    int fd = mkstemp(tmpl);
+    close(fd);
+
+    gzFile file = gzopen(tmpl, "wb");
+    gzwrite(file, data.data(), unsigned(data.size()));
+    gzclose(file);
+    return tmpl;
+}
+
+BOOST_AUTO_TEST_CASE( vfs_normalize_path )
+{
+    BOOST_CHECK_EQUAL(Vfs::normalizePath("a/./b//c"), "a/b/c");
+    BOOST_CHECK_EQUAL(Vfs::normalizePath("a/b/../c/"), "a/c");
+    BOOST_CHECK_EQUAL(Vfs::normalizePath("../a/.."), "..");
+    BOOST_CHECK_EQUAL(Vfs::normalizePath("/../a"), "/a");
+    BOOST_CHECK_EQUAL(Vfs::normalizePath("./"), "");
+}
+
+BOOST_AUTO_TEST_CASE( vfs_memory )
+{
+    MemoryVfs::ptr fallback(new MemoryVfs);
+    fallback->add("/texmf/style.sty", "style");
+
+    MemoryVfs::ptr vfs(new MemoryVfs(fallback));
+    vfs->add("doc/main.tex", "\\input sec/a \\input /texmf/style.sty ");
+    vfs->add("doc/sec/a.tex", "\\count1=5 ");
+    vfs->add("doc/sec/a", "no suffix");
+
+    BOOST_CHECK_EQUAL(vfs->resolve("sec/a", "doc"), "doc/sec/a.tex");
+    BOOST_CHECK_EQUAL(vfs->resolve("./sec/../main", "doc"), "doc/main.tex");
+    BOOST_CHECK_EQUAL(vfs->resolve("/texmf/style.sty", "doc"),
+                        "/texmf/style.sty");
+    BOOST_CHECK_EQUAL(vfs->resolve("missing", "doc"), "");
+
+    BOOST_CHECK_EQUAL(readAll(vfs->open("doc/sec/a")), "no suffix");
+    BOOST_CHECK_EQUAL(readAll(vfs->open("/texmf/style.sty")), "style");
+    BOOST_CHECK(!vfs->open("doc/missing.tex"));
+    BOOST_CHECK(vfs->exists("/texmf/style.sty"));
+
+    Parser parser("doc/main.tex", vfs->open("doc/main.tex"), "doc",
+                    false, true, shared_ptr<Logger>(new NullLogger));
+    parser.setVfs(vfs);
+    parser.parse();
+
+    BOOST_CHECK_EQUAL(parser.symbol("count1", int(0)), 5);
+}
+
+BOOST_AUTO_TEST_CASE( vfs_archive )
+{
+    string tar;
+    appendTarMember(tar, "main.tex", "\\input sections/intro");
+    appendTarMember(tar, "./sections/intro.tex", "intro");
+    appendTarMember(tar, "../outside.tex", "skipped");
+    tar.append(1024, '\0');
+
+    ArchiveVfs::ptr vfs(new ArchiveVfs);
+    shared_ptr<string> owner(new string(tar));
+    BOOST_REQUIRE(vfs->load(owner->data(), owner->size(), owner));
+
+    vector<string> names = vfs->fileNames();
+    BOOST_REQUIRE_EQUAL(names.size(), 2);
+    BOOST_CHECK_EQUAL(names[0], "main.tex");
+    BOOST_CHECK_EQUAL(names[1], "sections/intro.tex");
+    BOOST_CHECK_EQUAL(readAll(vfs->open(vfs->resolve("sections/intro", ""))),
+                        "intro");
+
+    // Compressed archive, read from a file
+    string tgz = writeGzip(tar);
+    ArchiveVfs::ptr vfs1(new ArchiveVfs);
+    BOOST_REQUIRE(vfs1->load(tgz, "article"));
+    BOOST_CHECK_EQUAL(vfs1->size(), 2);
+    BOOST_CHECK_EQUAL(readAll(vfs1->open("article/main.tex")),
+                        "\\input sections/intro");
+    unlink(tgz.c_str());
+
+    // Compressed single file
+    string gz = writeGzip("\\documentclass{article}");
+    ArchiveVfs::ptr vfs2(new ArchiveVfs);
+    BOOST_REQUIRE(vfs2->load(gz));
+    BOOST_CHECK_EQUAL(readAll(vfs2->open("main.tex")),
+                        "\\documentclass{article}");
+    unlink(gz.c_str());
+
+    // Neither tar nor gzip
+    ArchiveVfs::ptr vfs3(new ArchiveVfs);
+    shared_ptr<string> text(new string(1024, 'x'));
+    BOOST_CHECK(!vfs3->load(text->data(), text->size(), text));
+    BOOST_CHECK(!vfs3->load("/nonexistent/archive.tar"));
+}
+
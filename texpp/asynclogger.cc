@@ -0,0 +1,169 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <texpp/asynclogger.h>
+
+#include <boost/bind.hpp>
+
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+// Upper bound on the time a message may stay in the buffer when the
+// writer misses a wakeup
+const long WRITER_POLL_MS = 50;
+} // namespace
+
+namespace texpp {
+
+AsyncLogger::AsyncLogger(int fd, size_t bufferSize)
+    : m_fd(fd), m_ownFd(false)
+{
+    start(bufferSize);
+}
+
+AsyncLogger::AsyncLogger(const string& fileName, size_t bufferSize)
+    : m_fd(::open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666)),
+      m_ownFd(true)
+{
+    start(bufferSize);
+}
+
+void AsyncLogger::start(size_t bufferSize)
+{
+    m_capacity = 1;
+    while(m_capacity < bufferSize) m_capacity <<= 1;
+    m_buffer.reset(new char[m_capacity]);
+
+    m_head = 0;
+    m_tail = 0;
+    m_stop = false;
+    m_good = m_fd >= 0;
+
+    m_queued = 0;
+    m_dropped = 0;
+    m_droppedBytes = 0;
+
+    if(m_good)
+        m_thread = boost::thread(boost::bind(&AsyncLogger::run, this));
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    if(m_linePos) {
+        write(string(1, '\n'));
+        m_linePos = 0;
+    }
+
+    if(m_thread.joinable()) {
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_stop = true;
+        }
+        m_wakeup.notify_one();
+        m_thread.join();
+    }
+
+    if(m_ownFd && m_fd >= 0)
+        ::close(m_fd);
+}
+
+void AsyncLogger::write(const string& text)
+{
+    size_t size = text.size();
+    if(!size) return;
+
+    size_t head = m_head.load(boost::memory_order_relaxed);
+    size_t tail = m_tail.load(boost::memory_order_acquire);
+
+    if(!m_good || size > m_capacity - (head - tail)) {
+        ++m_dropped;
+        m_droppedBytes += size;
+        return;
+    }
+
+    size_t pos = head & (m_capacity - 1);
+    size_t first = std::min(size, m_capacity - pos);
+    std::memcpy(m_buffer.get() + pos, text.data(), first);
+    std::memcpy(m_buffer.get(), text.data() + first, size - first);
+
+    m_head.store(head + size, boost::memory_order_release);
+    ++m_queued;
+
+    // The writer only sleeps on an empty buffer
+    if(head == tail)
+        m_wakeup.notify_one();
+}
+
+void AsyncLogger::flush()
+{
+    size_t head = m_head.load(boost::memory_order_relaxed);
+    if(!m_thread.joinable()) return;
+
+    m_wakeup.notify_one();
+    boost::mutex::scoped_lock lock(m_mutex);
+    while(m_tail.load(boost::memory_order_acquire) < head && m_good)
+        m_drained.wait(lock);
+}
+
+void AsyncLogger::run()
+{
+    for(;;) {
+        size_t tail = m_tail.load(boost::memory_order_relaxed);
+        size_t head = m_head.load(boost::memory_order_acquire);
+
+        if(head != tail) {
+            size_t pos = tail & (m_capacity - 1);
+            size_t size = head - tail;
+            size_t first = std::min(size, m_capacity - pos);
+            writeOut(m_buffer.get() + pos, first);
+            writeOut(m_buffer.get(), size - first);
+
+            m_tail.store(head, boost::memory_order_release);
+            { boost::mutex::scoped_lock lock(m_mutex); }
+            m_drained.notify_all();
+            continue;
+        }
+
+        boost::mutex::scoped_lock lock(m_mutex);
+        if(m_stop && m_head.load(boost::memory_order_acquire) == tail)
+            break;
+        if(m_head.load(boost::memory_order_acquire) == tail)
+            m_wakeup.timed_wait(lock,
+                    boost::posix_time::milliseconds(WRITER_POLL_MS));
+    }
+}
+
+void AsyncLogger::writeOut(const char* data, size_t size)
+{
+    while(size > 0 && m_good) {
+        ssize_t n = ::write(m_fd, data, size);
+        if(n < 0) {
+            if(errno == EINTR) continue;
+            m_good = false;
+            return;
+        }
+        data += n;
+        size -= n;
+    }
+}
+
+} // namespace texpp
+
@@ -0,0 +1,98 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __TEXPP_ASYNCLOGGER_H
+#define __TEXPP_ASYNCLOGGER_H
+
+#include <texpp/logger.h>
+
+#include <boost/atomic.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/scoped_array.hpp>
+
+namespace texpp {
+
+// ConsoleLogger that hands formatted messages to a background thread
+// instead of writing them synchronously. Messages are formatted in the
+// parser thread (formatting needs parser state) and copied into a
+// single-producer/single-consumer ring buffer which the writer thread
+// drains in large write() calls. When the buffer is full the message
+// is dropped as a whole and counted, the parser never blocks on output.
+//
+// Only one thread may log at a time, which is always the case for
+// loggers owned by a single Parser.
+class AsyncLogger: public ConsoleLogger
+{
+public:
+    typedef shared_ptr<AsyncLogger> ptr;
+
+    enum { DEFAULT_BUFFER_SIZE = 1 << 20 };
+
+    // Writes to the file descriptor fd, which is not closed
+    explicit AsyncLogger(int fd = 1,
+                size_t bufferSize = DEFAULT_BUFFER_SIZE);
+    // Writes to the file fileName, truncating it
+    explicit AsyncLogger(const string& fileName,
+                size_t bufferSize = DEFAULT_BUFFER_SIZE);
+    ~AsyncLogger();
+
+    // Waits until every message logged so far has been written
+    void flush();
+
+    // Counters, only meaningful in the logging thread
+    size_t bufferSize() const { return m_capacity; }
+    size_t queued() const { return m_queued; }
+    size_t dropped() const { return m_dropped; }
+    size_t droppedBytes() const { return m_droppedBytes; }
+
+    // Returns false if the output could not be opened or written
+    bool good() const { return m_good; }
+
+protected:
+    void write(const string& text);
+
+    void start(size_t bufferSize);
+    void run();
+    void writeOut(const char* data, size_t size);
+
+    int     m_fd;
+    bool    m_ownFd;
+
+    size_t  m_capacity;     // always a power of two
+    boost::scoped_array<char> m_buffer;
+    boost::atomic<size_t> m_head;   // advanced by the logging thread
+    boost::atomic<size_t> m_tail;   // advanced by the writer thread
+    boost::atomic<bool>   m_stop;
+    boost::atomic<bool>   m_good;
+
+    size_t  m_queued;
+    size_t  m_dropped;
+    size_t  m_droppedBytes;
+
+    boost::mutex m_mutex;
+    boost::condition_variable m_wakeup;
+    boost::condition_variable m_drained;
+    boost::thread m_thread;
+};
+
+} // namespace texpp
+
+#endif
+
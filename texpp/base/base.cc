@@ -539,12 +539,13 @@ void initSymbols(Parser& parser)
     parser.setSymbol("mag", int(1000));
     parser.setSymbol("maxdeadcycles", int(25));
 
+    // localtime_r since parsers may be created in several threads
     std::time_t t; std::time(&t);
-    std::tm* time = std::localtime(&t);
-    parser.setSymbol("year", int(1900+time->tm_year));
-    parser.setSymbol("month", int(1+time->tm_mon));
-    parser.setSymbol("day", int(time->tm_mday));
-    parser.setSymbol("time", int(time->tm_hour*60 + time->tm_min));
+    std::tm time; localtime_r(&t, &time);
+    parser.setSymbol("year", int(1900+time.tm_year));
+    parser.setSymbol("month", int(1+time.tm_mon));
+    parser.setSymbol("day", int(time.tm_mday));
+    parser.setSymbol("time", int(time.tm_hour*60 + time.tm_min));
 
     parser.setSymbol("hangafter", int(1));
 }
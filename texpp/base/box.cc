@@ -41,10 +41,11 @@ bool Lastbox::invokeOperation(Parser& parser,
 {
     if(parser.mode() == Parser::VERTICAL ||
                 parser.mode() == Parser::MATH) {
-        parser.logger()->log(Logger::ERROR,
-            "You can't use `" + texRepr(&parser) + "' in " +
-            parser.modeName() + " mode",
-            parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                "You can't use `" + texRepr(&parser) + "' in " +
+                parser.modeName() + " mode",
+                parser, parser.lastToken());
         return true;
     }
     return BoxVariable::invokeOperation(parser, node, op, global);
@@ -75,9 +76,10 @@ string Setbox::parseName(Parser& parser, shared_ptr<Node> node)
     int n = number->value(int(0));
 
     if(n < 0 || n > 255) {
-        parser.logger()->log(Logger::ERROR,
-            "Bad register code (" + boost::lexical_cast<string>(n) + ")",
-            parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                "Bad register code (" + boost::lexical_cast<string>(n) + ")",
+                parser, parser.lastToken());
         n = 0;
     }
 
@@ -123,11 +125,9 @@ bool BoxSpec::invokeOperation(Parser& parser,
     if(op == ASSIGN || op == GET) {
         string name = parseName(parser, node);
 
-        static vector<string> kw_spec;
-        if(kw_spec.empty()) {
-            kw_spec.push_back("to");
-            kw_spec.push_back("spread");
-        }
+        static const char* specs[] = { "to", "spread" };
+        static vector<string> kw_spec(specs,
+                specs + sizeof(specs)/sizeof(char*));
 
         Node::ptr spec = parser.parseOptionalKeyword(kw_spec);
         node->appendChild("spec_clause", spec);
@@ -177,12 +177,8 @@ bool BoxSpec::invokeOperation(Parser& parser,
 
 bool Rule::invoke(Parser& parser, shared_ptr<Node> node)
 {
-    static vector<string> kw_spec;
-    if(kw_spec.empty()) {
-        kw_spec.push_back("width");
-        kw_spec.push_back("height");
-        kw_spec.push_back("depth");
-    }
+    static const char* specs[] = { "width", "height", "depth" };
+    static vector<string> kw_spec(specs, specs + sizeof(specs)/sizeof(char*));
 
     while(true) {
         Node::ptr spec = parser.parseOptionalKeyword(kw_spec);
@@ -32,9 +32,10 @@ bool Char::invoke(Parser& parser, shared_ptr<Node> node)
     node->appendChild("char_number", number);
     int n = number->value(int(0));
     if(n < 0 || n > 255) {
-        parser.logger()->log(Logger::ERROR,
-            "Bad character code (" + boost::lexical_cast<string>(n) + ")",
-            parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                "Bad character code (" + boost::lexical_cast<string>(n) + ")",
+                parser, parser.lastToken());
         n = 0;
     }
     return true;
@@ -47,9 +48,10 @@ bool MathChar::invoke(Parser& parser, shared_ptr<Node> node)
     int n = number->value(int(0));
     // TODO: check for math mode
     if(n < 0 || n > 32767) {
-        parser.logger()->log(Logger::ERROR,
-            "Bad mathchar (" + boost::lexical_cast<string>(n) + ")",
-            parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                "Bad mathchar (" + boost::lexical_cast<string>(n) + ")",
+                parser, parser.lastToken());
         n = 0;
     }
     return true;
@@ -62,9 +64,10 @@ bool Delimiter::invoke(Parser& parser, shared_ptr<Node> node)
     int n = number->value(int(0));
     // TODO: check for math mode
     if(n < 0 || n > 134217727) {
-        parser.logger()->log(Logger::ERROR,
-            "Bad delimiter code (" + boost::lexical_cast<string>(n) + ")",
-            parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                "Bad delimiter code (" + boost::lexical_cast<string>(n) + ")",
+                parser, parser.lastToken());
         n = 0;
     }
     return true;
@@ -74,9 +77,10 @@ bool Char::createDef(Parser& parser, shared_ptr<Token> token,
                             int num, bool global)
 {
     if(num < 0 || num > 255) {
-        parser.logger()->log(Logger::ERROR,
-            "Bad character code (" + boost::lexical_cast<string>(num) + ")",
-            parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                "Bad character code (" + boost::lexical_cast<string>(num) + ")",
+                parser, parser.lastToken());
         num = 0;
     }
 
@@ -90,9 +94,10 @@ bool MathChar::createDef(Parser& parser, shared_ptr<Token> token,
                             int num, bool global)
 {
     if(num < 0 || num > 32767) {
-        parser.logger()->log(Logger::ERROR,
-            "Bad mathchar (" + boost::lexical_cast<string>(num) + ")",
-            parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                "Bad mathchar (" + boost::lexical_cast<string>(num) + ")",
+                parser, parser.lastToken());
         num = 0;
     }
 
@@ -57,9 +57,10 @@ bool Ifnum::evaluate(Parser& parser, shared_ptr<Node> node)
         relchar = token->value()[0];
         parser.nextToken(&relation->tokens());
     } else {
-        parser.logger()->log(Logger::ERROR,
-            "Missing = inserted for " + texRepr(&parser),
-            parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                "Missing = inserted for " + texRepr(&parser),
+                parser, parser.lastToken());
         relchar = '=';
     }
     relation->setValue(relchar);
@@ -95,9 +96,10 @@ bool Ifdim::evaluate(Parser& parser, shared_ptr<Node> node)
         relchar = token->value()[0];
         parser.nextToken(&relation->tokens());
     } else {
-        parser.logger()->log(Logger::ERROR,
-            "Missing = inserted for " + texRepr(&parser),
-            parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                "Missing = inserted for " + texRepr(&parser),
+                parser, parser.lastToken());
         relchar = '=';
     }
     relation->setValue(relchar);
@@ -293,9 +295,10 @@ bool Ifeof::evaluate(Parser& parser, shared_ptr<Node> node)
 
     int stream = number->value(int(0));
     if(stream < 0 || stream > 15) {
-        parser.logger()->log(Logger::ERROR,
-                "Bad number (" + boost::lexical_cast<string>(stream) + ")",
-                parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                    "Bad number (" + boost::lexical_cast<string>(stream) + ")",
+                    parser, parser.lastToken());
         stream = 0;
     }
 
@@ -174,9 +174,10 @@ string BoxDimen::parseName(Parser& parser, shared_ptr<Node> node)
     int n = number->value(int(0));
 
     if(n < 0 || n > 255) {
-        parser.logger()->log(Logger::ERROR,
-            "Bad register code (" + boost::lexical_cast<string>(n) + ")",
-            parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                "Bad register code (" + boost::lexical_cast<string>(n) + ")",
+                parser, parser.lastToken());
         n = 0;
     }
 
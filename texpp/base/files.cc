@@ -20,11 +20,11 @@
 #include <texpp/parser.h>
 #include <texpp/logger.h>
 #include <texpp/kpsewhich.h>
+#include <texpp/outputsink.h>
 
 #include <boost/lexical_cast.hpp>
 #include <boost/foreach.hpp>
 
-#include <fstream>
 #include <sstream>
 
 namespace texpp {
@@ -37,9 +37,10 @@ bool Openin::invoke(Parser& parser, shared_ptr<Node> node)
     int stream = number->value(int(0));
 
     if(stream < 0 || stream > 15) {
-        parser.logger()->log(Logger::ERROR,
-                "Bad number (" + boost::lexical_cast<string>(stream) + ")",
-                parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                    "Bad number (" + boost::lexical_cast<string>(stream) + ")",
+                    parser, parser.lastToken());
         stream = 0;
     }
 
@@ -49,12 +50,12 @@ bool Openin::invoke(Parser& parser, shared_ptr<Node> node)
     node->appendChild("file_name", fnameNode);
 
     string fname = fnameNode->value(string());
-    string fullname = kpsewhich(fname, parser.workdir());
+    string fullname = parser.resolveFile(fname);
     //std::cout << "name: '" << fnameNode->value(string()) << "'\n";
     //std::cout << "fullname: '" << fullname << "'\n";
 
-    shared_ptr<std::istream> istream(new std::ifstream(fullname.c_str()));
-    if(!istream->fail()) {
+    shared_ptr<std::istream> istream = parser.openFile(fullname);
+    if(istream) {
         shared_ptr<Lexer> lexer(new Lexer(fullname, istream));
         parser.setSymbol("read" + boost::lexical_cast<string>(stream),
                                     InFile(lexer), true);
@@ -73,9 +74,10 @@ bool Closein::invoke(Parser& parser, shared_ptr<Node> node)
     int stream = number->value(int(0));
 
     if(stream < 0 || stream > 15) {
-        parser.logger()->log(Logger::ERROR,
-                "Bad number (" + boost::lexical_cast<string>(stream) + ")",
-                parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                    "Bad number (" + boost::lexical_cast<string>(stream) + ")",
+                    parser, parser.lastToken());
         stream = 0;
     }
 
@@ -212,10 +214,11 @@ bool Immediate::invokeWithPrefixes(Parser& parser, shared_ptr<Node>,
 {
     size_t immediate = prefixes.count(name());
     if(prefixes.size() != immediate) {
-        parser.logger()->log(Logger::ERROR,
-            "You can't use a prefix with `" +
-            texRepr(&parser) + "'",
-            parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                "You can't use a prefix with `" +
+                texRepr(&parser) + "'",
+                parser, parser.lastToken());
     }
     prefixes.insert(name());
     return true;
@@ -232,10 +235,11 @@ bool Openout::invokeWithPrefixes(Parser& parser,
 {
     size_t immediate = prefixes.count("\\immediate");
     if(prefixes.size() != immediate) {
-        parser.logger()->log(Logger::ERROR,
-            "You can't use a prefix with `" +
-            texRepr(&parser) + "'",
-            parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                "You can't use a prefix with `" +
+                texRepr(&parser) + "'",
+                parser, parser.lastToken());
     }
 
     prefixes.clear();
@@ -251,9 +255,10 @@ bool Openout::invokeWithPrefixes(Parser& parser,
     int stream = number->value(int(0));
 
     if(stream < 0 || stream > 15) {
-        parser.logger()->log(Logger::ERROR,
-                "Bad number (" + boost::lexical_cast<string>(stream) + ")",
-                parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                    "Bad number (" + boost::lexical_cast<string>(stream) + ")",
+                    parser, parser.lastToken());
         stream = 0;
     }
 
@@ -264,14 +269,19 @@ bool Openout::invokeWithPrefixes(Parser& parser,
 
     string fname = kpseextend(fnameNode->value(string()));
 
-    shared_ptr<std::ostream> ostream(new std::ofstream(fname.c_str()));
-    if(!ostream->fail()) {
+    shared_ptr<std::ostream> ostream;
+    if(parser.outputSink())
+        ostream = parser.outputSink()->open(fname);
+
+    if(ostream) {
         parser.setSymbol("write" + boost::lexical_cast<string>(stream),
                                     OutFile(ostream), true);
-        string msg = texRepr(&parser) + boost::lexical_cast<string>(stream)
-                        + " = `" + fname + "'.\n\n";
-        parser.logger()->log(Logger::MTRACING, msg,
-                                parser, parser.lastToken());
+        if(parser.logEnabled(Logger::MTRACING)) {
+            string msg = texRepr(&parser) + boost::lexical_cast<string>(stream)
+                            + " = `" + fname + "'.\n\n";
+            parser.logger()->log(Logger::MTRACING, msg,
+                                    parser, parser.lastToken());
+        }
     } else {
         parser.logger()->log(Logger::ERROR, "Emergency stop",
                                 parser, parser.lastToken());
@@ -295,10 +305,11 @@ bool Closeout::invokeWithPrefixes(Parser& parser,
 {
     size_t immediate = prefixes.count("\\immediate");
     if(prefixes.size() != immediate) {
-        parser.logger()->log(Logger::ERROR,
-            "You can't use a prefix with `" +
-            texRepr(&parser) + "'",
-            parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                "You can't use a prefix with `" +
+                texRepr(&parser) + "'",
+                parser, parser.lastToken());
     }
 
     prefixes.clear();
@@ -314,14 +325,19 @@ bool Closeout::invokeWithPrefixes(Parser& parser,
     int stream = number->value(int(0));
 
     if(stream < 0 || stream > 15) {
-        parser.logger()->log(Logger::ERROR,
-                "Bad number (" + boost::lexical_cast<string>(stream) + ")",
-                parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                    "Bad number (" + boost::lexical_cast<string>(stream) + ")",
+                    parser, parser.lastToken());
         stream = 0;
     }
 
-    parser.setSymbol("write" + boost::lexical_cast<string>(stream),
-                                OutFile(), true);
+    string name = "write" + boost::lexical_cast<string>(stream);
+    OutFile outfile = parser.symbol(name, OutFile());
+    if(outfile.ostream)
+        outfile.ostream->flush();
+
+    parser.setSymbol(name, OutFile(), true);
 
     return true;
 }
@@ -339,10 +355,11 @@ bool Write::invokeWithPrefixes(Parser& parser,
 
     size_t immediate = prefixes.count("\\immediate");
     if(prefixes.size() != immediate) {
-        parser.logger()->log(Logger::ERROR,
-            "You can't use a prefix with `" +
-            texRepr(&parser) + "'",
-            parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                "You can't use a prefix with `" +
+                texRepr(&parser) + "'",
+                parser, parser.lastToken());
     }
 
     prefixes.clear();
@@ -357,13 +374,14 @@ bool Write::invokeWithPrefixes(Parser& parser,
     node->appendChild("number", number);
     int stream = number->value(int(0));
 
-    if(parser.symbol("tracingmacros", int(0)) >= 2) {
+    if(parser.tracingMacros() >= 2) {
         // read the tokens without expanding to show them in the trace
         Node::ptr text = parser.parseGeneralText(false);
         Token::list_ptr tokens =
             text->child("balanced_text")->value(Token::list_ptr());
 
-        parser.logger()->log(Logger::MTRACING,
+        if(parser.logEnabled(Logger::MTRACING))
+            parser.logger()->log(Logger::MTRACING,
                 texRepr(&parser) + "->" +
                 (tokens ? Token::texReprList(*tokens, &parser) : ""),
                 parser, parser.lastToken());
@@ -384,11 +402,14 @@ bool Write::invokeWithPrefixes(Parser& parser,
 
     node->appendChild("text", text);
     
+    OutFile outfile = 
+        parser.symbol("write" + boost::lexical_cast<string>(stream), OutFile());
+
     string str;
     Token::list_ptr tokens =
         text->child("balanced_text")->value(Token::list_ptr());
 
-    if(tokens) {
+    if(tokens && (outfile.ostream || parser.logEnabled(Logger::WRITE))) {
         str = Token::texReprList(*tokens, &parser);
         /*
         Token::list tokens_show;
@@ -405,12 +426,9 @@ bool Write::invokeWithPrefixes(Parser& parser,
         */
     }
 
-    OutFile outfile = 
-        parser.symbol("write" + boost::lexical_cast<string>(stream), OutFile());
-
     if(outfile.ostream) {
-        (*outfile.ostream) << str << std::endl;
-    } else {
+        (*outfile.ostream) << str << '\n';
+    } else if(parser.logEnabled(Logger::WRITE)) {
         parser.logger()->log(Logger::WRITE, str, parser, parser.lastToken());
                 //text->child("right_brace")->value(Token::ptr()));
     }
@@ -430,6 +448,9 @@ bool Message::invoke(Parser& parser, Node::ptr node)
     Token::list_ptr tokens =
         text->child("balanced_text")->value(Token::list_ptr());
 
+    if(!parser.logEnabled(Logger::MESSAGE))
+        return true;
+
     if(tokens) {
         str = Token::texReprList(*tokens, &parser);
         /*
@@ -458,7 +479,7 @@ bool Input::invoke(Parser& parser, shared_ptr<Node> node)
     node->appendChild("file_name", fnameNode);
 
     string fname = fnameNode->value(string());
-    string fullname = kpsewhich(fname, parser.workdir());
+    string fullname = parser.resolveFile(fname);
 
     parser.input(fname, fullname);
 
@@ -92,11 +92,8 @@ bool Font::invokeOperation(Parser& parser,
         node->appendChild("file_name", fileName);
 
         Dimen at = Dimen(0);
-        static vector<string> kw_at;
-        if(kw_at.empty()) {
-            kw_at.push_back("at");
-            kw_at.push_back("scaled");
-        }
+        static const char* ats[] = { "at", "scaled" };
+        static vector<string> kw_at(ats, ats + sizeof(ats)/sizeof(char*));
 
         Node::ptr atKw = parser.parseOptionalKeyword(kw_at);
         node->appendChild("at_clause", atKw);
@@ -107,11 +104,12 @@ bool Font::invokeOperation(Parser& parser,
 
             at = atNode->value(Dimen(0));
             if(at.value <= 0 || at.value >= 0x8000000) {
-                parser.logger()->log(Logger::ERROR,
-                    "Improper `at' size (" +
-                    InternalDimen::dimenToString(at) +
-                    + "), replaced by 10pt",
-                    parser, parser.lastToken());
+                if(parser.logEnabled(Logger::ERROR))
+                    parser.logger()->log(Logger::ERROR,
+                        "Improper `at' size (" +
+                        InternalDimen::dimenToString(at) +
+                        + "), replaced by 10pt",
+                        parser, parser.lastToken());
                 at.value = 655360;
             }
 
@@ -121,10 +119,11 @@ bool Font::invokeOperation(Parser& parser,
 
             int scaled = scaledNode->value(int(0));
             if(scaled <= 0 || scaled > 32768) {
-                parser.logger()->log(Logger::ERROR,
-                    "Illegal magnification has been changed to 1000 (" +
-                    boost::lexical_cast<string>(scaled) + ")",
-                    parser, parser.lastToken());
+                if(parser.logEnabled(Logger::ERROR))
+                    parser.logger()->log(Logger::ERROR,
+                        "Illegal magnification has been changed to 1000 (" +
+                        boost::lexical_cast<string>(scaled) + ")",
+                        parser, parser.lastToken());
                 scaled = 1000;
             }
 
@@ -207,9 +206,10 @@ string FontFamily::parseName(Parser& parser, shared_ptr<Node> node)
     int n = number->value(int(0));
 
     if(n < 0 || n > 15) {
-        parser.logger()->log(Logger::ERROR,
-            "Bad number (" + boost::lexical_cast<string>(n) + ")",
-            parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                "Bad number (" + boost::lexical_cast<string>(n) + ")",
+                parser, parser.lastToken());
         n = 0;
     }
 
@@ -255,17 +255,19 @@ string FontDimen::parseName(Parser& parser, shared_ptr<Node> node)
     FontInfo::ptr fontInfo = font->value(defaultFontInfo);
 
     if(n <= 0/* || n > 7*/) { // TODO: read the number of dimen params
-        // TODO: the following calc should be one function
-        string str = fontInfo->selector;
-        string escape = parser.escapestr();
-        if(!str.empty() && str[0] == '\\') {
-            str = escape + str.substr(1);
-        } else {
-            str = escape + "FONT" + str;
+        if(parser.logEnabled(Logger::ERROR)) {
+            // TODO: the following calc should be one function
+            string str = fontInfo->selector;
+            string escape = parser.escapestr();
+            if(!str.empty() && str[0] == '\\') {
+                str = escape + str.substr(1);
+            } else {
+                str = escape + "FONT" + str;
+            }
+            parser.logger()->log(Logger::ERROR,
+                "Font " + str + " has only 7 fontdimen parameters", // TODO: 7?
+                parser, parser.lastToken());
         }
-        parser.logger()->log(Logger::ERROR,
-            "Font " + str + " has only 7 fontdimen parameters", // TODO: 7?
-            parser, parser.lastToken());
         n = 0;
     }
 
@@ -49,15 +49,17 @@ bool Assignment::checkPrefixes(Parser& parser,
 
     if(prefixes.size() != ok) {
         if(macro) {
-            parser.logger()->log(Logger::ERROR,
-                "You can't use such a prefix with `" + texRepr(&parser) + "'",
-                parser, parser.lastToken());
+            if(parser.logEnabled(Logger::ERROR))
+                parser.logger()->log(Logger::ERROR,
+                    "You can't use such a prefix with `" + texRepr(&parser) + "'",
+                    parser, parser.lastToken());
         } else {
             string escape = parser.escapestr();
-            parser.logger()->log(Logger::ERROR,
-                string("You can't use `") + escape + "long' or `" +
-                escape + "outer' with `" + texRepr(&parser) + "'",
-                parser, parser.lastToken());
+            if(parser.logEnabled(Logger::ERROR))
+                parser.logger()->log(Logger::ERROR,
+                    string("You can't use `") + escape + "long' or `" +
+                    escape + "outer' with `" + texRepr(&parser) + "'",
+                    parser, parser.lastToken());
         }
     }
 
@@ -303,7 +305,9 @@ string UserMacro::texRepr(Parser* parser) const
 bool UserMacro::expand(Parser& parser, shared_ptr<Node> node)
 {
     // TODO: implement \long and \outer
-    if(parser.symbol("tracingmacros", int(0)) > 0) {
+    bool tracing = parser.tracingMacros() > 0 &&
+                   parser.logEnabled(Logger::MTRACING);
+    if(tracing) {
         Token::ptr t = node->child("control_sequence")->value(Token::ptr());
         string str(1, '\n');
         str += //Token::texReprControl(name(), &parser, true) +
@@ -360,9 +364,10 @@ bool UserMacro::expand(Parser& parser, shared_ptr<Node> node)
                     --level;
                     if(level == 0 && !etoken) break;
                     if(level < 0) {
-                        parser.logger()->log(Logger::ERROR,
-                            "Argument of " + Command::texRepr(&parser) +
-                            " has an extra }", parser, parser.lastToken());
+                        if(parser.logEnabled(Logger::ERROR))
+                            parser.logger()->log(Logger::ERROR,
+                                "Argument of " + Command::texRepr(&parser) +
+                                " has an extra }", parser, parser.lastToken());
                         level = 0;
                     }
                 } else {
@@ -396,16 +401,17 @@ bool UserMacro::expand(Parser& parser, shared_ptr<Node> node)
                     ntoken->type() != (*it)->type() ||
                     ntoken->catCode() != (*it)->catCode() ||
                     ntoken->value() != (*it)->value()) {
-                parser.logger()->log(Logger::ERROR,
-                    "Use of " + Command::texRepr(&parser) +
-                    " doesn't match its definition",
-                    parser, parser.lastToken());
+                if(parser.logEnabled(Logger::ERROR))
+                    parser.logger()->log(Logger::ERROR,
+                        "Use of " + Command::texRepr(&parser) +
+                        " doesn't match its definition",
+                        parser, parser.lastToken());
                 return true;
             }
         }
     }
 
-    if(parser.symbol("tracingmacros", int(0)) > 0) {
+    if(tracing) {
         for(size_t n = 0; n < paramNum; ++n) {
             string str("#");
             str += boost::lexical_cast<string>(n+1);
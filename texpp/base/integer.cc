@@ -96,9 +96,10 @@ string CharcodeVariable::parseName(Parser& parser, shared_ptr<Node> node)
     int n = number->value(int(0));
 
     if(n < 0 || n > 255) {
-        parser.logger()->log(Logger::ERROR,
-            "Bad character code (" + boost::lexical_cast<string>(n) + ")",
-            parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                "Bad character code (" + boost::lexical_cast<string>(n) + ")",
+                parser, parser.lastToken());
         n = 0;
     }
 
@@ -119,12 +120,13 @@ bool CharcodeVariable::invokeOperation(Parser& parser,
 
         int n = rvalue->value(int(0));
         if(n < m_min || n > m_max) {
-            parser.logger()->log(Logger::ERROR, "Invalid code (" +
-                boost::lexical_cast<string>(n) +
-                "), should be in the range " +
-                boost::lexical_cast<string>(m_min) + ".." +
-                boost::lexical_cast<string>(m_max),
-                parser, parser.lastToken());
+            if(parser.logEnabled(Logger::ERROR))
+                parser.logger()->log(Logger::ERROR, "Invalid code (" +
+                    boost::lexical_cast<string>(n) +
+                    "), should be in the range " +
+                    boost::lexical_cast<string>(m_min) + ".." +
+                    boost::lexical_cast<string>(m_max),
+                    parser, parser.lastToken());
             n = 0;
         }
 
@@ -169,11 +171,12 @@ bool Spacefactor::invokeOperation(Parser& parser,
 {
     if(parser.mode() != Parser::HORIZONTAL &&
             parser.mode() != Parser::RHORIZONTAL) {
-        parser.logger()->log(Logger::ERROR,
-            op == GET || op == EXPAND ? "Improper " + texRepr(&parser) :
-            "You can't use `" + texRepr(&parser) +
-            "' in " + parser.modeName() + " mode",
-            parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                op == GET || op == EXPAND ? "Improper " + texRepr(&parser) :
+                "You can't use `" + texRepr(&parser) +
+                "' in " + parser.modeName() + " mode",
+                parser, parser.lastToken());
         if(op == GET) node->setValue(int(0));
         else if(op == EXPAND) node->setValue(string("0"));
         return true;
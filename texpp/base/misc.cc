@@ -29,11 +29,12 @@ namespace base {
 
 bool UnimplementedCommand::invoke(Parser& parser, shared_ptr<Node> node)
 {
-    parser.logger()->log(Logger::UNIMPLEMENTED,
-        "Command " +
-        node->child("control_sequence")->value(Token::ptr())->texRepr(&parser) +
-        " is not yet implemented in TeXpp",
-        parser, parser.lastToken());
+    if(parser.logEnabled(Logger::UNIMPLEMENTED))
+        parser.logger()->log(Logger::UNIMPLEMENTED,
+            "Command " +
+            node->child("control_sequence")->value(Token::ptr())->texRepr(&parser) +
+            " is not yet implemented in TeXpp",
+            parser, parser.lastToken());
     return true;
 }
 
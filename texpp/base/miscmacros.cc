@@ -97,9 +97,10 @@ bool CsnameMacro::expand(Parser& parser, shared_ptr<Node> node)
         parser.nextToken(&child->tokens());
     } else {
         string escape = parser.escapestr();
-        parser.logger()->log(Logger::ERROR,
-            "Missing " + escape + "endcsname inserted",
-            parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                "Missing " + escape + "endcsname inserted",
+                parser, parser.lastToken());
     }
 
     if(!parser.symbol(name, Command::ptr())) {
@@ -115,9 +116,10 @@ bool CsnameMacro::expand(Parser& parser, shared_ptr<Node> node)
 
 bool EndcsnameMacro::invoke(Parser& parser, shared_ptr<Node>)
 {
-    parser.logger()->log(Logger::ERROR,
-        "Extra " + texRepr(&parser),
-        parser, parser.lastToken());
+    if(parser.logEnabled(Logger::ERROR))
+        parser.logger()->log(Logger::ERROR,
+            "Extra " + texRepr(&parser),
+            parser, parser.lastToken());
 
     return true;
 }
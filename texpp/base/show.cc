@@ -40,6 +40,10 @@ bool parseMeaning(Parser& parser, shared_ptr<Node> node, bool show)
     Token::ptr token = tokenNode->value(Token::ptr());
     node->appendChild("token", tokenNode);
 
+    // \show only produces a message
+    if(show && !parser.logEnabled(Logger::SHOW))
+        return true;
+
     string str;
     if(token->isCharacter()) {
         str = token->meaning(&parser);
@@ -99,20 +103,23 @@ bool parseThe(Parser& parser, shared_ptr<Node> node, bool show)
         if(ok) str = node->value(string());
 
     } else {
-        string tname = token->texRepr(&parser);
-        Command::ptr cmd = parser.symbol(token, Command::ptr());
-        if(cmd) tname = cmd->texRepr(&parser);
-        parser.logger()->log(Logger::ERROR,
-            "You can't use `" + tname +
-            "' after " + parser.escapestr() + "the",
-            parser, token);
+        if(parser.logEnabled(Logger::ERROR)) {
+            string tname = token->texRepr(&parser);
+            Command::ptr cmd = parser.symbol(token, Command::ptr());
+            if(cmd) tname = cmd->texRepr(&parser);
+            parser.logger()->log(Logger::ERROR,
+                "You can't use `" + tname +
+                "' after " + parser.escapestr() + "the",
+                parser, token);
+        }
         str = "0";
     }
 
-    if(show)
-        parser.logger()->log(Logger::SHOW, str,
-            parser, parser.lastToken());
-    else
+    if(show) {
+        if(parser.logEnabled(Logger::SHOW))
+            parser.logger()->log(Logger::SHOW, str,
+                parser, parser.lastToken());
+    } else
         node->setValue(Macro::stringToTokens(str));
 
     return true;
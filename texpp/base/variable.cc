@@ -73,10 +73,11 @@ bool ArithmeticCommand::invokeWithPrefixes(Parser& parser,
         Command::ptr cmd = parser.symbol(token, Command::ptr());
         if(cmd) tname = cmd->texRepr(&parser);
         else tname = token->meaning(&parser);
-        parser.logger()->log(Logger::ERROR,
-            string("You can't use `") + tname +
-            string("' after ") + texRepr(&parser),
-            parser, token);
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                string("You can't use `") + tname +
+                string("' after ") + texRepr(&parser),
+                parser, token);
         node->setValue(int(0));
         node->appendChild("error_wrong_lvalue", lvalue);
     }
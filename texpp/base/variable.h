@@ -113,9 +113,10 @@ string Register<Var>::parseName(Parser& parser, shared_ptr<Node> node)
     int n = number->value(int(0));
 
     if(n < 0 || n > 255) {
-        parser.logger()->log(Logger::ERROR,
-            "Bad register code (" + boost::lexical_cast<string>(n) + ")",
-            parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                "Bad register code (" + boost::lexical_cast<string>(n) + ")",
+                parser, parser.lastToken());
         n = 0;
     }
 
@@ -129,9 +130,10 @@ bool Register<Var>::createDef(Parser& parser, Token::ptr token,
                                 int num, bool global)
 {
     if(num < 0 || num > 255) {
-        parser.logger()->log(Logger::ERROR,
-            "Bad register code (" + boost::lexical_cast<string>(num) + ")",
-            parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR,
+                "Bad register code (" + boost::lexical_cast<string>(num) + ")",
+                parser, parser.lastToken());
         num = 0;
     }
 
@@ -147,9 +149,10 @@ bool ReadOnlyVariable<Var>::invokeOperation(Parser& parser,
             shared_ptr<Node> node, Variable::Operation op, bool global)
 {
     if(op == Variable::ASSIGN) {
-        parser.logger()->log(Logger::ERROR, "You can't use `" +
-            this->texRepr(&parser) + "' in " + parser.modeName() + " mode",
-            parser, parser.lastToken());
+        if(parser.logEnabled(Logger::ERROR))
+            parser.logger()->log(Logger::ERROR, "You can't use `" +
+                this->texRepr(&parser) + "' in " + parser.modeName() + " mode",
+                parser, parser.lastToken());
         return true;
     } else {
         return Var::invokeOperation(parser, node, op, global);
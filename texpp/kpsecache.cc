@@ -0,0 +1,383 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "kpsecache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <map>
+#include <set>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+
+namespace texpp {
+
+namespace {
+
+const char MAGIC[8] = { 'T', 'X', 'P', 'K', 'P', 'S', 'E', 0 };
+const boost::uint32_t VERSION = 1;
+
+bool writeAll(int fd, const void* data, size_t size)
+{
+    const char* p = static_cast<const char*>(data);
+    while(size > 0) {
+        ssize_t n = ::write(fd, p, size);
+        if(n < 0) return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+} // namespace
+
+// Snapshot layout: Header, DirRecord[dirCount], EntryRecord[entryCount]
+// sorted by hash, uint32 dependency lists, string pool
+struct KpseCache::Header
+{
+    char            magic[8];
+    boost::uint32_t version;
+    boost::uint32_t dirCount;
+    boost::uint32_t entryCount;
+    boost::uint32_t depCount;
+    boost::uint64_t fingerprint;
+    boost::uint64_t stringsSize;
+};
+
+struct KpseCache::DirRecord
+{
+    boost::uint32_t path;
+    boost::uint32_t pathLength;
+    boost::int64_t  sec;
+    boost::int64_t  nsec;
+};
+
+struct KpseCache::EntryRecord
+{
+    boost::uint64_t hash;
+    boost::uint32_t key;
+    boost::uint32_t keyLength;
+    boost::uint32_t result;
+    boost::uint32_t resultLength;
+    boost::uint32_t depBegin;
+    boost::uint32_t depCount;
+};
+
+KpseCache::Hash KpseCache::hash(const std::string& str, Hash seed)
+{
+    // FNV-1a
+    Hash h = seed;
+    for(size_t n = 0; n < str.size(); ++n) {
+        h ^= (unsigned char) str[n];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+KpseCache::KpseCache(const std::string& fileName, Hash fingerprint)
+    : m_fileName(fileName), m_fingerprint(fingerprint),
+      m_data(NULL), m_size(0), m_header(NULL), m_dirs(NULL),
+      m_entries(NULL), m_deps(NULL), m_strings(NULL)
+{
+    map();
+}
+
+KpseCache::~KpseCache()
+{
+    unmap();
+}
+
+void KpseCache::map()
+{
+    int fd = ::open(m_fileName.c_str(), O_RDONLY);
+    if(fd < 0) return;
+
+    struct stat st;
+    if(::fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(Header)) {
+        ::close(fd);
+        return;
+    }
+
+    void* data = ::mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(data == MAP_FAILED) return;
+
+    m_data = static_cast<const char*>(data);
+    m_size = st.st_size;
+
+    const Header* header = reinterpret_cast<const Header*>(m_data);
+    boost::uint64_t expected = sizeof(Header) +
+            boost::uint64_t(header->dirCount) * sizeof(DirRecord) +
+            boost::uint64_t(header->entryCount) * sizeof(EntryRecord) +
+            boost::uint64_t(header->depCount) * sizeof(boost::uint32_t) +
+            header->stringsSize;
+
+    if(std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+            header->version != VERSION ||
+            header->fingerprint != m_fingerprint ||
+            expected != m_size) {
+        unmap();
+        return;
+    }
+
+    m_header = header;
+    m_dirs = reinterpret_cast<const DirRecord*>(m_data + sizeof(Header));
+    m_entries = reinterpret_cast<const EntryRecord*>(
+                                m_dirs + header->dirCount);
+    m_deps = reinterpret_cast<const boost::uint32_t*>(
+                                m_entries + header->entryCount);
+    m_strings = reinterpret_cast<const char*>(m_deps + header->depCount);
+}
+
+void KpseCache::unmap()
+{
+    if(m_data)
+        ::munmap(const_cast<char*>(m_data), m_size);
+    m_data = NULL;
+    m_size = 0;
+    m_header = NULL;
+    m_dirs = NULL;
+    m_entries = NULL;
+    m_deps = NULL;
+    m_strings = NULL;
+}
+
+size_t KpseCache::size() const
+{
+    return m_header ? m_header->entryCount : 0;
+}
+
+bool KpseCache::stringAt(boost::uint32_t offset, boost::uint32_t length,
+                         std::string& str) const
+{
+    if(boost::uint64_t(offset) + length > m_header->stringsSize)
+        return false;
+    str.assign(m_strings + offset, length);
+    return true;
+}
+
+const KpseCache::EntryRecord* KpseCache::findRecord(Hash h,
+                                        const std::string& key) const
+{
+    if(!m_header) return NULL;
+
+    const EntryRecord* begin = m_entries;
+    const EntryRecord* end = m_entries + m_header->entryCount;
+    while(begin < end) {
+        const EntryRecord* mid = begin + (end - begin) / 2;
+        if(mid->hash < h) begin = mid + 1;
+        else end = mid;
+    }
+
+    std::string k;
+    for(end = m_entries + m_header->entryCount;
+            begin < end && begin->hash == h; ++begin) {
+        if(stringAt(begin->key, begin->keyLength, k) && k == key)
+            return begin;
+    }
+    return NULL;
+}
+
+const KpseCache::Stamp& KpseCache::currentStamp(const std::string& path)
+{
+    std::tr1::unordered_map<std::string, Stamp>::iterator it =
+                                                m_stamps.find(path);
+    if(it != m_stamps.end()) return it->second;
+
+    Stamp stamp = { -1, -1 };
+    struct stat st;
+    if(::stat(path.c_str(), &st) == 0) {
+        stamp.sec = st.st_mtim.tv_sec;
+        stamp.nsec = st.st_mtim.tv_nsec;
+    }
+    return m_stamps.insert(std::make_pair(path, stamp)).first->second;
+}
+
+void KpseCache::stamp(const std::string& path)
+{
+    currentStamp(path);
+}
+
+bool KpseCache::lookup(const std::string& key, std::string& result)
+{
+    const EntryRecord* entry = findRecord(hash(key), key);
+    if(!entry) return false;
+
+    if(boost::uint64_t(entry->depBegin) + entry->depCount >
+                                            m_header->depCount)
+        return false;
+
+    std::string path;
+    for(boost::uint32_t n = 0; n < entry->depCount; ++n) {
+        boost::uint32_t d = m_deps[entry->depBegin + n];
+        if(d >= m_header->dirCount) return false;
+
+        const DirRecord& dir = m_dirs[d];
+        if(!stringAt(dir.path, dir.pathLength, path)) return false;
+
+        Stamp recorded = { dir.sec, dir.nsec };
+        if(!(currentStamp(path) == recorded)) return false;
+    }
+
+    return stringAt(entry->result, entry->resultLength, result);
+}
+
+void KpseCache::add(const std::string& key, const std::string& result,
+                    const std::vector<std::string>& deps)
+{
+    Entry entry;
+    entry.key = key;
+    entry.result = result;
+
+    std::set<std::string> seen;
+    BOOST_FOREACH(const std::string& dep, deps) {
+        if(seen.insert(dep).second)
+            entry.deps.push_back(std::make_pair(dep, currentStamp(dep)));
+    }
+
+    m_added.push_back(entry);
+}
+
+bool KpseCache::save()
+{
+    if(m_added.empty()) return true;
+
+    // New entries replace old ones with the same key
+    std::vector<Entry> entries(m_added);
+    std::set<std::string> keys;
+    BOOST_FOREACH(const Entry& e, m_added)
+        keys.insert(e.key);
+
+    std::string str;
+    for(size_t n = 0; n < size(); ++n) {
+        const EntryRecord& r = m_entries[n];
+        Entry e;
+        if(!stringAt(r.key, r.keyLength, e.key) || keys.count(e.key) ||
+                !stringAt(r.result, r.resultLength, e.result) ||
+                boost::uint64_t(r.depBegin) + r.depCount > m_header->depCount)
+            continue;
+
+        bool valid = true;
+        for(boost::uint32_t d = 0; d < r.depCount && valid; ++d) {
+            boost::uint32_t i = m_deps[r.depBegin + d];
+            valid = i < m_header->dirCount &&
+                stringAt(m_dirs[i].path, m_dirs[i].pathLength, str);
+            if(valid) {
+                Stamp stamp = { m_dirs[i].sec, m_dirs[i].nsec };
+                e.deps.push_back(std::make_pair(str, stamp));
+            }
+        }
+        if(valid) {
+            keys.insert(e.key);
+            entries.push_back(e);
+        }
+    }
+
+    // Build the tables
+    std::string strings;
+    std::vector<DirRecord> dirs;
+    typedef std::pair<std::string,
+                std::pair<boost::int64_t, boost::int64_t> > DirKey;
+    std::map<DirKey, boost::uint32_t> dirIds;
+    std::vector<std::pair<Hash, size_t> > order;
+    std::vector<EntryRecord> records(entries.size());
+    std::vector<boost::uint32_t> depList;
+
+    for(size_t n = 0; n < entries.size(); ++n) {
+        const Entry& e = entries[n];
+        EntryRecord& r = records[n];
+        r.hash = hash(e.key);
+        r.key = strings.size(); r.keyLength = e.key.size();
+        strings += e.key;
+        r.result = strings.size(); r.resultLength = e.result.size();
+        strings += e.result;
+        r.depBegin = depList.size();
+        r.depCount = e.deps.size();
+
+        typedef std::pair<std::string, Stamp> Dep;
+        BOOST_FOREACH(const Dep& dep, e.deps) {
+            DirKey id(dep.first,
+                    std::make_pair(dep.second.sec, dep.second.nsec));
+            std::map<DirKey, boost::uint32_t>::iterator it = dirIds.find(id);
+            if(it == dirIds.end()) {
+                DirRecord d;
+                d.path = strings.size(); d.pathLength = dep.first.size();
+                d.sec = dep.second.sec; d.nsec = dep.second.nsec;
+                strings += dep.first;
+                it = dirIds.insert(std::make_pair(id,
+                                boost::uint32_t(dirs.size()))).first;
+                dirs.push_back(d);
+            }
+            depList.push_back(it->second);
+        }
+        order.push_back(std::make_pair(r.hash, n));
+    }
+
+    std::sort(order.begin(), order.end());
+    std::vector<EntryRecord> sorted;
+    sorted.reserve(records.size());
+    for(size_t n = 0; n < order.size(); ++n)
+        sorted.push_back(records[order[n].second]);
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.dirCount = dirs.size();
+    header.entryCount = sorted.size();
+    header.depCount = depList.size();
+    header.fingerprint = m_fingerprint;
+    header.stringsSize = strings.size();
+
+    std::string tmpName = m_fileName + ".tmp." +
+                boost::lexical_cast<std::string>(::getpid());
+    int fd = ::open(tmpName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if(fd < 0) return false;
+
+    bool ok = writeAll(fd, &header, sizeof(header)) &&
+        (dirs.empty() || writeAll(fd, &dirs[0],
+                            dirs.size() * sizeof(DirRecord))) &&
+        (sorted.empty() || writeAll(fd, &sorted[0],
+                            sorted.size() * sizeof(EntryRecord))) &&
+        (depList.empty() || writeAll(fd, &depList[0],
+                            depList.size() * sizeof(boost::uint32_t))) &&
+        writeAll(fd, strings.data(), strings.size());
+    ok = (::close(fd) == 0) && ok;
+
+    if(!ok || std::rename(tmpName.c_str(), m_fileName.c_str()) != 0) {
+        ::unlink(tmpName.c_str());
+        return false;
+    }
+
+    // Entries are in the file now, pick up the new snapshot
+    m_added.clear();
+    unmap();
+    map();
+    return true;
+}
+
+} // namespace texpp
+
@@ -0,0 +1,120 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __TEXPP_KPSECACHE_H
+#define __TEXPP_KPSECACHE_H
+
+#include <string>
+#include <vector>
+#include <tr1/unordered_map>
+
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace texpp {
+
+// On-disk cache of file lookups shared by many processes. The file is
+// an immutable snapshot which is memory mapped for reading; save()
+// writes a new snapshot next to it and renames it into place, so
+// readers never see a partially written file. Concurrent writers may
+// lose each other's new entries, never corrupt the file.
+//
+// Every entry lists the paths (directories, ls-R files) the lookup
+// depended on, together with their modification times. An entry is
+// only used while all of them are unchanged. A snapshot written with
+// a different fingerprint (texmf configuration) is ignored entirely.
+class KpseCache: boost::noncopyable
+{
+public:
+    typedef boost::shared_ptr<KpseCache> ptr;
+    typedef boost::uint64_t Hash;
+
+    KpseCache(const std::string& fileName, Hash fingerprint);
+    ~KpseCache();
+
+    const std::string& fileName() const { return m_fileName; }
+
+    // Number of entries in the mapped snapshot
+    size_t size() const;
+
+    // Looks the key up in the snapshot and validates the result
+    bool lookup(const std::string& key, std::string& result);
+
+    // Records the current state of a path. Lookups should stamp their
+    // dependencies before reading them.
+    void stamp(const std::string& path);
+
+    // Adds an entry for the next snapshot, deps must have been stamped
+    void add(const std::string& key, const std::string& result,
+             const std::vector<std::string>& deps);
+
+    // Writes a new snapshot if entries were added, returns false on
+    // I/O errors
+    bool save();
+
+    static Hash hash(const std::string& str, Hash seed = 14695981039346656037ULL);
+
+protected:
+    struct Stamp
+    {
+        boost::int64_t sec;
+        boost::int64_t nsec;
+        bool operator==(const Stamp& o) const {
+            return sec == o.sec && nsec == o.nsec;
+        }
+    };
+
+    struct Entry
+    {
+        std::string key;
+        std::string result;
+        std::vector<std::pair<std::string, Stamp> > deps;
+    };
+
+    struct Header;
+    struct DirRecord;
+    struct EntryRecord;
+
+    void map();
+    void unmap();
+    const EntryRecord* findRecord(Hash h, const std::string& key) const;
+    bool stringAt(boost::uint32_t offset, boost::uint32_t length,
+                  std::string& str) const;
+    const Stamp& currentStamp(const std::string& path);
+
+    std::string m_fileName;
+    Hash        m_fingerprint;
+
+    const char* m_data;
+    size_t      m_size;
+
+    const Header*      m_header;
+    const DirRecord*   m_dirs;
+    const EntryRecord* m_entries;
+    const boost::uint32_t* m_deps;
+    const char*        m_strings;
+
+    std::tr1::unordered_map<std::string, Stamp> m_stamps;
+    std::vector<Entry> m_added;
+};
+
+} // namespace texpp
+
+#endif
+
@@ -19,24 +19,213 @@
 #include "kpsewhich.h"
 #include "common.h"
 
+#include <fstream>
+#include <set>
+
+#include <limits.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <dirent.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
 #include <fcntl.h>
 #include <errno.h>
 
-namespace texpp {
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
 
-std::string kpseextend(const std::string& fname)
+namespace {
+
+using std::string;
+using std::vector;
+
+#ifndef WINDOWS
+const char ENV_SEP = ':';
+#else
+const char ENV_SEP = ';';
+#endif
+
+// Where kpathsea looks for texmf.cnf when TEXMFCNF is not set,
+// followed by the locations used by common distributions
+const char* const DEFAULT_TEXMFCNF =
+    "{$SELFAUTOLOC,$SELFAUTOLOC/share/texmf-local/web2c,"
+    "$SELFAUTOLOC/share/texmf-dist/web2c,$SELFAUTOLOC/share/texmf/web2c,"
+    "$SELFAUTOLOC/texmf-local/web2c,$SELFAUTOLOC/texmf-dist/web2c,"
+    "$SELFAUTOLOC/texmf/web2c,"
+    "$SELFAUTODIR,$SELFAUTODIR/share/texmf-local/web2c,"
+    "$SELFAUTODIR/share/texmf-dist/web2c,$SELFAUTODIR/share/texmf/web2c,"
+    "$SELFAUTODIR/texmf-local/web2c,$SELFAUTODIR/texmf-dist/web2c,"
+    "$SELFAUTODIR/texmf/web2c,"
+    "$SELFAUTOGRANDPARENT/texmf-local/web2c,"
+    "$SELFAUTOPARENT,$SELFAUTOPARENT/share/texmf-local/web2c,"
+    "$SELFAUTOPARENT/share/texmf-dist/web2c,"
+    "$SELFAUTOPARENT/share/texmf/web2c,"
+    "$SELFAUTOPARENT/texmf-local/web2c,$SELFAUTOPARENT/texmf-dist/web2c,"
+    "$SELFAUTOPARENT/texmf/web2c}"
+#ifndef WINDOWS
+    ":/etc/texmf/web2c:/usr/share/texlive/texmf-dist/web2c"
+    ":/usr/share/texmf/web2c"
+#endif
+    ;
+
+// Path variables of the formats kpsewhich guesses from the suffix,
+// everything else is searched along TEXINPUTS
+const char* const FORMATS[][2] = {
+    { ".bib", "BIBINPUTS" },
+    { ".bst", "BSTINPUTS" },
+    { ".ist", "INDEXSTYLE" },
+    { ".tfm", "TFMFONTS" },
+    { ".vf", "VFFONTS" },
+    { ".pfb", "T1FONTS" },
+    { ".enc", "ENCFONTS" },
+    { ".map", "TEXFONTMAPS" },
+    { ".mf", "MFINPUTS" },
+    { ".mp", "MPINPUTS" },
+    { NULL, NULL }
+};
+
+// Suffixes of TEXINPUTS files that are looked up without adding .tex
+const char* const TEX_SUFFIXES[] = {
+    ".tex", ".sty", ".cls", ".clo", ".def", ".fd", ".cfg", ".ldf",
+    ".ltx", ".dtx", ".ins", ".aux", ".bbl", NULL
+};
+
+const int MAX_EXPANSION_DEPTH = 32;
+const int MAX_DIRECTORY_DEPTH = 64;
+
+bool startsWith(const string& str, const string& prefix)
 {
-    size_t n = fname.rfind(PATH_SEP);
-    size_t n1 = fname.substr(n == fname.npos ? 0 : n).rfind('.');
-    return n1 == fname.npos ? (fname + ".tex") : fname;
+    return str.compare(0, prefix.size(), prefix) == 0;
 }
 
-std::string kpsewhich(const std::string& fname, const std::string& dir)
+bool endsWith(const string& str, const string& suffix)
+{
+    return str.size() >= suffix.size() &&
+        str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool isAbsolute(const string& path)
+{
+#ifndef WINDOWS
+    return !path.empty() && path[0] == PATH_SEP;
+#else
+    return path.size() >= 3 && path[1] == ':' && path[2] == PATH_SEP;
+#endif
+}
+
+string joinPath(const string& dir, const string& name)
+{
+    if(dir.empty()) return name;
+    if(name.empty()) return dir;
+    if(dir[dir.size()-1] == PATH_SEP) return dir + name;
+    return dir + PATH_SEP + name;
+}
+
+string dirName(const string& path)
+{
+    size_t n = path.rfind(PATH_SEP);
+    if(n == string::npos) return string();
+    if(n == 0) return string(1, PATH_SEP);
+    return path.substr(0, n);
+}
+
+string stripTrailingSeps(const string& path)
+{
+    size_t n = path.find_last_not_of(PATH_SEP);
+    if(n == string::npos) return path.empty() ? path : string(1, PATH_SEP);
+    return path.substr(0, n+1);
+}
+
+bool fileExists(const string& path)
+{
+    struct stat st;
+    return ::stat(path.c_str(), &st) == 0 && !S_ISDIR(st.st_mode) &&
+                ::access(path.c_str(), R_OK) == 0;
+}
+
+// Splits at separators that are not inside braces
+void splitTopLevel(const string& value, char sep, vector<string>& result)
+{
+    int level = 0;
+    size_t start = 0;
+    for(size_t n = 0; n < value.size(); ++n) {
+        if(value[n] == '{') ++level;
+        else if(value[n] == '}') --level;
+        else if(value[n] == sep && level <= 0) {
+            result.push_back(value.substr(start, n - start));
+            start = n + 1;
+        }
+    }
+    result.push_back(value.substr(start));
+}
+
+void expandBraces(const string& value, vector<string>& result)
+{
+    size_t open = value.find('{');
+    if(open == string::npos) {
+        result.push_back(value);
+        return;
+    }
+
+    int level = 0;
+    size_t close = open;
+    for(; close < value.size(); ++close) {
+        if(value[close] == '{') ++level;
+        else if(value[close] == '}' && --level == 0) break;
+    }
+    if(close >= value.size()) {
+        result.push_back(value);
+        return;
+    }
+
+    vector<string> alternatives;
+    splitTopLevel(value.substr(open+1, close-open-1), ',', alternatives);
+    BOOST_FOREACH(const string& alt, alternatives)
+        expandBraces(value.substr(0, open) + alt + value.substr(close+1),
+                     result);
+}
+
+// Empty elements of a path list stand for the default value
+string fillEmptyElements(const string& value, const string& def)
+{
+    vector<string> elements;
+    splitTopLevel(value, ENV_SEP, elements);
+
+    string result;
+    bool filled = false;
+    for(size_t n = 0; n < elements.size(); ++n) {
+        if(n) result += ENV_SEP;
+        if(elements[n].empty() && !filled) {
+            result += def;
+            filled = true;
+        } else {
+            result += elements[n];
+        }
+    }
+    return result;
+}
+
+string findInPath(const char* program)
+{
+    const char* path = getenv("PATH");
+    if(!path) return string();
+
+    vector<string> dirs;
+    splitTopLevel(path, ENV_SEP, dirs);
+    BOOST_FOREACH(const string& dir, dirs) {
+        if(dir.empty()) continue;
+        string fileName = joinPath(dir, program);
+        if(::access(fileName.c_str(), X_OK) == 0) {
+            char buf[PATH_MAX];
+            if(::realpath(fileName.c_str(), buf)) return buf;
+            return fileName;
+        }
+    }
+    return string();
+}
+
+std::string kpsewhichExec(const std::string& fname, const std::string& dir)
 {
     int p_stdout[2];
     pid_t pid;
@@ -59,7 +248,7 @@ std::string kpsewhich(const std::string& fname, const std::string& dir)
         if(!dir.empty())
             chdir(dir.c_str());
         execlp("kpsewhich", "kpsewhich", fname.c_str(), NULL);
-        exit(1);
+        _exit(1);
     }
 
     close(p_stdout[1]);
@@ -98,19 +287,576 @@ std::string kpsewhich(const std::string& fname, const std::string& dir)
     if(!fullname.empty() && fullname[fullname.size()-1] == '\n')
         fullname.resize(fullname.size()-1);
 
-    if(!fullname.empty() && !dir.empty()) {
+    return fullname;
+}
+
+bool openGlobalCache(texpp::KpseResolver& resolver)
+{
+    const char* fileName = getenv("TEXPP_KPSE_CACHE");
+    return fileName && *fileName && resolver.setPersistentCache(fileName);
+}
+
+} // namespace
+
+namespace texpp {
+
+std::string kpseextend(const std::string& fname)
+{
+    size_t n = fname.rfind(PATH_SEP);
+    size_t n1 = fname.substr(n == fname.npos ? 0 : n).rfind('.');
+    return n1 == fname.npos ? (fname + ".tex") : fname;
+}
+
+std::string kpsewhich(const std::string& fname, const std::string& dir)
+{
+    std::string fullname = KpseResolver::global().find(fname, dir);
+
+    if(!fullname.empty() && !dir.empty() && !isAbsolute(fullname))
+        fullname = dir + PATH_SEP + fullname;
+
+    return fullname;
+}
+
+KpseResolver& KpseResolver::global()
+{
+    static KpseResolver resolver;
+    static bool cacheOpened = openGlobalCache(resolver);
+    (void) cacheOpened;
+    return resolver;
+}
+
+KpseResolver::KpseResolver(const string& cnfPath, bool useEnvironment)
+    : m_useEnvironment(useEnvironment), m_configured(false),
+      m_databasesLoaded(false), m_deps(NULL)
+{
+    setSelfAuto();
+
+    string path = cnfPath;
+    const char* env = m_useEnvironment ? getenv("TEXMFCNF") : NULL;
+    if(path.empty() && env)
+        path = fillEmptyElements(env, DEFAULT_TEXMFCNF);
+    if(path.empty())
+        path = DEFAULT_TEXMFCNF;
+
+    vector<string> dirs;
+    expandPath(path, dirs);
+
+    std::set<string> loaded;
+    BOOST_FOREACH(const string& dir, dirs) {
+        string fileName = joinPath(dir, "texmf.cnf");
+        if(loaded.insert(fileName).second && fileExists(fileName)) {
+            loadConfigFile(fileName);
+            m_configFiles.push_back(fileName);
+            m_configured = true;
+        }
+    }
+
+    if(m_useEnvironment && getenv("TEXINPUTS"))
+        m_configured = true;
+}
+
+KpseResolver::~KpseResolver()
+{
+    if(m_persistent)
+        m_persistent->save();
+}
+
+void KpseResolver::setSelfAuto()
+{
+    // kpathsea derives these from the location of the running program
+    string program = findInPath("kpsewhich");
+    if(program.empty()) program = findInPath("tex");
+    if(program.empty()) return;
+
+    string loc = dirName(program);
+    string dir = dirName(loc);
+    string parent = dirName(dir);
+    m_variables["SELFAUTOLOC"] = loc;
+    m_variables["SELFAUTODIR"] = dir;
+    m_variables["SELFAUTOPARENT"] = parent;
+    m_variables["SELFAUTOGRANDPARENT"] = dirName(parent);
+}
+
+void KpseResolver::loadConfigFile(const string& fileName)
+{
+    std::ifstream file(fileName.c_str());
+    string line, logical;
+    while(std::getline(file, line)) {
+        if(!line.empty() && line[line.size()-1] == '\r')
+            line.resize(line.size()-1);
+        // Continuation lines are joined without their indentation
+        if(!logical.empty()) {
+            size_t indent = line.find_first_not_of(" \t");
+            line.erase(0, indent == string::npos ? line.size() : indent);
+        }
+        if(!line.empty() && line[line.size()-1] == '\\') {
+            logical += line.substr(0, line.size()-1);
+            continue;
+        }
+        logical += line;
+
+        size_t start = logical.find_first_not_of(" \t");
+        if(start == string::npos || logical[start] == '%' ||
+                                    logical[start] == '#') {
+            logical.clear();
+            continue;
+        }
+
+        size_t end = logical.find_first_of(" \t=", start);
+        string name = logical.substr(start, end - start);
+
+        string value;
+        if(end != string::npos) {
+            size_t vstart = logical.find_first_not_of(" \t", end);
+            if(vstart != string::npos && logical[vstart] == '=')
+                vstart = logical.find_first_not_of(" \t", vstart+1);
+            if(vstart != string::npos)
+                value = logical.substr(vstart);
+        }
+        logical.clear();
+
+        // Comments may follow the value after a blank
+        for(size_t n = 1; n < value.size(); ++n) {
+            if((value[n] == '%' || value[n] == '#') &&
+                    (value[n-1] == ' ' || value[n-1] == '\t')) {
+                value.resize(n);
+                break;
+            }
+        }
+        size_t vend = value.find_last_not_of(" \t");
+        value.resize(vend == string::npos ? 0 : vend + 1);
+
+        // Settings for other programs (VAR.progname) do not apply
+        if(name.empty() || name.find('.') != string::npos)
+            continue;
+
 #ifndef WINDOWS
-        if(fullname[0] != PATH_SEP)
-#else
-        if(fullname.size() < 3 ||
-                (fullname[1] == ':' && fullname[2] == PATH_SEP))
+        // texmf.cnf accepts ';' as a path separator everywhere
+        for(size_t n = 0; n < value.size(); ++n)
+            if(value[n] == ';') value[n] = ENV_SEP;
 #endif
-        {
-            fullname = dir + PATH_SEP + fullname;
+
+        // The first definition wins
+        m_variables.insert(std::make_pair(name, value));
+    }
+}
+
+bool KpseResolver::variable(const string& name, string& value) const
+{
+    Variables::const_iterator it = m_variables.find(name);
+
+    const char* env = m_useEnvironment ? getenv(name.c_str()) : NULL;
+    if(env) {
+        value = fillEmptyElements(env,
+                    it != m_variables.end() ? it->second : string());
+        return true;
+    }
+
+    if(it == m_variables.end()) return false;
+    value = it->second;
+    return true;
+}
+
+string KpseResolver::expandVariables(const string& value, int depth) const
+{
+    if(depth > MAX_EXPANSION_DEPTH) return string();
+
+    string result;
+    for(size_t n = 0; n < value.size(); ++n) {
+        if(value[n] != '$') {
+            result += value[n];
+            continue;
         }
+
+        string name;
+        if(n+1 < value.size() && value[n+1] == '{') {
+            size_t close = value.find('}', n+2);
+            if(close == string::npos) {
+                result += value[n];
+                continue;
+            }
+            name = value.substr(n+2, close-n-2);
+            n = close;
+        } else {
+            size_t m = n+1;
+            while(m < value.size() && (isalnum((unsigned char) value[m]) ||
+                                        value[m] == '_'))
+                ++m;
+            name = value.substr(n+1, m-n-1);
+            n = m-1;
+        }
+
+        string v;
+        if(!name.empty() && variable(name, v))
+            result += expandVariables(v, depth+1);
     }
+    return result;
+}
 
-    return fullname;
+string KpseResolver::expand(const string& value) const
+{
+    return expandVariables(value, 0);
+}
+
+void KpseResolver::expandPath(const string& value,
+                              vector<string>& result) const
+{
+    vector<string> pieces;
+    splitTopLevel(expandVariables(value, 0), ENV_SEP, pieces);
+
+    BOOST_FOREACH(const string& piece, pieces) {
+        vector<string> expanded;
+        expandBraces(piece, expanded);
+        BOOST_FOREACH(const string& e, expanded) {
+            // Variables inside braces may expand to path lists
+            vector<string> elements;
+            splitTopLevel(e, ENV_SEP, elements);
+            BOOST_FOREACH(const string& element, elements)
+                if(!element.empty()) result.push_back(element);
+        }
+    }
+}
+
+const vector<KpseResolver::PathElement>&
+KpseResolver::pathElements(const string& var)
+{
+    std::map<string, vector<PathElement> >::iterator it = m_paths.find(var);
+    if(it != m_paths.end()) return it->second;
+
+    string value;
+    if(!variable(var, value)) value = ".";
+
+    vector<string> dirs;
+    expandPath(value, dirs);
+
+    vector<PathElement>& elements = m_paths[var];
+    BOOST_FOREACH(string dir, dirs) {
+        PathElement elem;
+        elem.dbOnly = startsWith(dir, "!!");
+        if(elem.dbOnly) dir = dir.substr(2);
+
+        if(!dir.empty() && dir[0] == '~' &&
+                (dir.size() == 1 || dir[1] == PATH_SEP)) {
+            const char* home = getenv("HOME");
+            dir = string(home ? home : "") + dir.substr(1);
+        }
+
+        elem.recursive = endsWith(dir, string(2, PATH_SEP));
+        elem.dir = stripTrailingSeps(dir);
+        if(!elem.dir.empty()) elements.push_back(elem);
+    }
+
+    return elements;
+}
+
+void KpseResolver::loadDatabase(const string& root)
+{
+    string fileName = joinPath(root, "ls-R");
+    std::ifstream file(fileName.c_str());
+    if(file.fail()) {
+        fileName = joinPath(root, "ls-r");
+        file.clear();
+        file.open(fileName.c_str());
+    }
+    if(file.fail()) return;
+
+    m_databases.push_back(Database());
+    Database& db = m_databases.back();
+    db.root = root;
+    db.fileName = fileName;
+    FileIndex& index = db.files;
+
+    string line, dir = root;
+    while(std::getline(file, line)) {
+        if(!line.empty() && line[line.size()-1] == '\r')
+            line.resize(line.size()-1);
+        if(line.empty() || line[0] == '%')
+            continue;
+
+        if(line[line.size()-1] == ':' && (isAbsolute(line) ||
+                    startsWith(line, "./") || startsWith(line, "../"))) {
+            string sub = line.substr(0, line.size()-1);
+            if(startsWith(sub, "./")) sub = sub.substr(2);
+            dir = stripTrailingSeps(isAbsolute(sub) ?
+                                        sub : joinPath(root, sub));
+            continue;
+        }
+
+        index[line].push_back(dir);
+    }
+}
+
+const KpseResolver::DiskIndex& KpseResolver::diskIndex(const string& base)
+{
+    std::tr1::unordered_map<string, DiskIndex>::iterator it =
+                                            m_diskIndexes.find(base);
+    if(it != m_diskIndexes.end()) return it->second;
+
+    DiskIndex& index = m_diskIndexes[base];
+
+    // Breadth first, so that shallower files are found first
+    std::set<std::pair<dev_t, ino_t> > visited;
+    vector<std::pair<string, int> > queue(1, std::make_pair(string(), 0));
+    for(size_t q = 0; q < queue.size(); ++q) {
+        string sub = queue[q].first;
+        int depth = queue[q].second;
+        string path = joinPath(base, sub);
+
+        struct stat st;
+        if(::stat(path.c_str(), &st) != 0 ||
+                !visited.insert(std::make_pair(st.st_dev, st.st_ino)).second)
+            continue;
+
+        // Stamp before reading so that concurrent changes invalidate
+        if(m_persistent) m_persistent->stamp(path);
+        index.dirs.push_back(path);
+
+        DIR* d = ::opendir(path.empty() ? "." : path.c_str());
+        if(!d) continue;
+
+        while(struct dirent* entry = ::readdir(d)) {
+            string name = entry->d_name;
+            if(name == "." || name == "..") continue;
+
+            string entrySub = joinPath(sub, name);
+            if(::stat(joinPath(base, entrySub).c_str(), &st) != 0)
+                continue;
+
+            if(S_ISDIR(st.st_mode)) {
+                if(depth < MAX_DIRECTORY_DEPTH)
+                    queue.push_back(std::make_pair(entrySub, depth+1));
+            } else {
+                index.files[name].push_back(sub);
+            }
+        }
+        ::closedir(d);
+    }
+
+    return index;
+}
+
+bool KpseResolver::findInElement(const PathElement& elem, const string& name,
+                                 const string& dir, string& result)
+{
+    string nameDir = dirName(name);
+    string baseName = nameDir.empty() ? name : name.substr(nameDir.size()+1);
+
+    string base = elem.dir;
+    string realBase = isAbsolute(base) || dir.empty() ?
+                            base : joinPath(dir, base);
+
+    string wanted = joinPath(base, nameDir);
+    string wantedSuffix = nameDir.empty() ? string() : PATH_SEP + nameDir;
+    string basePrefix = base == string(1, PATH_SEP) ? base : base + PATH_SEP;
+
+    BOOST_FOREACH(const Database& db, m_databases) {
+        if(base != db.root && !startsWith(base, db.root + PATH_SEP))
+            continue;
+
+        dependOn(db.fileName);
+        FileIndex::const_iterator it = db.files.find(baseName);
+        if(it == db.files.end()) continue;
+
+        BOOST_FOREACH(const string& d, it->second) {
+            if(d == wanted || (elem.recursive && startsWith(d, basePrefix) &&
+                                endsWith(d, wantedSuffix))) {
+                dependOn(d);
+                string fileName = joinPath(d, baseName);
+                if(fileExists(fileName)) {
+                    result = fileName;
+                    return true;
+                }
+            }
+        }
+    }
+
+    if(elem.dbOnly)
+        return false;
+
+    if(!elem.recursive) {
+        string fileName = joinPath(base, name);
+        dependOn(joinPath(realBase, nameDir));
+        if(fileExists(isAbsolute(fileName) || dir.empty() ?
+                            fileName : joinPath(dir, fileName))) {
+            result = fileName;
+            return true;
+        }
+        return false;
+    }
+
+    const DiskIndex& index = diskIndex(realBase);
+    BOOST_FOREACH(const string& d, index.dirs)
+        dependOn(d);
+
+    FileIndex::const_iterator it = index.files.find(baseName);
+    if(it == index.files.end()) return false;
+
+    BOOST_FOREACH(const string& sub, it->second) {
+        if(nameDir.empty() || sub == nameDir ||
+                endsWith(PATH_SEP + sub, wantedSuffix)) {
+            result = joinPath(joinPath(base, sub), baseName);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::string KpseResolver::find(const std::string& fname,
+                               const std::string& dir)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    string key = dir + '\n' + fname;
+    Variables::const_iterator cached = m_cache.find(key);
+    if(cached != m_cache.end()) return cached->second;
+
+    string& result = m_cache[key];
+
+    if(!m_configured) {
+        result = kpsewhichExec(fname, dir);
+        return result;
+    }
+
+    if(m_persistent && m_persistent->lookup(key, result))
+        return result;
+
+    vector<string> deps;
+    m_deps = &deps;
+    result = search(fname, dir);
+    m_deps = NULL;
+
+    if(m_persistent)
+        m_persistent->add(key, result, deps);
+
+    return result;
+}
+
+void KpseResolver::dependOn(const string& path)
+{
+    if(m_deps) {
+        if(m_persistent) m_persistent->stamp(path);
+        m_deps->push_back(path);
+    }
+}
+
+std::string KpseResolver::search(const std::string& fname,
+                                 const std::string& dir)
+{
+    if(!m_databasesLoaded) {
+        string value;
+        if(variable("TEXMFDBS", value)) {
+            vector<string> roots;
+            expandPath(value, roots);
+            BOOST_FOREACH(string root, roots) {
+                if(startsWith(root, "!!")) root = root.substr(2);
+                loadDatabase(stripTrailingSeps(root));
+            }
+        }
+        m_databasesLoaded = true;
+    }
+
+    // Format and candidate names, as kpsewhich guesses them
+    string var = "TEXINPUTS";
+    for(size_t n = 0; FORMATS[n][0]; ++n) {
+        if(endsWith(fname, FORMATS[n][0])) {
+            var = FORMATS[n][1];
+            break;
+        }
+    }
+
+    vector<string> names;
+    if(var == "TEXINPUTS") {
+        bool hasSuffix = false;
+        for(size_t n = 0; TEX_SUFFIXES[n]; ++n)
+            if(endsWith(fname, TEX_SUFFIXES[n])) hasSuffix = true;
+        if(!hasSuffix) names.push_back(fname + ".tex");
+    }
+    names.push_back(fname);
+
+    // Explicit paths are not searched for
+    if(isAbsolute(fname) || startsWith(fname, string(".") + PATH_SEP) ||
+                            startsWith(fname, string("..") + PATH_SEP)) {
+        BOOST_FOREACH(const string& name, names) {
+            string fileName = isAbsolute(name) || dir.empty() ?
+                                name : joinPath(dir, name);
+            dependOn(dirName(fileName));
+            if(fileExists(fileName))
+                return name;
+        }
+        return string();
+    }
+
+    string result;
+    BOOST_FOREACH(const PathElement& elem, pathElements(var)) {
+        BOOST_FOREACH(const string& name, names) {
+            if(findInElement(elem, name, dir, result))
+                return result;
+        }
+    }
+
+    return string();
+}
+
+KpseCache::Hash KpseResolver::fingerprint()
+{
+    // Everything that changes search results without changing the
+    // directories they depend on
+    KpseCache::Hash h = KpseCache::hash(m_useEnvironment ? "env" : "noenv");
+    BOOST_FOREACH(const string& fileName, m_configFiles) {
+        struct stat st;
+        h = KpseCache::hash(fileName, h);
+        if(::stat(fileName.c_str(), &st) == 0) {
+            h = KpseCache::hash(boost::lexical_cast<string>(
+                                st.st_mtim.tv_sec), h);
+            h = KpseCache::hash(boost::lexical_cast<string>(
+                                st.st_mtim.tv_nsec), h);
+        }
+    }
+
+    vector<string> vars(1, "TEXMFDBS");
+    vars.push_back("TEXINPUTS");
+    for(size_t n = 0; FORMATS[n][0]; ++n)
+        vars.push_back(FORMATS[n][1]);
+
+    BOOST_FOREACH(const string& var, vars) {
+        string value;
+        if(variable(var, value)) {
+            vector<string> dirs;
+            expandPath(value, dirs);
+            h = KpseCache::hash(var, h);
+            BOOST_FOREACH(const string& dir, dirs)
+                h = KpseCache::hash(dir + '\n', h);
+        }
+    }
+
+    return h;
+}
+
+bool KpseResolver::setPersistentCache(const std::string& fileName)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    if(m_persistent) m_persistent->save();
+    m_persistent.reset();
+
+    if(!m_configured || fileName.empty())
+        return false;
+
+    m_persistent.reset(new KpseCache(fileName, fingerprint()));
+    return true;
+}
+
+bool KpseResolver::savePersistentCache()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_persistent ? m_persistent->save() : false;
+}
+
+void KpseResolver::clearCache()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_cache.clear();
+    m_diskIndexes.clear();
 }
 
 } // namespace texpp
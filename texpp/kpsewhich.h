@@ -16,13 +16,138 @@
     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
+#ifndef __TEXPP_KPSEWHICH_H
+#define __TEXPP_KPSEWHICH_H
+
 #include <string>
+#include <vector>
+#include <map>
+#include <tr1/unordered_map>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <texpp/kpsecache.h>
 
 namespace texpp {
 
 std::string kpseextend(const std::string& fname);
+
+// Finds a file the way the kpsewhich program does. Uses the process
+// wide KpseResolver, falling back to running kpsewhich when no texmf
+// configuration can be found. Relative results are prefixed with dir.
 std::string kpsewhich(const std::string& fname,
                 const std::string& dir = std::string());
 
+// In-process implementation of the kpathsea search: reads texmf.cnf
+// and ls-R databases once, searches path lists such as TEXINPUTS
+// directly and remembers every answer, positive or negative.
+//
+// Supported path syntax: $VAR and ${VAR} references, {a,b} braces,
+// ~ for $HOME, // suffixes for recursive search, !! prefixes for
+// database-only search and empty elements of environment variables
+// standing for the texmf.cnf value.
+class KpseResolver: boost::noncopyable
+{
+public:
+    typedef boost::shared_ptr<KpseResolver> ptr;
+
+    // cnfPath is a path list of directories containing texmf.cnf,
+    // by default $TEXMFCNF or kpathsea's usual locations. Environment
+    // variables override texmf.cnf settings if useEnvironment is true.
+    explicit KpseResolver(const std::string& cnfPath = std::string(),
+                            bool useEnvironment = true);
+    ~KpseResolver();
+
+    // Returns the path of fname, relative to dir if the search path
+    // element was relative, or an empty string if it was not found
+    std::string find(const std::string& fname,
+                     const std::string& dir = std::string());
+
+    // True if texmf.cnf was found or the environment defines TEXINPUTS
+    bool configured() const { return m_configured; }
+
+    // Fully expanded value of a texmf.cnf or environment variable
+    std::string expand(const std::string& value) const;
+
+    // Forgets cached results and directory listings
+    void clearCache();
+
+    // Shares results with other processes through an on-disk cache,
+    // see KpseCache. New results are written back by
+    // savePersistentCache() and on destruction. The global resolver
+    // uses the file named by $TEXPP_KPSE_CACHE, if set.
+    bool setPersistentCache(const std::string& fileName);
+    bool savePersistentCache();
+    KpseCache::ptr persistentCache() const { return m_persistent; }
+
+    static KpseResolver& global();
+
+protected:
+    typedef std::tr1::unordered_map<std::string, std::string> Variables;
+    typedef std::tr1::unordered_map<std::string,
+                std::vector<std::string> > FileIndex;
+
+    struct PathElement
+    {
+        std::string dir;
+        bool recursive;
+        bool dbOnly;
+    };
+
+    struct Database
+    {
+        std::string root;
+        std::string fileName;
+        FileIndex files;
+    };
+
+    struct DiskIndex
+    {
+        std::vector<std::string> dirs;
+        FileIndex files;
+    };
+
+    void loadConfigFile(const std::string& fileName);
+    void loadDatabase(const std::string& root);
+    void setSelfAuto();
+
+    bool variable(const std::string& name, std::string& value) const;
+    std::string expandVariables(const std::string& value, int depth) const;
+    void expandPath(const std::string& value,
+                    std::vector<std::string>& result) const;
+
+    const std::vector<PathElement>& pathElements(const std::string& var);
+
+    std::string search(const std::string& fname, const std::string& dir);
+    bool findInElement(const PathElement& elem, const std::string& name,
+                       const std::string& dir, std::string& result);
+    const DiskIndex& diskIndex(const std::string& base);
+
+    // Records a path the current search depends on
+    void dependOn(const std::string& path);
+    KpseCache::Hash fingerprint();
+
+    bool m_useEnvironment;
+    bool m_configured;
+    bool m_databasesLoaded;
+
+    Variables   m_variables;
+    std::vector<std::string> m_configFiles;
+
+    std::vector<Database> m_databases;
+    std::tr1::unordered_map<std::string, DiskIndex> m_diskIndexes;
+    std::map<std::string, std::vector<PathElement> > m_paths;
+    Variables   m_cache;
+
+    KpseCache::ptr m_persistent;
+    std::vector<std::string>* m_deps;
+
+    boost::mutex m_mutex;
+};
+
 } // namespace texpp
 
+#endif
+
@@ -0,0 +1,252 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <texpp/latex/latex.h>
+#include <texpp/parser.h>
+
+#include <boost/lexical_cast.hpp>
+
+namespace texpp {
+namespace latex {
+
+namespace {
+
+// Value of the first word of an environment name group
+string environmentName(const Node::ptr& group)
+{
+    const Node::ChildrenList& c = group->children();
+    for(Node::ChildrenList::const_iterator it = c.begin(), e = c.end();
+                            it != e; ++it) {
+        if(it->first == "text_word")
+            return it->second->valueString();
+    }
+    return string();
+}
+
+} // namespace
+
+Node::ptr parseOptionalArgs(Parser& parser)
+{
+    Node::ptr node(new Node("optional_args"));
+    node->appendChild("optional_spaces", parser.parseOptionalSpaces());
+
+    if(parser.peekToken() && parser.peekToken()->isCharacter('[')) {
+        Node::ptr args(new Node("args"));
+        node->appendChild("args", args);
+        string value;
+        while(parser.peekToken()) {
+            value += parser.nextToken(&args->tokens())->value();
+            if(parser.lastToken()->isCharacter(']'))
+                break;
+        }
+        node->setValue(value.size() > 1 ?
+                        value.substr(1, value.size()-2) : string());
+    }
+
+    return node;
+}
+
+Node::ptr parseGeneralArg(Parser& parser, bool expand)
+{
+    Node::ptr node(new Node("args"));
+    node->appendChild("optional_spaces", parser.parseOptionalSpaces());
+
+    string value;
+    if(parser.peekToken() && parser.peekToken()->isCharacter('{')) {
+        Node::ptr textNode = parser.parseGeneralText(expand);
+        node->appendChild("group", textNode);
+        Node::ptr balanced = textNode->child("balanced_text");
+        if(balanced) {
+            const vector<Token::ptr>& tokens = balanced->tokens();
+            for(size_t n = 0; n < tokens.size(); ++n)
+                value += tokens[n]->value();
+        }
+    } else {
+        node->appendChild("token", parser.parseToken());
+    }
+
+    node->setValue(value);
+    return node;
+}
+
+bool Begin::invoke(Parser& parser, shared_ptr<Node> node)
+{
+    Node::ptr group = parser.parseGroup(Parser::GROUP_NORMAL);
+    node->appendChild("env_type", group);
+
+    parser.beginCustomGroup("environment_" + environmentName(group));
+    return true;
+}
+
+bool End::invoke(Parser& parser, shared_ptr<Node> node)
+{
+    Node::ptr group = parser.parseGroup(Parser::GROUP_NORMAL);
+    node->appendChild("env_type", group);
+
+    if(environmentName(group) == "end")
+        parser.end();
+
+    parser.endCustomGroup();
+    return true;
+}
+
+bool Usepackage::invoke(Parser& parser, shared_ptr<Node> node)
+{
+    Node::ptr argNode = parseOptionalArgs(parser);
+    Node::ptr pkgNode = parseGeneralArg(parser);
+    node->appendChild("args", argNode);
+    node->appendChild("package", pkgNode);
+
+    if(pkgNode->valueString() == "inputenc") {
+        node->setType("inputenc");
+        node->setValue(argNode->valueAny());
+    }
+
+    return true;
+}
+
+bool Newcommand::invoke(Parser& parser, shared_ptr<Node> node)
+{
+    node->appendChild("cmd", parseGeneralArg(parser));
+    node->appendChild("args", parseOptionalArgs(parser));
+    node->appendChild("opt", parseOptionalArgs(parser));
+    node->appendChild("def", parseGeneralArg(parser));
+    return true;
+}
+
+bool Newenvironment::invoke(Parser& parser, shared_ptr<Node> node)
+{
+    node->appendChild("nam", parseGeneralArg(parser));
+    node->appendChild("args", parseOptionalArgs(parser));
+    node->appendChild("begdef", parseGeneralArg(parser));
+    node->appendChild("enddef", parseGeneralArg(parser));
+    return true;
+}
+
+bool Newtheorem::invoke(Parser& parser, shared_ptr<Node> node)
+{
+    if(parser.peekToken() && parser.peekToken()->isCharacter('*'))
+        node->appendChild("star", parser.parseToken());
+
+    node->appendChild("env_nam", parseGeneralArg(parser));
+
+    node->appendChild("optional_spaces", parser.parseOptionalSpaces());
+    if(parser.peekToken() && parser.peekToken()->isCharacter('[')) {
+        node->appendChild("numbered_like", parseOptionalArgs(parser));
+        node->appendChild("caption", parseGeneralArg(parser));
+    } else {
+        node->appendChild("caption", parseGeneralArg(parser));
+        node->appendChild("within", parseOptionalArgs(parser));
+    }
+    return true;
+}
+
+bool Documentclass::invoke(Parser& parser, shared_ptr<Node> node)
+{
+    node->appendChild("options", parseOptionalArgs(parser));
+    node->appendChild("class", parseGeneralArg(parser));
+    return true;
+}
+
+bool Def::invoke(Parser& parser, shared_ptr<Node> node)
+{
+    node->appendChild("token", parser.parseControlSequence());
+    Node::ptr args(new Node("def_args"));
+    node->appendChild("args", args);
+    while(parser.peekToken() &&
+            !parser.peekToken()->isCharacterCat(Token::CC_BGROUP))
+        parser.nextToken(&args->tokens());
+
+    node->appendChild("def", parser.parseGeneralText(false));
+    return true;
+}
+
+bool Input::invoke(Parser& parser, shared_ptr<Node> node)
+{
+    Node::ptr fnameNode = parser.parseFileName();
+    node->appendChild("file_name", fnameNode);
+
+    string fname = fnameNode->value(string());
+    if(!fname.empty() && fname[0] == '{')
+        fname = fname.size() > 1 ? fname.substr(1, fname.size()-2)
+                                 : string();
+
+    // Temporary disable this package
+    if(fname == "xy")
+        return true;
+
+    string fullname = parser.resolveFile(fname);
+    parser.input(fname, fullname);
+    return true;
+}
+
+void initSymbols(Parser& parser)
+{
+    #define __TEXPP_SET_CATCODE(ch, cc) \
+        parser.setSymbol("catcode" + \
+            boost::lexical_cast<string>(int(ch)), int(Token::cc))
+
+    __TEXPP_SET_CATCODE('{', CC_BGROUP);
+    __TEXPP_SET_CATCODE('}', CC_EGROUP);
+    __TEXPP_SET_CATCODE('$', CC_MATHSHIFT);
+    __TEXPP_SET_CATCODE('\t', CC_SPACE);
+
+    #undef __TEXPP_SET_CATCODE
+
+    #define __TEXPP_SET_COMMAND(name, T, ...) \
+        parser.setSymbol("\\" name, \
+            Command::ptr(new T("\\" name, ##__VA_ARGS__)))
+
+    __TEXPP_SET_COMMAND("begin", Begin);
+    __TEXPP_SET_COMMAND("end", End);
+
+    __TEXPP_SET_COMMAND("usepackage", Usepackage);
+
+    __TEXPP_SET_COMMAND("newcommand", Newcommand);
+    __TEXPP_SET_COMMAND("renewcommand", Newcommand);
+    __TEXPP_SET_COMMAND("providecommand", Newcommand);
+
+    __TEXPP_SET_COMMAND("newenvironment", Newenvironment);
+    __TEXPP_SET_COMMAND("renewenvironment", Newenvironment);
+
+    __TEXPP_SET_COMMAND("newtheorem", Newtheorem);
+
+    __TEXPP_SET_COMMAND("def", Def);
+    __TEXPP_SET_COMMAND("edef", Def);
+    __TEXPP_SET_COMMAND("gdef", Def);
+    __TEXPP_SET_COMMAND("xdef", Def);
+
+    __TEXPP_SET_COMMAND("documentclass", Documentclass);
+    __TEXPP_SET_COMMAND("documentstyle", Documentclass);
+
+    __TEXPP_SET_COMMAND("input", Input);
+
+    #undef __TEXPP_SET_COMMAND
+
+    // \(, \), \[ and \] all stand for a math shift
+    Token::ptr mathToken(new Token(Token::TOK_CHARACTER,
+                                   Token::CC_MATHSHIFT, "$"));
+    const char* const math[] = { "\\(", "\\)", "\\[", "\\]" };
+    for(size_t n = 0; n < sizeof(math)/sizeof(math[0]); ++n)
+        parser.setSymbol(math[n],
+                Command::ptr(new TokenCommand(mathToken)));
+}
+
+} // namespace latex
+} // namespace texpp
+
@@ -0,0 +1,122 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __TEXPP_LATEX_LATEX_H
+#define __TEXPP_LATEX_LATEX_H
+
+#include <texpp/common.h>
+#include <texpp/command.h>
+
+namespace texpp {
+
+class Parser;
+
+namespace latex {
+
+// Stubs of the LaTeX commands that matter for the structure of a
+// document. They only parse their arguments into the document tree,
+// except \begin and \end which open and close environment_<name>
+// groups and \input which reads the file.
+
+class Begin: public Command
+{
+public:
+    explicit Begin(const string& name): Command(name) {}
+    bool invoke(Parser& parser, shared_ptr<Node> node);
+};
+
+class End: public Command
+{
+public:
+    explicit End(const string& name): Command(name) {}
+    bool invoke(Parser& parser, shared_ptr<Node> node);
+};
+
+// \usepackage, a node of type inputenc with the encoding as its value
+// for \usepackage[enc]{inputenc}
+class Usepackage: public Command
+{
+public:
+    explicit Usepackage(const string& name): Command(name) {}
+    bool invoke(Parser& parser, shared_ptr<Node> node);
+};
+
+// \newcommand, \renewcommand and \providecommand
+class Newcommand: public Command
+{
+public:
+    explicit Newcommand(const string& name): Command(name) {}
+    bool invoke(Parser& parser, shared_ptr<Node> node);
+};
+
+// \newenvironment and \renewenvironment
+class Newenvironment: public Command
+{
+public:
+    explicit Newenvironment(const string& name): Command(name) {}
+    bool invoke(Parser& parser, shared_ptr<Node> node);
+};
+
+class Newtheorem: public Command
+{
+public:
+    explicit Newtheorem(const string& name): Command(name) {}
+    bool invoke(Parser& parser, shared_ptr<Node> node);
+};
+
+// \documentclass and \documentstyle
+class Documentclass: public Command
+{
+public:
+    explicit Documentclass(const string& name): Command(name) {}
+    bool invoke(Parser& parser, shared_ptr<Node> node);
+};
+
+// \def and friends record the definition without defining anything
+class Def: public Command
+{
+public:
+    explicit Def(const string& name): Command(name) {}
+    bool invoke(Parser& parser, shared_ptr<Node> node);
+};
+
+// \input{file} and \input file, except for the xy package
+class Input: public Command
+{
+public:
+    explicit Input(const string& name): Command(name) {}
+    bool invoke(Parser& parser, shared_ptr<Node> node);
+};
+
+// [options] after optional spaces, the node value is the options text
+// if there are any
+shared_ptr<Node> parseOptionalArgs(Parser& parser);
+
+// {text} or a single token after optional spaces, the node value is
+// the text
+shared_ptr<Node> parseGeneralArg(Parser& parser, bool expand = false);
+
+// Sets the catcodes and commands of the LaTeX style on top of the
+// plain TeX ones set by base::initSymbols
+void initSymbols(Parser& parser);
+
+} // namespace latex
+} // namespace texpp
+
+#endif
+
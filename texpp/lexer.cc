@@ -19,6 +19,7 @@
 #include <texpp/lexer.h>
 
 #include <iostream>
+#include <algorithm>
 
 namespace texpp {
 
@@ -46,10 +47,49 @@ Lexer::Lexer(const string& fileName, shared_ptr<std::istream> file,
     init();
 }
 
+Lexer::Lexer(const Lexer& other, shared_ptr<std::istream> file)
+    : m_fileShared(file), m_file(file.get()),
+      m_fileName(other.m_fileName),
+      m_lineOrig(other.m_lineOrig), m_lineTex(other.m_lineTex),
+      m_linePos(other.m_linePos), m_lineNo(other.m_lineNo),
+      m_charPos(other.m_charPos), m_charEnd(other.m_charEnd),
+      m_state(other.m_state), m_char(other.m_char),
+      m_catCode(other.m_catCode), m_endlinechar(other.m_endlinechar),
+      m_interactive(other.m_interactive), m_saveLines(other.m_saveLines)
+{
+    std::copy(other.m_catcode, other.m_catcode + 256, m_catcode);
+}
+
 Lexer::~Lexer()
 {
 }
 
+shared_ptr<Lexer> Lexer::checkpoint() const
+{
+    return shared_ptr<Lexer>(new Lexer(*this, shared_ptr<std::istream>()));
+}
+
+shared_ptr<Lexer> Lexer::resume(shared_ptr<std::istream> file,
+                                const Lexer* lines) const
+{
+    shared_ptr<Lexer> lexer(new Lexer(*this, file));
+
+    // Skip the part of the input which was already read
+    std::streamoff pos = inputPos();
+    if(!file->seekg(pos)) {
+        file->clear();
+        file->ignore(pos);
+    }
+
+    if(m_saveLines && lines) {
+        size_t count = std::min(m_lineNo, lines->m_lines.size());
+        lexer->m_lines.assign(lines->m_lines.begin(),
+                              lines->m_lines.begin() + count);
+    }
+
+    return lexer;
+}
+
 void Lexer::init()
 {
     m_endlinechar = '\r';
@@ -57,7 +57,22 @@ public:
     int catcode(int ch) const { return m_catcode[ch]; }
     void setCatcode(int ch, int code) { m_catcode[ch] = code; }
 
+    // Number of bytes read from the input so far
+    size_t inputPos() const { return m_linePos + m_lineOrig.size(); }
+    bool eof() const { return m_state == ST_EOF; }
+
+    // Copy of the lexer state which reads nothing until resumed.
+    // Saved lines are not copied.
+    shared_ptr<Lexer> checkpoint() const;
+    // Returns a lexer continuing from this checkpoint on file, a new
+    // version of the input identical to the old one up to inputPos().
+    // Saved lines read before the checkpoint are taken from lines.
+    shared_ptr<Lexer> resume(shared_ptr<std::istream> file,
+                             const Lexer* lines = NULL) const;
+
 protected:
+    Lexer(const Lexer& other, shared_ptr<std::istream> file);
+
     void init();
 
     Token::ptr newToken(Token::Type type,
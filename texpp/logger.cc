@@ -85,6 +85,18 @@ ConsoleLogger::~ConsoleLogger()
 
 bool ConsoleLogger::log(Level level, const string& message,
                             Parser& parser, Token::ptr token)
+{
+    write(format(level, message, parser, token));
+    return true;
+}
+
+void ConsoleLogger::write(const string& text)
+{
+    std::cout << text << std::flush;
+}
+
+string ConsoleLogger::format(Level level, const string& message,
+                            Parser& parser, Token::ptr token)
 {
     /*
     if(level <= TRACING && parser.symbol("tracingonline", int(0)) <= 0)
@@ -129,27 +141,26 @@ bool ConsoleLogger::log(Level level, const string& message,
         }
     }
 
+    string out;
     BOOST_FOREACH(unsigned char ch, r1.str()) {
         if(m_linePos >= MAX_LINE_CHARS) {
-            std::cout << '\n';
+            out += '\n';
             m_linePos = 0;
         }
-        std::cout << ch;
+        out += ch;
         if(ch == '\n')
             m_linePos = 0;
         else
             ++m_linePos;
     }
 
-    std::cout << std::flush;
-
     if(m_linePos && (parser.lexer()->interactive() ||
                         level <= TRACING)) {
-        std::cout << std::endl;
+        out += '\n';
         m_linePos = 0;
     }
 
-    return true;
+    return out;
 }
 
 } // namespace texpp
@@ -49,6 +49,10 @@ public:
     //const string& levelName(Level level) const;
     string tokenLines(Parser& parser, shared_ptr<Token> token) const;
 
+    // Returns false if messages of the given level are always discarded,
+    // letting callers skip formatting them. Parser caches the answers.
+    virtual bool enabled(Level) const { return true; }
+
     virtual bool log(Level level, const string& message,
                     Parser& parser, shared_ptr<Token> token) = 0;
 };
@@ -56,6 +60,7 @@ public:
 class NullLogger: public Logger
 {
 public:
+    bool enabled(Level) const { return false; }
     bool log(Level, const string&, Parser&, shared_ptr<Token>) { return true; }
 };
 
@@ -67,6 +72,14 @@ public:
     bool log(Level level, const string& message,
                 Parser& parser, shared_ptr<Token> token);
 protected:
+    // Formats the message the way TeX prints it on the terminal,
+    // wrapping long lines and updating m_linePos
+    string format(Level level, const string& message,
+                Parser& parser, shared_ptr<Token> token);
+
+    // Outputs formatted text
+    virtual void write(const string& text);
+
     unsigned int m_linePos;
 };
 
@@ -0,0 +1,69 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <texpp/memstream.h>
+
+namespace texpp {
+
+MemoryStreamBuf::MemoryStreamBuf(const char* data, size_t size)
+{
+    // The get area is never written to, the cast is only
+    // required by the std::streambuf interface
+    char* begin = const_cast<char*>(data);
+    setg(begin, begin, begin + size);
+}
+
+MemoryStreamBuf::pos_type MemoryStreamBuf::seekoff(off_type off,
+                std::ios_base::seekdir way, std::ios_base::openmode which)
+{
+    if(!(which & std::ios_base::in))
+        return pos_type(off_type(-1));
+
+    off_type pos;
+    if(way == std::ios_base::beg) pos = off;
+    else if(way == std::ios_base::cur) pos = gptr() - eback() + off;
+    else pos = egptr() - eback() + off;
+
+    if(pos < 0 || pos > egptr() - eback())
+        return pos_type(off_type(-1));
+
+    setg(eback(), eback() + pos, egptr());
+    return pos_type(pos);
+}
+
+MemoryStreamBuf::pos_type MemoryStreamBuf::seekpos(pos_type pos,
+                std::ios_base::openmode which)
+{
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+std::streamsize MemoryStreamBuf::showmanyc()
+{
+    return gptr() < egptr() ? std::streamsize(egptr() - gptr()) : -1;
+}
+
+MemoryStream::MemoryStream(const char* data, size_t size,
+                           shared_ptr<const void> owner)
+    : std::istream(NULL), m_buf(data, size),
+      m_data(data), m_size(size), m_owner(owner)
+{
+    rdbuf(&m_buf);
+}
+
+} // namespace texpp
+
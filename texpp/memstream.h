@@ -0,0 +1,66 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __TEXPP_MEMSTREAM_H
+#define __TEXPP_MEMSTREAM_H
+
+#include <texpp/common.h>
+
+#include <istream>
+#include <streambuf>
+
+namespace texpp {
+
+// Stream buffer reading directly from a contiguous memory range.
+// The memory is never copied and must outlive the buffer.
+class MemoryStreamBuf: public std::streambuf
+{
+public:
+    MemoryStreamBuf(const char* data, size_t size);
+
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir way,
+                std::ios_base::openmode which = std::ios_base::in);
+    pos_type seekpos(pos_type pos,
+                std::ios_base::openmode which = std::ios_base::in);
+    std::streamsize showmanyc();
+};
+
+// Input stream over a memory range. The optional owner is kept alive
+// as long as the stream exists, which allows handing out streams over
+// memory owned by someone else (a mapped file, a python buffer, ...)
+class MemoryStream: public std::istream
+{
+public:
+    MemoryStream(const char* data, size_t size,
+                 shared_ptr<const void> owner = shared_ptr<const void>());
+
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+protected:
+    MemoryStreamBuf         m_buf;
+    const char*             m_data;
+    size_t                  m_size;
+    shared_ptr<const void>  m_owner;
+};
+
+} // namespace texpp
+
+#endif
+
@@ -0,0 +1,299 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <texpp/nodequery.h>
+#include <texpp/parser.h>
+
+#include <boost/lexical_cast.hpp>
+
+namespace {
+
+// Matches type against name, where '*' stands for any sequence and
+// '\\' makes the next character literal
+bool globMatch(const char* name, const char* type)
+{
+    const char* star = NULL;
+    const char* resume = NULL;
+    while(*type) {
+        if(*name == '*') {
+            star = name++;
+            resume = type;
+        } else if(*name == '\\' && name[1] == *type) {
+            name += 2; ++type;
+        } else if(*name != '\\' && *name == *type) {
+            ++name; ++type;
+        } else if(star) {
+            name = star + 1;
+            type = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while(*name == '*') ++name;
+    return *name == 0;
+}
+
+inline bool isNameChar(char c)
+{
+    return c != ' ' && c != '\t' && c != '\n' && c != '>' && c != '|' &&
+           c != '+' && c != ':' && c != '(' && c != ')' && c != '!' &&
+           c != '\\';
+}
+
+inline void skipSpaces(const std::string& s, size_t& pos)
+{
+    while(pos < s.size() && (s[pos] == ' ' || s[pos] == '\t' ||
+                             s[pos] == '\n')) ++pos;
+}
+
+const char NOT_UNDER[] = ":not-under(";
+
+} // namespace
+
+namespace texpp {
+
+string NodeQuery::escape(const string& name)
+{
+    string result;
+    result.reserve(name.size());
+    for(size_t n = 0; n < name.size(); ++n) {
+        if(!isNameChar(name[n]) || name[n] == '*')
+            result += '\\';
+        result += name[n];
+    }
+    return result;
+}
+
+bool NodeQuery::TypeSet::contains(const string& type) const
+{
+    for(size_t n = 0; n < names.size(); ++n)
+        if(globMatch(names[n].c_str(), type.c_str()))
+            return !negated;
+    return negated;
+}
+
+NodeQuery::NodeQuery(const string& selector)
+    : m_selector(selector)
+{
+    parse();
+}
+
+bool NodeQuery::fail(const string& message, size_t pos)
+{
+    m_error = message + " at position " +
+                boost::lexical_cast<string>(pos);
+    m_steps.clear();
+    return false;
+}
+
+bool NodeQuery::parseTypes(size_t& pos, TypeSet& types)
+{
+    const string& s = m_selector;
+    skipSpaces(s, pos);
+    if(pos < s.size() && s[pos] == '!') {
+        types.negated = true;
+        ++pos;
+    }
+
+    for(;;) {
+        size_t start = pos;
+        while(pos < s.size()) {
+            if(s[pos] == '\\') {
+                if(pos + 1 >= s.size())
+                    return fail("expected a character after '\\'", pos);
+                pos += 2;
+            } else if(isNameChar(s[pos])) {
+                ++pos;
+            } else {
+                break;
+            }
+        }
+        if(pos == start)
+            return fail("expected a node type", pos);
+        types.names.push_back(s.substr(start, pos - start));
+
+        if(pos >= s.size() || s[pos] != '|') break;
+        ++pos;
+    }
+    return true;
+}
+
+bool NodeQuery::parse()
+{
+    const string& s = m_selector;
+    size_t pos = 0;
+    bool child = false;
+
+    skipSpaces(s, pos);
+    if(pos < s.size() && s[pos] == '>') {
+        child = true;
+        ++pos;
+    }
+
+    for(;;) {
+        skipSpaces(s, pos);
+        if(!m_steps.empty() && m_steps.back().run)
+            return fail("only the last step can match runs", pos);
+
+        Step step;
+        step.child = child;
+        if(!parseTypes(pos, step.types)) return false;
+
+        if(pos < s.size() && s[pos] == '+') {
+            step.run = true;
+            ++pos;
+        }
+
+        if(s.compare(pos, sizeof(NOT_UNDER)-1, NOT_UNDER) == 0) {
+            pos += sizeof(NOT_UNDER)-1;
+            if(!parseTypes(pos, step.excluded)) return false;
+            skipSpaces(s, pos);
+            if(pos >= s.size() || s[pos] != ')')
+                return fail("expected ')'", pos);
+            ++pos;
+        }
+
+        m_steps.push_back(step);
+
+        size_t end = pos;
+        skipSpaces(s, pos);
+        if(pos >= s.size()) break;
+
+        if(s[pos] == '>') {
+            child = true;
+            ++pos;
+        } else if(pos > end) {
+            child = false;
+        } else {
+            return fail(string("unexpected '") + s[pos] + "'", pos);
+        }
+    }
+    return true;
+}
+
+// matched[k] is set if the node matches step k: its type is in the
+// set and its parent matched step k-1 (child) or step k-1 matched
+// an ancestor with no excluded node in between (descendant), which is
+// what reachable[k] of the parent records. The root counts as having
+// matched step -1.
+bool NodeQuery::enter(const Node& node, const Frame& parent,
+                        bool parentIsRoot, Frame& frame) const
+{
+    size_t count = m_steps.size();
+    frame.matched.assign(count, 0);
+    frame.reachable.assign(count, 0);
+
+    bool live = false;
+    for(size_t k = 0; k < count; ++k) {
+        const Step& step = m_steps[k];
+        bool context = step.child ?
+                (k == 0 ? parentIsRoot : parent.matched[k-1] != 0) :
+                parent.reachable[k] != 0;
+        if(context && step.types.contains(node.type()))
+            frame.matched[k] = 1;
+
+        if((k > 0 && frame.matched[k-1]) || (parent.reachable[k] &&
+                        !step.excluded.contains(node.type())))
+            frame.reachable[k] = 1;
+
+        live = live || frame.matched[k] || frame.reachable[k];
+    }
+    return live;
+}
+
+void NodeQuery::walk(const Node::ptr& node, const Frame& frame,
+                        bool isRoot, vector<Match>& result) const
+{
+    const Step& last = m_steps.back();
+    bool inRun = false;
+    size_t runAt = 0;
+    Frame childFrame;
+
+    const Node::ChildrenList& children = node->children();
+    for(size_t n = 0; n < children.size(); ++n) {
+        const Node::ptr& child = children[n].second;
+        bool live = enter(*child, frame, isRoot, childFrame);
+
+        if(childFrame.matched.back()) {
+            if(last.run && inRun) {
+                // Matches below earlier run members may follow it
+                ++result[runAt].count;
+            } else {
+                Match match = { node, n, 1 };
+                runAt = result.size();
+                result.push_back(match);
+            }
+            inRun = true;
+        } else {
+            inRun = false;
+        }
+
+        if(live)
+            walk(child, childFrame, false, result);
+    }
+}
+
+vector<NodeQuery::Match> NodeQuery::select(const Node::ptr& root) const
+{
+    vector<Match> result;
+    if(!root || m_steps.empty()) return result;
+
+    Frame frame;
+    frame.matched.assign(m_steps.size(), 0);
+    frame.reachable.assign(m_steps.size(), 0);
+    frame.reachable[0] = 1;
+
+    walk(root, frame, true, result);
+    return result;
+}
+
+vector<Node::ptr> NodeQuery::nodes(const Node::ptr& root) const
+{
+    vector<Node::ptr> result;
+    vector<Match> matches = select(root);
+    for(size_t n = 0; n < matches.size(); ++n) {
+        const Match& m = matches[n];
+        for(size_t i = 0; i < m.count; ++i)
+            result.push_back(m.parent->child(m.index + i));
+    }
+    return result;
+}
+
+vector< std::pair<size_t, size_t> >
+NodeQuery::spans(const Node::ptr& root) const
+{
+    vector< std::pair<size_t, size_t> > result;
+    vector<Match> matches = select(root);
+    for(size_t n = 0; n < matches.size(); ++n) {
+        const Match& m = matches[n];
+        std::pair<size_t, size_t> span(Token::npos, Token::npos);
+        for(size_t i = 0; i < m.count; ++i) {
+            std::pair<size_t, size_t> pos =
+                        m.parent->child(m.index + i)->sourcePos();
+            if(pos.first != Token::npos) {
+                if(span.first == Token::npos) span.first = pos.first;
+                span.second = pos.second;
+            }
+        }
+        result.push_back(span);
+    }
+    return result;
+}
+
+} // namespace texpp
+
@@ -0,0 +1,126 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __TEXPP_NODEQUERY_H
+#define __TEXPP_NODEQUERY_H
+
+#include <texpp/common.h>
+
+namespace texpp {
+
+class Node;
+
+// Selects nodes of a Node tree using a compact selector language,
+// evaluated natively in one walk over the tree:
+//
+//   selector := [">"] step (combinator step)*
+//   step     := types ["+"] [":not-under(" types ")"]
+//   types    := ["!"] name ("|" name)*
+//
+// A name matches a node type, "*" in a name matches any sequence of
+// characters, a backslash makes the next character literal (see
+// escape()) and a leading "!" negates the set. Steps are separated by
+// ">" (child) or by spaces (descendant). The first step matches below
+// the root given to select(), or only its children with a leading
+// ">"; the root itself never matches.
+//
+// "X:not-under(Y)" only matches X if no node between it and the node
+// matched by the previous step (or the root) has a type in Y, e.g.
+// "text_word:not-under(environment_*math*|group)". A "+" on the last
+// step matches maximal runs of consecutive siblings instead of single
+// nodes, e.g. "environment_document > text_word|text_space+".
+class NodeQuery
+{
+public:
+    typedef shared_ptr<NodeQuery> ptr;
+
+    // Children parent[index .. index+count) of a node, count is 1
+    // unless the selector matches runs
+    struct Match
+    {
+        shared_ptr<Node> parent;
+        size_t index;
+        size_t count;
+    };
+
+    // An invalid selector matches nothing, see error()
+    explicit NodeQuery(const string& selector);
+
+    const string& selector() const { return m_selector; }
+    bool isValid() const { return m_error.empty(); }
+    const string& error() const { return m_error; }
+
+    // Quotes name so that it matches exactly that node type when used
+    // as a name in a selector
+    static string escape(const string& name);
+
+    // Matches in document order
+    vector<Match> select(const shared_ptr<Node>& root) const;
+
+    // Every node of every match
+    vector< shared_ptr<Node> > nodes(const shared_ptr<Node>& root) const;
+
+    // Source span of every match, as in Node::sourcePos()
+    vector< std::pair<size_t, size_t> >
+                spans(const shared_ptr<Node>& root) const;
+
+protected:
+    struct TypeSet
+    {
+        TypeSet(): negated(false) {}
+        bool contains(const string& type) const;
+
+        vector<string> names;
+        bool negated;
+    };
+
+    struct Step
+    {
+        Step(): child(false), run(false) {}
+
+        TypeSet types;
+        TypeSet excluded;
+        bool child;
+        bool run;
+    };
+
+    // Per-node evaluation state, one entry per step
+    struct Frame
+    {
+        vector<char> matched;   // the node matches the step
+        vector<char> reachable; // the step may match below the node
+    };
+
+    bool parse();
+    bool parseTypes(size_t& pos, TypeSet& types);
+    bool fail(const string& message, size_t pos);
+
+    bool enter(const Node& node, const Frame& parent,
+                    bool parentIsRoot, Frame& frame) const;
+    void walk(const shared_ptr<Node>& node, const Frame& frame,
+                    bool isRoot, vector<Match>& result) const;
+
+    string          m_selector;
+    string          m_error;
+    vector<Step>    m_steps;
+};
+
+} // namespace texpp
+
+#endif
+
@@ -0,0 +1,141 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <texpp/nodetable.h>
+#include <texpp/parser.h>
+
+#include <boost/foreach.hpp>
+
+namespace {
+
+// Intermediate file states while folding a subtree, see appendNode
+const texpp::NodeTable::Index FILE_UNSET = -2;
+const texpp::NodeTable::Index FILE_MIXED = -3;
+
+inline texpp::NodeTable::Index mergeFile(texpp::NodeTable::Index a,
+                                         texpp::NodeTable::Index b)
+{
+    if(a == FILE_UNSET) return b;
+    if(b == FILE_UNSET || a == b) return a;
+    return FILE_MIXED;
+}
+
+} // namespace
+
+namespace texpp {
+
+void NodeTable::clear()
+{
+    m_types.clear();
+    m_parents.clear();
+    m_roles.clear();
+    m_files.clear();
+    m_starts.clear();
+    m_ends.clear();
+    m_valueOffsets.clear();
+    m_valuePool.clear();
+
+    m_typeNames.clear();
+    m_roleNames.clear();
+    m_fileNames.clear();
+
+    m_typeIds.clear();
+    m_roleIds.clear();
+    m_fileIds.clear();
+}
+
+void NodeTable::build(Node::ptr root)
+{
+    clear();
+    m_valueOffsets.push_back(0);
+    if(!root) return;
+
+    appendNode(root, -1, -1);
+
+    // Replace intermediate file states by -1 only once the whole
+    // tree is folded, parents need to distinguish them from real ids
+    BOOST_FOREACH(Index& file, m_files) {
+        if(file < 0) file = -1;
+    }
+}
+
+NodeTable::Index NodeTable::intern(const string& name,
+            vector<string>& names, unordered_map<string, Index>& ids)
+{
+    unordered_map<string, Index>::iterator it = ids.find(name);
+    if(it != ids.end()) return it->second;
+
+    Index id = Index(names.size());
+    names.push_back(name);
+    ids.insert(std::make_pair(name, id));
+    return id;
+}
+
+NodeTable::Index NodeTable::appendNode(const Node::ptr& node,
+                                        Index parent, Index role)
+{
+    Index row = Index(m_types.size());
+
+    m_types.push_back(intern(node->type(), m_typeNames, m_typeIds));
+    m_parents.push_back(parent);
+    m_roles.push_back(role);
+
+    const string& value = node->valueString();
+    m_valuePool += value;
+    m_valueOffsets.push_back(Offset(m_valuePool.size()));
+
+    // Own tokens come first, exactly as in Node::sourcePos()
+    Index file = FILE_UNSET;
+    Offset start = -1, end = -1;
+    BOOST_FOREACH(const Token::ptr& token, node->tokens()) {
+        if(token->fileNamePtr())
+            file = mergeFile(file, intern(token->fileName(),
+                                        m_fileNames, m_fileIds));
+        else
+            file = FILE_MIXED;
+
+        if(token->lineNo() != 0) {
+            if(start < 0) start = token->linePos() + token->charPos();
+            end = token->linePos() + token->charEnd();
+        }
+    }
+
+    m_files.push_back(file);
+    m_starts.push_back(start);
+    m_ends.push_back(end);
+
+    typedef pair<string, Node::ptr> C;
+    BOOST_FOREACH(const C& c, node->children()) {
+        Index childRow = appendNode(c.second, row,
+                            intern(c.first, m_roleNames, m_roleIds));
+        file = mergeFile(file, m_files[childRow]);
+        if(m_starts[childRow] >= 0) {
+            if(start < 0) start = m_starts[childRow];
+            end = m_ends[childRow];
+        }
+    }
+
+    m_files[row] = file;
+    m_starts[row] = start;
+    m_ends[row] = end;
+
+    return row;
+}
+
+} // namespace texpp
+
@@ -0,0 +1,94 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __TEXPP_NODETABLE_H
+#define __TEXPP_NODETABLE_H
+
+#include <texpp/common.h>
+
+#include <boost/cstdint.hpp>
+
+namespace texpp {
+
+class Node;
+
+// Flat, columnar representation of a Node tree. Nodes are stored in
+// pre-order, so the root is always row 0 and every parent precedes
+// its children. All columns have one entry per node except
+// valueOffsets which has size()+1 entries: the string value of node i
+// is valuePool[valueOffsets[i] .. valueOffsets[i+1]) (empty for nodes
+// whose value is not a string). Root parent and role are -1, as are
+// the file id of nodes spanning several (or no) files and the offsets
+// of nodes without source tokens. Offsets match Node::sourcePos().
+class NodeTable
+{
+public:
+    typedef shared_ptr<NodeTable> ptr;
+    typedef boost::int32_t Index;
+    typedef boost::int64_t Offset;
+
+    NodeTable() {}
+    explicit NodeTable(shared_ptr<Node> root) { build(root); }
+
+    void build(shared_ptr<Node> root);
+    void clear();
+
+    size_t size() const { return m_types.size(); }
+
+    // Per-node columns
+    const vector<Index>& types() const { return m_types; }
+    const vector<Index>& parents() const { return m_parents; }
+    const vector<Index>& roles() const { return m_roles; }
+    const vector<Index>& files() const { return m_files; }
+    const vector<Offset>& starts() const { return m_starts; }
+    const vector<Offset>& ends() const { return m_ends; }
+    const vector<Offset>& valueOffsets() const { return m_valueOffsets; }
+    const string& valuePool() const { return m_valuePool; }
+
+    // Lookup tables for interned ids
+    const vector<string>& typeNames() const { return m_typeNames; }
+    const vector<string>& roleNames() const { return m_roleNames; }
+    const vector<string>& fileNames() const { return m_fileNames; }
+
+protected:
+    Index intern(const string& name, vector<string>& names,
+                    unordered_map<string, Index>& ids);
+    Index appendNode(const shared_ptr<Node>& node, Index parent, Index role);
+
+    vector<Index>   m_types;
+    vector<Index>   m_parents;
+    vector<Index>   m_roles;
+    vector<Index>   m_files;
+    vector<Offset>  m_starts;
+    vector<Offset>  m_ends;
+    vector<Offset>  m_valueOffsets;
+    string          m_valuePool;
+
+    vector<string>  m_typeNames;
+    vector<string>  m_roleNames;
+    vector<string>  m_fileNames;
+
+    unordered_map<string, Index> m_typeIds;
+    unordered_map<string, Index> m_roleIds;
+    unordered_map<string, Index> m_fileIds;
+};
+
+} // namespace texpp
+
+#endif
+
@@ -0,0 +1,104 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include <texpp/outputsink.h>
+
+#include <boost/scoped_array.hpp>
+#include <boost/foreach.hpp>
+
+#include <fstream>
+
+namespace {
+
+// File stream owning its write buffer. The buffer has to be installed
+// before the file is opened to be used by std::filebuf.
+class BufferedFileStream: public std::ofstream
+{
+public:
+    BufferedFileStream(const std::string& fileName, size_t bufferSize)
+        : m_buffer(bufferSize ? new char[bufferSize] : NULL)
+    {
+        if(bufferSize)
+            rdbuf()->pubsetbuf(m_buffer.get(), bufferSize);
+        open(fileName.c_str());
+    }
+
+    ~BufferedFileStream() { close(); }
+
+private:
+    boost::scoped_array<char> m_buffer;
+};
+
+} // namespace
+
+namespace texpp {
+
+shared_ptr<std::ostream> FileOutputSink::open(const string& fileName)
+{
+    shared_ptr<std::ostream> stream(
+                new BufferedFileStream(fileName, m_bufferSize));
+    if(stream->fail())
+        return shared_ptr<std::ostream>();
+
+    // Forget streams which were closed in the meantime
+    size_t n = 0;
+    for(size_t i = 0; i < m_streams.size(); ++i)
+        if(!m_streams[i].expired()) m_streams[n++] = m_streams[i];
+    m_streams.resize(n);
+
+    m_streams.push_back(stream);
+    return stream;
+}
+
+void FileOutputSink::flush()
+{
+    BOOST_FOREACH(const boost::weak_ptr<std::ostream>& weak, m_streams) {
+        if(shared_ptr<std::ostream> stream = weak.lock())
+            stream->flush();
+    }
+}
+
+shared_ptr<std::ostream> MemoryOutputSink::open(const string& fileName)
+{
+    shared_ptr<std::ostringstream> stream(new std::ostringstream);
+    m_files[fileName] = stream;
+    return stream;
+}
+
+bool MemoryOutputSink::exists(const string& fileName) const
+{
+    return m_files.count(fileName);
+}
+
+string MemoryOutputSink::contents(const string& fileName) const
+{
+    Files::const_iterator it = m_files.find(fileName);
+    return it != m_files.end() ? it->second->str() : string();
+}
+
+vector<string> MemoryOutputSink::fileNames() const
+{
+    vector<string> names;
+    BOOST_FOREACH(const Files::value_type& file, m_files)
+        names.push_back(file.first);
+    return names;
+}
+
+} // namespace texpp
+
@@ -0,0 +1,93 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#ifndef __TEXPP_OUTPUTSINK_H
+#define __TEXPP_OUTPUTSINK_H
+
+#include <texpp/common.h>
+
+#include <ostream>
+#include <sstream>
+#include <map>
+
+#include <boost/weak_ptr.hpp>
+
+namespace texpp {
+
+// Destination of the files written by \openout and \write. Streams
+// returned by open() are buffered: \write does not flush them, data
+// reaches the destination at \closeout, on flush() or when the
+// stream is destroyed.
+class OutputSink
+{
+public:
+    typedef shared_ptr<OutputSink> ptr;
+
+    virtual ~OutputSink() {}
+
+    // Opens fileName for writing, discarding previous contents.
+    // Returns an empty pointer if the file can not be written.
+    virtual shared_ptr<std::ostream> open(const string& fileName) = 0;
+
+    // Writes out buffered data of every stream which is still open,
+    // called by the parser at the end of the job
+    virtual void flush() {}
+};
+
+// Writes files to disk through write buffers of bufferSize bytes
+class FileOutputSink: public OutputSink
+{
+public:
+    enum { DEFAULT_BUFFER_SIZE = 64 << 10 };
+
+    explicit FileOutputSink(size_t bufferSize = DEFAULT_BUFFER_SIZE)
+        : m_bufferSize(bufferSize) {}
+
+    shared_ptr<std::ostream> open(const string& fileName);
+    void flush();
+
+    size_t bufferSize() const { return m_bufferSize; }
+
+protected:
+    size_t m_bufferSize;
+    vector< boost::weak_ptr<std::ostream> > m_streams;
+};
+
+// Keeps written files in memory and never touches the disk. The last
+// contents written to each file name stay available after \closeout.
+class MemoryOutputSink: public OutputSink
+{
+public:
+    shared_ptr<std::ostream> open(const string& fileName);
+
+    bool exists(const string& fileName) const;
+    string contents(const string& fileName) const;
+    vector<string> fileNames() const;
+
+    void clear() { m_files.clear(); }
+
+protected:
+    typedef std::map<string, shared_ptr<std::ostringstream> > Files;
+    Files m_files;
+};
+
+} // namespace texpp
+
+#endif
+
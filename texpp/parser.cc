@@ -18,6 +18,10 @@
 
 #include <texpp/parser.h>
 #include <texpp/logger.h>
+#include <texpp/profiler.h>
+#include <texpp/prefetch.h>
+#include <texpp/outputsink.h>
+#include <texpp/vfs.h>
 
 #include <texpp/base/base.h>
 #include <texpp/base/show.h>
@@ -31,6 +35,8 @@
 #include <texpp/base/misc.h>
 #include <texpp/base/files.h>
 
+#include <texpp/latex/latex.h>
+
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -227,14 +233,18 @@ std::pair<size_t, size_t> Node::sourcePos() const
 
 Parser::Parser(const string& fileName, std::istream* file,
         const string& workdir, bool interactive, bool ignoreEmergency,
-        shared_ptr<Logger> logger)
+        shared_ptr<Logger> logger,
+        Style style)
     : m_workdir(workdir), m_ignoreEmergency(ignoreEmergency),
-      m_logger(logger), m_groupLevel(0),
+      m_logger(logger), m_logLevels(0), m_tracingCommands(0),
+      m_tracingMacros(0), m_tracingRestores(0), m_groupLevel(0),
       m_end(false), m_endinput(false), m_endinputNow(false),
+      m_parsingFileName(false),
+      m_checkpointInterval(0), m_trailingTokens(0),
       m_lineNo(1), m_mode(NULLMODE), m_prevMode(NULLMODE),
       m_hasOutput(false), m_currentGroupType(GROUP_DOCUMENT),
       m_customGroupBegin(false), m_customGroupEnd(false),
-      m_interaction(ERRORSTOPMODE)
+      m_interaction(ERRORSTOPMODE), m_style(style)
 {
     m_lexer = shared_ptr<Lexer>(new Lexer(fileName, file, interactive, true));
     init();
@@ -242,14 +252,18 @@ Parser::Parser(const string& fileName, std::istream* file,
 
 Parser::Parser(const string& fileName, shared_ptr<std::istream> file,
         const string& workdir, bool interactive, bool ignoreEmergency,
-        shared_ptr<Logger> logger)
+        shared_ptr<Logger> logger,
+        Style style)
     : m_workdir(workdir), m_ignoreEmergency(ignoreEmergency),
-      m_logger(logger), m_groupLevel(0),
+      m_logger(logger), m_logLevels(0), m_tracingCommands(0),
+      m_tracingMacros(0), m_tracingRestores(0), m_groupLevel(0),
       m_end(false), m_endinput(false), m_endinputNow(false),
+      m_parsingFileName(false),
+      m_checkpointInterval(0), m_trailingTokens(0),
       m_lineNo(1), m_mode(NULLMODE), m_prevMode(NULLMODE),
       m_hasOutput(false), m_currentGroupType(GROUP_DOCUMENT),
       m_customGroupBegin(false), m_customGroupEnd(false),
-      m_interaction(ERRORSTOPMODE)
+      m_interaction(ERRORSTOPMODE), m_style(style)
 {
     m_lexer = shared_ptr<Lexer>(new Lexer(fileName, file, interactive, true));
     init();
@@ -262,13 +276,23 @@ void Parser::init()
                         shared_ptr<Logger>(new ConsoleLogger) :
                         shared_ptr<Logger>(new NullLogger);
 
+    m_outputSink = shared_ptr<OutputSink>(new FileOutputSink);
+    m_vfs = shared_ptr<Vfs>(new FileSystemVfs);
+
+    updateLogLevels();
     base::initSymbols(*this);
+    if(m_style == STYLE_LATEX)
+        latex::initSymbols(*this);
+
+    if(!logEnabled(Logger::WRITE))
+        return;
     
     string banner = BANNER;
     if(!lexer()->interactive()) {
         char t[256];
         time_t tt = std::time(NULL);
-        std::strftime(t, sizeof(t), " %e %b %Y %H:%M", std::localtime(&tt));
+        std::tm tm; localtime_r(&tt, &tm);
+        std::strftime(t, sizeof(t), " %e %b %Y %H:%M", &tm);
         string ts(t);
         boost::algorithm::to_upper(ts);
         banner += ts;
@@ -276,6 +300,29 @@ void Parser::init()
     m_logger->log(Logger::WRITE, banner, *this, Token::ptr());
 }
 
+void Parser::updateLogLevels()
+{
+    static const Logger::Level levels[] = {
+        Logger::MTRACING, Logger::TRACING, Logger::PLAIN,
+        Logger::MESSAGE, Logger::WRITE, Logger::SHOW,
+        Logger::ERROR, Logger::CRITICAL, Logger::UNIMPLEMENTED
+    };
+    static const size_t levelsCount = sizeof(levels)/sizeof(levels[0]);
+
+    bool enabled[levelsCount];
+    for(size_t n = 0; n < levelsCount; ++n)
+        enabled[n] = m_logger && m_logger->enabled(levels[n]);
+
+    // Each bit covers five levels, custom levels in between
+    // behave like the closest predefined level below them
+    m_logLevels = 0;
+    size_t n = 0;
+    for(int bit = 0; bit < 32; ++bit) {
+        while(n+1 < levelsCount && levels[n+1] <= bit*5) ++n;
+        if(enabled[n]) m_logLevels |= 1u << bit;
+    }
+}
+
 const string& Parser::modeName() const
 {
     if(m_mode > DMATH)
@@ -306,6 +353,9 @@ void Parser::setSymbol(const string& name, const any& value, bool global)
     }
     it->second.second = value;
     setSpecialSymbol(name, value);
+
+    if(m_checkpointInterval)
+        m_changedSymbols.insert(name);
 }
 
 void Parser::setSymbolDefault(const string& name, const any& defaultValue)
@@ -313,12 +363,22 @@ void Parser::setSymbolDefault(const string& name, const any& defaultValue)
     pair<SymbolTable::iterator, bool> p = m_symbols.insert(
         std::make_pair(name, std::make_pair(0, any())));
 
-    if(p.second) // new item
+    if(p.second) { // new item
         p.first->second = std::make_pair(0, defaultValue);
+        if(m_checkpointInterval)
+            m_changedSymbols.insert(name);
+    }
 }
 
 void Parser::setSpecialSymbol(const string& name, const any& value)
 {
+    if(name.compare(0, 7, "tracing") == 0) {
+        int v = value.type() == typeid(int) ? *unsafe_any_cast<int>(&value) : 0;
+        if(name == "tracingcommands") m_tracingCommands = v;
+        else if(name == "tracingmacros") m_tracingMacros = v;
+        else if(name == "tracingrestores") m_tracingRestores = v;
+    }
+
     if(value.type() == typeid(int)) {
         if(name == "endlinechar") {
             m_lexer->setEndlinechar(*unsafe_any_cast<int>(&value));
@@ -359,9 +419,11 @@ void Parser::endGroup()
         if(l >= 0) {
             it->second = item.second;
             setSpecialSymbol(it->first, it->second.second);
+            if(m_checkpointInterval)
+                m_changedSymbols.insert(it->first);
         }
 
-        if(symbol("tracingrestores", int(0)) > 0) {
+        if(m_tracingRestores > 0 && logEnabled(Logger::TRACING)) {
             string str;
             any value;
 
@@ -470,6 +532,8 @@ Node::ptr Parser::rawExpandToken(Token::ptr token)
     if(cmd && !macro)
         return Node::ptr();
 
+    ProfileScope profile(m_profiler.get(), token);
+
     Node::ptr node(new Node("macro"));
     Node::ptr child(new Node("control_token"));
     child->tokens().push_back(token);
@@ -531,7 +595,8 @@ Node::ptr Parser::rawExpandToken(Token::ptr token)
         cinfo.branch = 0;
         cinfo.parsed = true;
 
-        if(symbol("tracingcommands", int(0)) > 1/* && mode() != NULLMODE*/) {
+        if(m_tracingCommands > 1/* && mode() != NULLMODE*/ &&
+                logEnabled(Logger::TRACING)) {
             string str;
             if(cinfo.ifcase) {
                 str = "case " +
@@ -562,8 +627,9 @@ Node::ptr Parser::rawExpandToken(Token::ptr token)
         } else if((m_conditionals.empty() ||
                 m_conditionals.back().branch < 0 ||
                 !m_conditionals.back().ifcase)) {
-            logger()->log(Logger::ERROR,
-                "Extra " + macro->texRepr(this), *this, token);
+            if(logEnabled(Logger::ERROR))
+                logger()->log(Logger::ERROR,
+                    "Extra " + macro->texRepr(this), *this, token);
         } else {
             ConditionalInfo& cinfo = m_conditionals.back();
             ++cinfo.branch;
@@ -586,8 +652,9 @@ Node::ptr Parser::rawExpandToken(Token::ptr token)
             expanded = false;
         } else if((m_conditionals.empty() ||
                 m_conditionals.back().branch < 0)) {
-            logger()->log(Logger::ERROR,
-                "Extra " + macro->texRepr(this), *this, token);
+            if(logEnabled(Logger::ERROR))
+                logger()->log(Logger::ERROR,
+                    "Extra " + macro->texRepr(this), *this, token);
         } else {
             ConditionalInfo& cinfo = m_conditionals.back();
             if(cinfo.ifcase) {
@@ -614,8 +681,9 @@ Node::ptr Parser::rawExpandToken(Token::ptr token)
                 token->isLastInLine(), token->fileNamePtr()))));
             expanded = false;
         } else if(m_conditionals.empty()) {
-            logger()->log(Logger::ERROR,
-                "Extra " + macro->texRepr(this), *this, token);
+            if(logEnabled(Logger::ERROR))
+                logger()->log(Logger::ERROR,
+                    "Extra " + macro->texRepr(this), *this, token);
         } else {
             m_conditionals.pop_back();
         }
@@ -642,6 +710,7 @@ Node::ptr Parser::rawExpandToken(Token::ptr token)
             );
 #warning XXX node can consists from tokens from several files!
     node->setValue(newTokens);
+    profile.addTokens(newTokens->size() - 1);
 
     return node;
 }
@@ -910,11 +979,12 @@ void Parser::input(const string& fileName, const string& fullName)
 {
     // TODO: stop scaning genericText on file boundary
     // (for example \def\x{...} can't be spread across several files
-    shared_ptr<std::istream> istream(new std::ifstream(fullName.c_str()));
-    if(istream->fail()) {
-        logger()->log(Logger::ERROR,
-            "I can't find file `" + fileName + "'",
-            *this, lastToken());
+    shared_ptr<std::istream> istream = openFile(fullName);
+    if(!istream) {
+        if(logEnabled(Logger::ERROR))
+            logger()->log(Logger::ERROR,
+                "I can't find file `" + fileName + "'",
+                *this, lastToken());
 
         logger()->log(Logger::ERROR,
             "Emergency stop",
@@ -937,7 +1007,22 @@ void Parser::input(const string& fileName, const string& fullName)
     m_lexer = lexer;
     m_tokenQueue.clear();
 
-    logger()->log(Logger::MESSAGE, "(" + fullName, *this, lastToken());
+    if(logEnabled(Logger::MESSAGE))
+        logger()->log(Logger::MESSAGE, "(" + fullName, *this, lastToken());
+}
+
+string Parser::resolveFile(const string& fname)
+{
+    return m_vfs ? m_vfs->resolve(fname, m_workdir) : string();
+}
+
+shared_ptr<std::istream> Parser::openFile(const string& fullName)
+{
+    if(m_prefetcher) {
+        shared_ptr<std::istream> istream = m_prefetcher->open(fullName);
+        if(istream) return istream;
+    }
+    return m_vfs ? m_vfs->open(fullName) : shared_ptr<std::istream>();
 }
 
 void Parser::endinputNow()
@@ -1074,6 +1159,7 @@ Node::ptr Parser::parseCommand(Command::ptr command)
             int lastChildNumber = node->childrenCount();
             node->appendChild("prefix", parseControlSequence());
 
+            ProfileScope profile(m_profiler.get(), token);
             m_commandStack.push_back(command);
             bool r = command->invokeWithPrefixes(*this, node, prefixes);
             m_commandStack.pop_back();
@@ -1096,13 +1182,15 @@ Node::ptr Parser::parseCommand(Command::ptr command)
                 return node;
             }
         }
-        logger()->log(Logger::ERROR,
-            "You can't use a prefix with `" +
-            token->meaning(this) + "'",
-            *this, lastToken());
+        if(logEnabled(Logger::ERROR))
+            logger()->log(Logger::ERROR,
+                "You can't use a prefix with `" +
+                token->meaning(this) + "'",
+                *this, lastToken());
     } else {
         node->appendChild("control_sequence", parseControlSequence());
 
+        ProfileScope profile(m_profiler.get(), lastToken());
         m_commandStack.push_back(command);
         command->invoke(*this, node); // XXX check errors
         m_commandStack.pop_back();
@@ -1518,11 +1606,9 @@ Node::ptr Parser::parseNormalDimen(bool fil, bool mu)
     }
 
     if(!i_found && !mu) {
-        static vector<string> kw_internal_units;
-        if(kw_internal_units.empty()) {
-            kw_internal_units.push_back("em");
-            kw_internal_units.push_back("ex");
-        }
+        static const char* internal_units[] = { "em", "ex" };
+        static vector<string> kw_internal_units(internal_units,
+                internal_units + sizeof(internal_units)/sizeof(char*));
 
         iunit = parseKeyword(kw_internal_units);
         if(iunit) {
@@ -1568,10 +1654,7 @@ Node::ptr Parser::parseNormalDimen(bool fil, bool mu)
 
     if(!mu) {
         // <optional true>
-        static vector<string> kw_optional_true;
-        if(kw_optional_true.empty()) {
-            kw_optional_true.push_back("true");
-        }
+        static vector<string> kw_optional_true(1, "true");
 
         Node::ptr optional_true = parseKeyword(kw_optional_true);
         if(optional_true) {
@@ -1579,7 +1662,7 @@ Node::ptr Parser::parseNormalDimen(bool fil, bool mu)
             int mag = symbol("mag", int(0));
             int activemag = symbol("activemag", mag);
             setSymbol("activemag", activemag);
-            if(activemag != mag) {
+            if(activemag != mag && logEnabled(Logger::ERROR)) {
                 logger()->log(Logger::ERROR,
                     "Incompatible magnification (" +
                     boost::lexical_cast<string>(mag) + ");\n" +
@@ -1615,18 +1698,10 @@ Node::ptr Parser::parseNormalDimen(bool fil, bool mu)
             {1238,1157},    // dd
             {14856,1157},   // cc
         };
-        static vector<string> kw_physical_units;
-        if(kw_physical_units.empty()) {
-            kw_physical_units.push_back("pt");
-            kw_physical_units.push_back("sp");
-            kw_physical_units.push_back("in");
-            kw_physical_units.push_back("pc");
-            kw_physical_units.push_back("cm");
-            kw_physical_units.push_back("mm");
-            kw_physical_units.push_back("bp");
-            kw_physical_units.push_back("dd");
-            kw_physical_units.push_back("cc");
-        }
+        static const char* physical_units[] = {
+            "pt", "sp", "in", "pc", "cm", "mm", "bp", "dd", "cc" };
+        static vector<string> kw_physical_units(physical_units,
+                physical_units + sizeof(physical_units)/sizeof(char*));
 
         units = parseKeyword(kw_physical_units);
         if(units) {
@@ -2008,11 +2083,12 @@ Node::ptr Parser::parseBalancedText(bool expand,
                             nToken->value()[0] : 0;
                 int n = std::isdigit(ch) ? ch - '0' : 0;
                 if(n <= 0 || n > paramCount) {
-                    logger()->log(Logger::ERROR,
-                        "Illegal parameter number in definition of "
-                        + (nameToken ? nameToken->texRepr(this) :
-                           escapestr() + "undefined"),
-                        *this, lastToken());
+                    if(logEnabled(Logger::ERROR))
+                        logger()->log(Logger::ERROR,
+                            "Illegal parameter number in definition of "
+                            + (nameToken ? nameToken->texRepr(this) :
+                               escapestr() + "undefined"),
+                            *this, lastToken());
                     tokens->push_back(Token::create(
                         token->type(), token->catCode(), token->value()));
                 }
@@ -2090,14 +2166,12 @@ Node::ptr Parser::parseGeneralText(bool expand, bool implicitLbrace)
 
 Node::ptr Parser::parseFileName()
 {
-    static bool parsing = false;
-
     Node::ptr node(new Node("file_name"));
 
-    if(parsing)
+    if(m_parsingFileName)
         return node;
     else
-        parsing = true;
+        m_parsingFileName = true;
 
     string fileName;
 
@@ -2117,7 +2191,7 @@ Node::ptr Parser::parseFileName()
 
     resetNoexpand();
 
-    parsing = false;
+    m_parsingFileName = false;
     return node;
 }
 
@@ -2140,8 +2214,11 @@ Node::ptr Parser::parseTextWord()
 
 void Parser::traceCommand(Token::ptr token, bool expanding)
 {
-    int tracingcommands = symbol("tracingcommands", int(0));
+    int tracingcommands = m_tracingCommands;
     if(tracingcommands > 0) {
+        // The checks below are cheap and keep m_prevMode in sync,
+        // only the message itself is skipped when it is not logged
+        bool enabled = logEnabled(Logger::TRACING);
         string str;
         if(token->isControl()) {
             Command::ptr cmd = symbol(token, Command::ptr());
@@ -2159,26 +2236,26 @@ void Parser::traceCommand(Token::ptr token, bool expanding)
                 if(expanding) {
                     if(tracingcommands < 2) return;
                     if(dynamic_pointer_cast<base::UserMacro>(cmd)) return;
-                    str += cmd->texRepr(this);
-                } else {
+                    if(enabled) str += cmd->texRepr(this);
+                } else if(enabled) {
                     str += escapestr();
                     str += "relax";
                 }
                 //std::remove(str.begin(), str.end(), '\n');
             } else if(cmd) {
-                str += cmd->texRepr(this);
+                if(enabled) str += cmd->texRepr(this);
             } else {
                 str = "undefined";
             }
-        } else {
+        } else if(enabled) {
             str = token->meaning(this);
         }
         if(m_prevMode != m_mode) {
-            str = modeName() + " mode: " + str;
+            if(enabled) str = modeName() + " mode: " + str;
             m_prevMode = m_mode;
         }
         //logger()->log(Logger::TRACING, str, *this, lastToken());
-        logger()->log(Logger::TRACING, str, *this, token);
+        if(enabled) logger()->log(Logger::TRACING, str, *this, token);
     }
 }
 
@@ -2187,7 +2264,13 @@ Node::ptr Parser::parseGroup(GroupType groupType)
     GroupType prevGroupType = m_currentGroupType;
     m_currentGroupType = groupType;
 
-    Node::ptr node(new Node("group"));
+    Node::ptr node;
+    if(groupType == GROUP_DOCUMENT && m_resumeDocument) {
+        // reparse(): continue the document restored from a checkpoint
+        node.swap(m_resumeDocument);
+    } else {
+        node = Node::ptr(new Node("group"));
+    }
 
     if(groupType == GROUP_NORMAL) {
         if(helperIsImplicitCharacter(Token::CC_BGROUP)) {
@@ -2220,6 +2303,9 @@ Node::ptr Parser::parseGroup(GroupType groupType)
     }
 
     while(true) {
+        if(groupType == GROUP_DOCUMENT && m_checkpointInterval)
+            recordCheckpoint(node);
+
         if(!peekToken()) {
             if(groupType == GROUP_MATH || groupType == GROUP_DMATH) {
                 Node::ptr group_end(new Node("group_end"));
@@ -2257,14 +2343,16 @@ Node::ptr Parser::parseGroup(GroupType groupType)
                         msg = "Extra }, or forgotten $";
                         break;
                     case GROUP_SUPER:
-                        msg = "Extra }, or forgotten " +
-                            Token(Token::TOK_CONTROL, Token::CC_ESCAPE,
-                                    "\\endgroup").texRepr(this);
+                        if(logEnabled(Logger::ERROR))
+                            msg = "Extra }, or forgotten " +
+                                Token(Token::TOK_CONTROL, Token::CC_ESCAPE,
+                                        "\\endgroup").texRepr(this);
                         break;
                     default:
                         msg = "Extra }";
                 }
-                logger()->log(Logger::ERROR, msg, *this, lastToken());
+                if(logEnabled(Logger::ERROR))
+                    logger()->log(Logger::ERROR, msg, *this, lastToken());
                 node->appendChild("ignored_egroup", parseToken());
             }
 
@@ -2334,9 +2422,10 @@ Node::ptr Parser::parseGroup(GroupType groupType)
             node->appendChild("text_character", parseTextCharacter());
 
         } else if(peekToken()->isCharacterCat(Token::CC_PARAM)) {
-            m_logger->log(Logger::ERROR,
-                "You can't use `" + peekToken()->meaning(this) + "' in " +
-                modeName() + " mode", *this, lastToken());
+            if(logEnabled(Logger::ERROR))
+                m_logger->log(Logger::ERROR,
+                    "You can't use `" + peekToken()->meaning(this) + "' in " +
+                    modeName() + " mode", *this, lastToken());
             node->appendChild("error_param", parseToken());
 
         } else if(peekToken()->isControl()) {
@@ -2370,11 +2459,13 @@ Node::ptr Parser::parseGroup(GroupType groupType)
                             msg = "Display math should end with $$";
                             t = Token::create(Token::TOK_CHARACTER,
                                         Token::CC_MATHSHIFT, "$");
-                        } else {
+                        } else if(logEnabled(Logger::ERROR)) {
                             msg = "Extra " + Token(Token::TOK_CONTROL,
                                 Token::CC_ESCAPE, "\\endgroup").texRepr(this);
                         }
-                        logger()->log(Logger::ERROR, msg, *this, lastToken());
+                        if(logEnabled(Logger::ERROR))
+                            logger()->log(Logger::ERROR, msg,
+                                                *this, lastToken());
                         if(groupType != GROUP_DOCUMENT) {
                             Node::ptr group_end(new Node("group_end"));
                             if(t) {
@@ -2447,8 +2538,15 @@ Node::ptr Parser::parse()
             + lexer()->fileName() + "\n", *this, Token::ptr());
     }
 
+    m_checkpoints.clear();
+    m_changedSymbols.clear();
+
     setMode(VERTICAL);
-    Node::ptr document = parseGroup(GROUP_DOCUMENT);
+    return finishDocument(parseGroup(GROUP_DOCUMENT));
+}
+
+Node::ptr Parser::finishDocument(Node::ptr document)
+{
     document->setType("document");
     
     // Some skipped tokens may still exists even when
@@ -2457,15 +2555,158 @@ Node::ptr Parser::parse()
     while(node->childrenCount() > 0)
         node = node->child(node->childrenCount()-1);
 
+    size_t count = node->tokens().size();
     nextToken(&node->tokens());
 
+    if(m_outputSink)
+        m_outputSink->flush();
+
     if(!lexer()->fileName().empty()) {
         logger()->log(Logger::MESSAGE,
             " )", *this, Token::ptr());
     }
 
+    // Remember what has to be undone if this node is reused by reparse()
+    if(m_checkpointInterval) {
+        m_document = document;
+        m_trailingNode = node;
+        m_trailingTokens = node->tokens().size() - count;
+    }
+
     return document;
 }
 
+Node::ptr Parser::reparse(shared_ptr<std::istream> file, size_t editBegin)
+{
+    if(m_checkpoints.empty() || !m_document)
+        return Node::ptr();
+
+    // The last checkpoint whose input lies entirely before the edit.
+    // The line read at the checkpoint must be complete: its end was
+    // found by looking at the next byte.
+    size_t n = m_checkpoints.size();
+    while(n > 1) {
+        const Checkpoint& c = m_checkpoints[n-1];
+        const string& line = c.lexer->line();
+        if(c.inputPos < editBegin || (c.inputPos == editBegin &&
+                (line.empty() || line[line.size()-1] == '\n')))
+            break;
+        --n;
+    }
+
+    if(m_trailingNode) {
+        vector<Token::ptr>& tokens = m_trailingNode->tokens();
+        tokens.resize(tokens.size() - m_trailingTokens);
+        m_trailingNode.reset();
+    }
+
+    restoreCheckpoint(n-1, file);
+
+    if(!lexer()->fileName().empty()) {
+        logger()->log(Logger::MESSAGE,
+            "(" + lexer()->fileName() + "\n", *this, Token::ptr());
+    }
+
+    return finishDocument(parseGroup(GROUP_DOCUMENT));
+}
+
+void Parser::recordCheckpoint(Node::ptr document)
+{
+    if(!m_inputStack.empty() || !m_tokenQueue.empty() ||
+            !m_conditionals.empty() || !m_commandStack.empty() ||
+            !m_noexpandTokens.empty() || m_groupLevel != 0 ||
+            m_end || m_endinput || m_endinputNow ||
+            m_afterassignmentToken || m_lockToken ||
+            m_lexer->interactive() || m_lexer->eof())
+        return;
+
+    size_t pos = m_lexer->inputPos();
+    if(!m_checkpoints.empty() &&
+            pos < m_checkpoints.back().inputPos + m_checkpointInterval)
+        return;
+
+    m_checkpoints.push_back(Checkpoint());
+    Checkpoint& c = m_checkpoints.back();
+
+    c.inputPos = pos;
+    c.children = document->childrenCount();
+    c.lexer = m_lexer->checkpoint();
+    // Peeked tokens may still be changed by the rest of the parse
+    BOOST_FOREACH(const Token::ptr& token, m_tokenSource) {
+        c.tokenSource.push_back(Token::ptr(new Token(*token)));
+        if(token == m_token) c.token = c.tokenSource.back();
+    }
+    if(m_token && !c.token)
+        c.token = Token::ptr(new Token(*m_token));
+    c.lastToken = m_lastToken;
+    c.aftergroupTokensStack = m_aftergroupTokensStack;
+    c.lineNo = m_lineNo;
+    c.mode = m_mode;
+    c.prevMode = m_prevMode;
+    c.hasOutput = m_hasOutput;
+    c.interaction = m_interaction;
+
+    if(m_checkpoints.size() == 1) {
+        c.symbols.assign(m_symbols.begin(), m_symbols.end());
+    } else {
+        c.symbols.reserve(m_changedSymbols.size());
+        BOOST_FOREACH(const string& name, m_changedSymbols) {
+            SymbolTable::const_iterator it = m_symbols.find(name);
+            if(it != m_symbols.end())
+                c.symbols.push_back(*it);
+        }
+    }
+    m_changedSymbols.clear();
+}
+
+void Parser::restoreCheckpoint(size_t n, shared_ptr<std::istream> file)
+{
+    m_checkpoints.resize(n+1);
+    m_changedSymbols.clear();
+
+    m_symbols.clear();
+    BOOST_FOREACH(const Checkpoint& c, m_checkpoints) {
+        BOOST_FOREACH(const SymbolStack::value_type& item, c.symbols)
+            m_symbols[item.first] = item.second;
+    }
+
+    const Checkpoint& c = m_checkpoints.back();
+
+    m_lexer = c.lexer->resume(file, m_lexer.get());
+    m_token = c.token;
+    m_tokenSource = c.tokenSource;
+    m_lastToken = c.lastToken;
+    m_aftergroupTokensStack = c.aftergroupTokensStack;
+    m_lineNo = c.lineNo;
+    m_mode = c.mode;
+    m_prevMode = c.prevMode;
+    m_hasOutput = c.hasOutput;
+    m_interaction = c.interaction;
+
+    m_tokenQueue.clear();
+    m_noexpandTokens.clear();
+    m_inputStack.clear();
+    m_conditionals.clear();
+    m_commandStack.clear();
+    m_symbolsStack.clear();
+    m_symbolsStackLevels.clear();
+    m_groupLevel = 0;
+    m_end = m_endinput = m_endinputNow = false;
+    m_afterassignmentToken.reset();
+    m_lockToken.reset();
+    m_currentGroupType = GROUP_DOCUMENT;
+    m_customGroupBegin = m_customGroupEnd = false;
+
+    m_tracingCommands = symbol("tracingcommands", int(0));
+    m_tracingMacros = symbol("tracingmacros", int(0));
+    m_tracingRestores = symbol("tracingrestores", int(0));
+
+    m_resumeDocument = Node::ptr(new Node("group"));
+    Node::ChildrenList& children = m_document->children();
+    m_resumeDocument->children().assign(children.begin(),
+                                    children.begin() + c.children);
+    m_document.reset();
+}
+
 } // namespace texpp
 
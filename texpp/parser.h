@@ -21,6 +21,7 @@
 
 #include <texpp/common.h>
 #include <texpp/lexer.h>
+#include <texpp/logger.h>
 #include <texpp/command.h>
 #include <texpp/command.h>
 
@@ -40,6 +41,10 @@ using boost::unsafe_any_cast;
 class Lexer;
 class Logger;
 class Parser;
+class Profiler;
+class Prefetcher;
+class OutputSink;
+class Vfs;
 
 namespace base {
     class ExpandafterMacro;
@@ -118,16 +123,23 @@ public:
                      GROUP_NORMAL, GROUP_SUPER,
                      GROUP_MATH, GROUP_DMATH,
                      GROUP_CUSTOM };
+    // Commands defined at construction: plain TeX primitives, or the
+    // same with the stubs of latex::initSymbols on top
+    enum Style { STYLE_PLAIN, STYLE_LATEX };
 
     Parser(const string& fileName, std::istream* file,
             const string& workdir = string(),
             bool interactive = false, bool ignoreEmergency = false,
-            shared_ptr<Logger> logger = shared_ptr<Logger>());
+            shared_ptr<Logger> logger = shared_ptr<Logger>(),
+            Style style = STYLE_PLAIN);
 
     Parser(const string& fileName, shared_ptr<std::istream> file,
             const string& workdir = string(),
             bool interactive = false, bool ignoreEmergency = false,
-            shared_ptr<Logger> logger = shared_ptr<Logger>());
+            shared_ptr<Logger> logger = shared_ptr<Logger>(),
+            Style style = STYLE_PLAIN);
+
+    Style style() const { return m_style; }
 
     Interaction interaction() const { return m_interaction; }
     void setInteraction(Interaction intr) { m_interaction = intr; }
@@ -143,6 +155,25 @@ public:
     ///////// Parse 
     Node::ptr parse();
 
+    //////// Incremental parsing
+    // When the interval is non-zero parse() records checkpoints of the
+    // parser state between top level nodes of the document, at most one
+    // per interval bytes of input. reparse() then parses file, an edited
+    // version of the document whose first changed byte is at editBegin,
+    // starting from the last checkpoint before the edit. Nodes parsed
+    // before that checkpoint are shared with the previous document,
+    // which must not be used afterwards. Returns an empty pointer if
+    // parse() recorded no checkpoints.
+    //
+    // Files opened by \openin and \openout are not rewound.
+    void setCheckpointInterval(size_t bytes) { m_checkpointInterval = bytes; }
+    size_t checkpointInterval() const { return m_checkpointInterval; }
+
+    size_t checkpointsCount() const { return m_checkpoints.size(); }
+    size_t checkpointPos(size_t n) const { return m_checkpoints[n].inputPos; }
+
+    Node::ptr reparse(shared_ptr<std::istream> file, size_t editBegin);
+
     const string& modeName() const;
     Mode mode() const { return m_mode; }
     void setMode(Mode mode) { m_mode = mode; }
@@ -164,6 +195,18 @@ public:
     void resetNoexpand() { m_noexpandTokens.clear(); pushBack(NULL); }
 
     void input(const string& fileName, const string& fullName);
+
+    //////// Files
+    // All files read by the parser are found and opened through the
+    // virtual file system, a FileSystemVfs unless set otherwise
+    void setVfs(shared_ptr<Vfs> vfs) { m_vfs = vfs; }
+    shared_ptr<Vfs> vfs() { return m_vfs; }
+
+    // Path of the file read by \input fname, or an empty string
+    string resolveFile(const string& fname);
+    // Opens a resolved input file, from the prefetcher if it has it.
+    // Returns an empty pointer if the file can not be read.
+    shared_ptr<std::istream> openFile(const string& fullName);
     void end() { m_end = true; }
     void endinput() { m_endinput = true; }
 
@@ -269,6 +312,41 @@ public:
         return e >= 0 && e <= 255 ? string(1, e) : string();
     }
 
+    //////// Logging
+    // Cheap checks to call before formatting a message. Logger::enabled()
+    // answers are cached (call updateLogLevels() if they change), tracing
+    // parameters are refreshed whenever their symbols are set or restored
+    bool logEnabled(Logger::Level level) const {
+        int bit = int(level) / 5;
+        if(bit < 0) bit = 0; else if(bit > 31) bit = 31;
+        return m_logLevels & (1u << bit);
+    }
+    void updateLogLevels();
+
+    int tracingCommands() const { return m_tracingCommands; }
+    int tracingMacros() const { return m_tracingMacros; }
+    int tracingRestores() const { return m_tracingRestores; }
+
+    //////// Profiling
+    // Pass an empty pointer to stop profiling
+    void setProfiler(shared_ptr<Profiler> profiler) { m_profiler = profiler; }
+    shared_ptr<Profiler> profiler() { return m_profiler; }
+
+    //////// Prefetching
+    // Files read by \input and \openin are taken from the prefetcher
+    // when it has loaded them, see Prefetcher. The prefetcher reads the
+    // real file system, it is not useful with other file systems.
+    void setPrefetcher(shared_ptr<Prefetcher> prefetcher) {
+        m_prefetcher = prefetcher;
+    }
+    shared_ptr<Prefetcher> prefetcher() { return m_prefetcher; }
+
+    //////// Output files
+    // Files opened by \openout are created by the output sink, which
+    // is a FileOutputSink unless set otherwise
+    void setOutputSink(shared_ptr<OutputSink> sink) { m_outputSink = sink; }
+    shared_ptr<OutputSink> outputSink() { return m_outputSink; }
+
     //////// Others
     shared_ptr<Logger> logger() { return m_logger; }
     shared_ptr<Lexer> lexer() { return m_lexer; }
@@ -284,6 +362,10 @@ protected:
     void setSpecialSymbol(const string& name, const any& value);
     void init();
 
+    void recordCheckpoint(Node::ptr document);
+    void restoreCheckpoint(size_t n, shared_ptr<std::istream> file);
+    Node::ptr finishDocument(Node::ptr document);
+
     typedef std::deque<
         Token::ptr
     > TokenQueue;
@@ -306,6 +388,16 @@ protected:
     shared_ptr<Lexer>   m_lexer;
     shared_ptr<Logger>  m_logger;
 
+    unsigned int    m_logLevels;
+    int             m_tracingCommands;
+    int             m_tracingMacros;
+    int             m_tracingRestores;
+
+    shared_ptr<Profiler> m_profiler;
+    shared_ptr<Prefetcher> m_prefetcher;
+    shared_ptr<OutputSink> m_outputSink;
+    shared_ptr<Vfs> m_vfs;
+
     Token::ptr      m_token;
     Token::list     m_tokenSource;
 
@@ -317,6 +409,7 @@ protected:
     bool            m_end;
     bool            m_endinput;
     bool            m_endinputNow;
+    bool            m_parsingFileName;
 
     struct ConditionalInfo {
         bool parsed;
@@ -340,6 +433,34 @@ protected:
     SymbolStack     m_symbolsStack;
     vector<size_t>  m_symbolsStackLevels;
 
+    // State at a top level boundary of the document. Symbols hold the
+    // values changed since the previous checkpoint (all of them in the
+    // first checkpoint), the lexer is a Lexer::checkpoint() copy.
+    struct Checkpoint {
+        size_t              inputPos;
+        size_t              children;
+        shared_ptr<Lexer>   lexer;
+        SymbolStack         symbols;
+        Token::ptr          token;
+        Token::list         tokenSource;
+        Token::ptr          lastToken;
+        vector<Token::list> aftergroupTokensStack;
+        size_t              lineNo;
+        Mode                mode;
+        Mode                prevMode;
+        bool                hasOutput;
+        Interaction         interaction;
+    };
+
+    size_t              m_checkpointInterval;
+    vector<Checkpoint>  m_checkpoints;
+    std::set<string>    m_changedSymbols;
+
+    Node::ptr           m_document;
+    Node::ptr           m_resumeDocument;
+    Node::ptr           m_trailingNode;
+    size_t              m_trailingTokens;
+
     size_t          m_lineNo;
     Mode            m_mode;
     Mode            m_prevMode;
@@ -355,6 +476,7 @@ protected:
     CommandStack m_commandStack;
 
     Interaction m_interaction;
+    Style       m_style;
     
     Token::ptr          m_lockToken;
     Token::ptr          m_afterassignmentToken;
@@ -0,0 +1,264 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include <texpp/prefetch.h>
+#include <texpp/memstream.h>
+#include <texpp/kpsewhich.h>
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+
+#include <cstring>
+#include <cctype>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace {
+
+// Characters ending a file name in inputNames()
+const char* const NAME_END = " \t\r\n%{}\\#";
+
+} // namespace
+
+namespace texpp {
+
+Prefetcher::Prefetcher(bool speculative, size_t maxBytes)
+    : m_speculative(speculative), m_maxBytes(maxBytes),
+      m_loadedBytes(0), m_hits(0), m_misses(0),
+      m_busy(false), m_stop(false)
+{
+    m_thread = boost::thread(boost::bind(&Prefetcher::run, this));
+}
+
+Prefetcher::~Prefetcher()
+{
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_stop = true;
+    }
+    m_wakeup.notify_all();
+    m_thread.join();
+}
+
+void Prefetcher::prefetch(const string& fullName, const string& workdir)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    enqueue(fullName, workdir, false);
+}
+
+void Prefetcher::prefetchName(const string& fname, const string& workdir)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    enqueue(fname, workdir, true);
+}
+
+void Prefetcher::enqueue(const string& name,
+                            const string& workdir, bool resolve)
+{
+    if(name.empty()) return;
+
+    if(resolve) {
+        if(!m_seenNames.insert(workdir + '\n' + name).second) return;
+    } else {
+        if(!m_seen.insert(name).second) return;
+        Entry& entry = m_entries[name];
+        entry.state = QUEUED;
+        entry.workdir = workdir;
+    }
+
+    Request request = { name, workdir, resolve };
+    m_queue.push_back(request);
+    m_wakeup.notify_one();
+}
+
+shared_ptr<std::istream> Prefetcher::open(const string& fullName)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    Entries::iterator it = m_entries.find(fullName);
+    while(it != m_entries.end() && it->second.state == LOADING) {
+        m_done.wait(lock);
+        it = m_entries.find(fullName);
+    }
+
+    if(it == m_entries.end() || it->second.state != READY) {
+        // Queued entries are dropped, the caller is about to read
+        // the file anyway and the worker skips requests without one
+        if(it != m_entries.end()) m_entries.erase(it);
+        ++m_misses;
+        return shared_ptr<std::istream>();
+    }
+
+    shared_ptr<string> data = it->second.data;
+    m_loadedBytes -= data->size();
+    m_entries.erase(it);
+    ++m_hits;
+
+    return shared_ptr<std::istream>(
+                new MemoryStream(data->data(), data->size(), data));
+}
+
+void Prefetcher::wait()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    while(m_busy || !m_queue.empty())
+        m_done.wait(lock);
+}
+
+size_t Prefetcher::loadedBytes() const
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_loadedBytes;
+}
+
+void Prefetcher::run()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    while(true) {
+        while(!m_stop && m_queue.empty())
+            m_wakeup.wait(lock);
+        if(m_stop) break;
+
+        Request request = m_queue.front();
+        m_queue.pop_front();
+        m_busy = true;
+
+        lock.unlock();
+        handle(request);
+        lock.lock();
+
+        m_busy = false;
+        m_done.notify_all();
+    }
+}
+
+void Prefetcher::handle(const Request& request)
+{
+    string fullName = request.name;
+    if(request.resolve) {
+        fullName = kpsewhich(request.name, request.workdir);
+        if(fullName.empty()) return;
+    }
+
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        if(request.resolve) {
+            if(!m_seen.insert(fullName).second) return;
+            m_entries[fullName].workdir = request.workdir;
+        } else {
+            Entries::iterator it = m_entries.find(fullName);
+            if(it == m_entries.end() || it->second.state != QUEUED)
+                return;
+        }
+        m_entries[fullName].state = LOADING;
+    }
+
+    shared_ptr<string> data(new string);
+    bool loaded = load(fullName, *data);
+
+    vector<string> names;
+    if(loaded && m_speculative)
+        names = inputNames(data->data(), data->size());
+
+    boost::mutex::scoped_lock lock(m_mutex);
+    Entry& entry = m_entries[fullName];
+    if(loaded) {
+        entry.state = READY;
+        entry.data = data;
+        m_loadedBytes += data->size();
+    } else {
+        entry.state = FAILED;
+    }
+    m_done.notify_all();
+
+    BOOST_FOREACH(const string& name, names)
+        enqueue(name, entry.workdir, true);
+}
+
+bool Prefetcher::load(const string& fullName, string& data)
+{
+    int fd = ::open(fullName.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+    if(ok) {
+        boost::mutex::scoped_lock lock(m_mutex);
+        ok = m_loadedBytes + size_t(st.st_size) <= m_maxBytes;
+    }
+
+    if(ok) {
+        data.resize(st.st_size);
+        size_t done = 0;
+        while(done < data.size()) {
+            ssize_t n = ::read(fd, &data[done], data.size() - done);
+            if(n < 0 && errno == EINTR) continue;
+            if(n <= 0) break;
+            done += n;
+        }
+        // The file may have changed since fstat
+        data.resize(done);
+    }
+
+    ::close(fd);
+    return ok;
+}
+
+vector<string> Prefetcher::inputNames(const char* data, size_t size)
+{
+    vector<string> names;
+    for(size_t i = 0; i < size; ++i) {
+        if(data[i] == '%') {
+            while(i < size && data[i] != '\n') ++i;
+            continue;
+        }
+        if(data[i] != '\\') continue;
+
+        size_t j = i + 1;
+        while(j < size && std::isalpha((unsigned char) data[j])) ++j;
+        if(j == i + 1) {
+            // Control symbol, skip the escaped character
+            i = j;
+            continue;
+        }
+
+        size_t len = j - i - 1;
+        i = j - 1;
+        if(!(len == 5 && std::strncmp(data + i - 4, "input", 5) == 0) &&
+           !(len == 7 && std::strncmp(data + i - 6, "include", 7) == 0))
+            continue;
+
+        while(j < size && (data[j] == ' ' || data[j] == '\t')) ++j;
+        bool braced = j < size && data[j] == '{';
+        if(braced) ++j;
+
+        size_t k = j;
+        while(k < size && !std::strchr(NAME_END, data[k])) ++k;
+        if(braced && (k >= size || data[k] != '}')) continue;
+
+        if(k > j) names.push_back(string(data + j, k - j));
+        i = k - 1;
+    }
+    return names;
+}
+
+} // namespace texpp
+
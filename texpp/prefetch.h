@@ -0,0 +1,137 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#ifndef __TEXPP_PREFETCH_H
+#define __TEXPP_PREFETCH_H
+
+#include <texpp/common.h>
+
+#include <deque>
+#include <set>
+#include <istream>
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+namespace texpp {
+
+// Reads files in a background thread so that \input and \openin find
+// their contents already in memory. Files are requested by their
+// resolved name with prefetch(), or by the name written in the
+// document with prefetchName() which also runs kpsewhich in the
+// background. open() hands the contents out once and forgets them.
+//
+// In speculative mode every loaded file is scanned for \input and
+// \include commands and the files they name are prefetched in turn,
+// so that they are loaded while the parser is still busy with the
+// text in front of them. Prefetching the main document this way
+// starts the whole chain.
+//
+// Memory held by files which were loaded but not opened yet is
+// limited by maxBytes, files which do not fit are left on disk.
+class Prefetcher: boost::noncopyable
+{
+public:
+    typedef shared_ptr<Prefetcher> ptr;
+
+    enum { DEFAULT_MAX_BYTES = 64 << 20 };
+
+    explicit Prefetcher(bool speculative = false,
+                        size_t maxBytes = DEFAULT_MAX_BYTES);
+    ~Prefetcher();
+
+    // Queues loading of the file fullName. Names of speculatively
+    // prefetched files found in it are resolved relative to workdir.
+    void prefetch(const string& fullName, const string& workdir = string());
+    // Queues resolving fname with kpsewhich and loading the result
+    void prefetchName(const string& fname, const string& workdir = string());
+
+    // Returns a stream over the contents of fullName, waiting for them
+    // if the file is being loaded right now. Returns an empty pointer
+    // if the file was not prefetched, is still waiting in the queue,
+    // could not be loaded or was already opened.
+    shared_ptr<std::istream> open(const string& fullName);
+
+    // Waits until every queued request has been handled
+    void wait();
+
+    bool speculative() const { return m_speculative; }
+    void setSpeculative(bool speculative) { m_speculative = speculative; }
+
+    size_t maxBytes() const { return m_maxBytes; }
+
+    // Number of open() calls served from memory and from nowhere
+    size_t hits() const { return m_hits; }
+    size_t misses() const { return m_misses; }
+    // Memory held by loaded files which were not opened yet
+    size_t loadedBytes() const;
+
+    // File names following \input and \include in text, skipping
+    // comments and names built from macros
+    static vector<string> inputNames(const char* data, size_t size);
+
+protected:
+    enum State { QUEUED, LOADING, READY, FAILED };
+
+    struct Entry
+    {
+        State state;
+        string workdir;
+        shared_ptr<string> data;
+    };
+
+    struct Request
+    {
+        string name;
+        string workdir;
+        bool resolve;
+    };
+
+    typedef unordered_map<string, Entry> Entries;
+
+    void enqueue(const string& name, const string& workdir, bool resolve);
+    void run();
+    void handle(const Request& request);
+    bool load(const string& fullName, string& data);
+
+    bool    m_speculative;
+    size_t  m_maxBytes;
+    size_t  m_loadedBytes;
+    size_t  m_hits;
+    size_t  m_misses;
+
+    Entries         m_entries;
+    std::set<string> m_seen;        // every file ever queued
+    std::set<string> m_seenNames;   // every name ever resolved
+    std::deque<Request> m_queue;
+    bool            m_busy;
+    bool            m_stop;
+
+    mutable boost::mutex m_mutex;
+    boost::condition_variable m_wakeup;
+    boost::condition_variable m_done;
+    boost::thread m_thread;
+};
+
+} // namespace texpp
+
+#endif
+
@@ -0,0 +1,227 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <texpp/profiler.h>
+#include <texpp/token.h>
+
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include <ctime>
+
+#include <boost/foreach.hpp>
+
+namespace {
+
+using texpp::Profiler;
+
+struct EntryLess
+{
+    EntryLess(Profiler::SortKey k): key(k) {}
+
+    bool operator()(const Profiler::Entry& a, const Profiler::Entry& b) const
+    {
+        switch(key) {
+            case Profiler::BY_INCLUSIVE:
+                if(a.inclusive != b.inclusive) return a.inclusive > b.inclusive;
+                break;
+            case Profiler::BY_COUNT:
+                if(a.count != b.count) return a.count > b.count;
+                break;
+            case Profiler::BY_TOKENS:
+                if(a.tokens != b.tokens) return a.tokens > b.tokens;
+                break;
+            case Profiler::BY_EXCLUSIVE:
+                if(a.exclusive != b.exclusive) return a.exclusive > b.exclusive;
+                break;
+            default:
+                break;
+        }
+        return a.name < b.name;
+    }
+
+    Profiler::SortKey key;
+};
+
+// Collapsed stack format reserves ';' and whitespace
+texpp::string collapsedName(const texpp::string& name)
+{
+    texpp::string r;
+    BOOST_FOREACH(unsigned char ch, name) {
+        if(ch == ';' || ch <= 0x20 || ch >= 0x7f) {
+            std::ostringstream s;
+            s << "^^" << std::hex << std::setw(2) << std::setfill('0')
+              << int(ch);
+            r += s.str();
+        } else {
+            r += ch;
+        }
+    }
+    return r;
+}
+
+} // namespace
+
+namespace texpp {
+
+Profiler::Time Profiler::now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return Time(ts.tv_sec) * 1000000000u + Time(ts.tv_nsec);
+}
+
+void Profiler::reset()
+{
+    m_entries.clear();
+    m_entryIds.clear();
+    m_paths.assign(1, Path());
+    m_paths[0].parent = 0;
+    m_paths[0].entry = 0;
+    m_paths[0].exclusive = 0;
+    m_pathIds.clear();
+    m_stack.clear();
+}
+
+void Profiler::enter(const string& name)
+{
+    size_t entry;
+    unordered_map<string, size_t>::iterator it = m_entryIds.find(name);
+    if(it != m_entryIds.end()) {
+        entry = it->second;
+    } else {
+        entry = m_entries.size();
+        m_entries.push_back(Entry(name));
+        m_entryIds.insert(std::make_pair(name, entry));
+    }
+
+    size_t parent = m_stack.empty() ? 0 : m_stack.back().path;
+    size_t path;
+    std::map<pair<size_t, size_t>, size_t>::iterator pit =
+                        m_pathIds.find(std::make_pair(parent, entry));
+    if(pit != m_pathIds.end()) {
+        path = pit->second;
+    } else {
+        path = m_paths.size();
+        Path p = { parent, entry, 0 };
+        m_paths.push_back(p);
+        m_pathIds.insert(std::make_pair(std::make_pair(parent, entry), path));
+    }
+
+    Entry& e = m_entries[entry];
+    ++e.count;
+    if(++e.depth > e.maxDepth) e.maxDepth = e.depth;
+
+    Frame frame = { entry, path, 0, 0 };
+    m_stack.push_back(frame);
+    // Start the clock last to leave the bookkeeping out
+    m_stack.back().start = now();
+}
+
+void Profiler::leave()
+{
+    if(m_stack.empty()) return;
+
+    Time time = now() - m_stack.back().start;
+    Frame frame = m_stack.back();
+    m_stack.pop_back();
+
+    Time exclusive = time > frame.children ? time - frame.children : 0;
+
+    Entry& e = m_entries[frame.entry];
+    --e.depth;
+    // Recursive frames are already covered by the outermost one
+    if(e.depth == 0) e.inclusive += time;
+    e.exclusive += exclusive;
+    m_paths[frame.path].exclusive += exclusive;
+
+    if(!m_stack.empty())
+        m_stack.back().children += time;
+}
+
+void Profiler::addTokens(size_t count)
+{
+    if(!m_stack.empty())
+        m_entries[m_stack.back().entry].tokens += count;
+}
+
+vector<Profiler::Entry> Profiler::entries(SortKey key) const
+{
+    vector<Entry> result(m_entries);
+    std::sort(result.begin(), result.end(), EntryLess(key));
+    return result;
+}
+
+string Profiler::report(SortKey key, size_t limit) const
+{
+    vector<Entry> list = entries(key);
+    if(limit && list.size() > limit) list.resize(limit);
+
+    size_t width = 4;
+    BOOST_FOREACH(const Entry& e, list)
+        width = std::max(width, e.name.size());
+
+    std::ostringstream r;
+    r << std::left << std::setw(width) << "name" << std::right
+      << std::setw(10) << "count"
+      << std::setw(12) << "incl ms"
+      << std::setw(12) << "excl ms"
+      << std::setw(10) << "tokens"
+      << std::setw(7) << "depth" << '\n';
+
+    r << std::fixed << std::setprecision(3);
+    BOOST_FOREACH(const Entry& e, list) {
+        r << std::left << std::setw(width) << e.name << std::right
+          << std::setw(10) << e.count
+          << std::setw(12) << e.inclusive / 1e6
+          << std::setw(12) << e.exclusive / 1e6
+          << std::setw(10) << e.tokens
+          << std::setw(7) << e.maxDepth << '\n';
+    }
+
+    return r.str();
+}
+
+string Profiler::collapsedStacks() const
+{
+    std::ostringstream r;
+    vector<size_t> stack;
+    for(size_t n = 1; n < m_paths.size(); ++n) {
+        Time us = m_paths[n].exclusive / 1000;
+        if(!us) continue;
+
+        stack.clear();
+        for(size_t p = n; p != 0; p = m_paths[p].parent)
+            stack.push_back(m_paths[p].entry);
+
+        for(size_t i = stack.size(); i > 0; --i) {
+            r << collapsedName(m_entries[stack[i-1]].name);
+            r << (i > 1 ? ';' : ' ');
+        }
+        r << us << '\n';
+    }
+    return r.str();
+}
+
+void Profiler::enter(const Token::ptr& token)
+{
+    enter(token ? token->value() : string());
+}
+
+} // namespace texpp
+
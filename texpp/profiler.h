@@ -0,0 +1,131 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __TEXPP_PROFILER_H
+#define __TEXPP_PROFILER_H
+
+#include <texpp/common.h>
+
+#include <map>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace texpp {
+
+class Token;
+
+// Collects per control sequence statistics about macro expansions and
+// command invocations. Parser calls enter()/leave() around every frame
+// when a profiler is installed with Parser::setProfiler().
+//
+// Times are in nanoseconds. Inclusive time of a frame covers everything
+// that happens until leave(), including nested frames; exclusive time
+// excludes nested frames. Recursion depth counts how many frames with
+// the same name were active at once.
+class Profiler
+{
+public:
+    typedef shared_ptr<Profiler> ptr;
+    typedef boost::uint64_t Time;
+
+    struct Entry
+    {
+        Entry(const string& n = string())
+            : name(n), count(0), inclusive(0), exclusive(0),
+              tokens(0), maxDepth(0), depth(0) {}
+
+        string  name;
+        size_t  count;
+        Time    inclusive;
+        Time    exclusive;
+        size_t  tokens;
+        size_t  maxDepth;
+        size_t  depth;      // currently active frames
+    };
+
+    enum SortKey {
+        BY_EXCLUSIVE, BY_INCLUSIVE, BY_COUNT, BY_TOKENS, BY_NAME
+    };
+
+    Profiler() { reset(); }
+
+    void enter(const string& name);
+    void enter(const shared_ptr<Token>& token);
+    void leave();
+    // Adds tokens produced by the innermost active frame
+    void addTokens(size_t count);
+
+    void reset();
+
+    vector<Entry> entries(SortKey key = BY_EXCLUSIVE) const;
+
+    // Human readable table, at most limit rows (all if 0)
+    string report(SortKey key = BY_EXCLUSIVE, size_t limit = 0) const;
+
+    // One line per distinct call stack, "outer;inner;... <microseconds>"
+    // of exclusive time, as consumed by flamegraph.pl and similar tools
+    string collapsedStacks() const;
+
+    static Time now();
+
+protected:
+    struct Frame
+    {
+        size_t  entry;
+        size_t  path;
+        Time    start;
+        Time    children;
+    };
+
+    struct Path
+    {
+        size_t  parent;
+        size_t  entry;
+        Time    exclusive;
+    };
+
+    vector<Entry>   m_entries;
+    unordered_map<string, size_t> m_entryIds;
+
+    vector<Path>    m_paths;        // m_paths[0] is the root
+    std::map<pair<size_t, size_t>, size_t> m_pathIds;
+
+    vector<Frame>   m_stack;
+};
+
+// Profiles its own lifetime as a frame named after the token.
+// Costs a single test when profiler is NULL.
+class ProfileScope: boost::noncopyable
+{
+public:
+    ProfileScope(Profiler* profiler, const shared_ptr<Token>& token)
+        : m_profiler(profiler) { if(m_profiler) m_profiler->enter(token); }
+    ~ProfileScope() { if(m_profiler) m_profiler->leave(); }
+
+    void addTokens(size_t count) {
+        if(m_profiler) m_profiler->addTokens(count);
+    }
+
+protected:
+    Profiler* m_profiler;
+};
+
+} // namespace texpp
+
+#endif
+
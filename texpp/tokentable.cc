@@ -0,0 +1,72 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <texpp/tokentable.h>
+#include <texpp/token.h>
+#include <texpp/lexer.h>
+
+namespace texpp {
+
+void TokenTable::clear()
+{
+    m_types.clear();
+    m_catCodes.clear();
+    m_values.clear();
+    m_lineNos.clear();
+    m_starts.clear();
+    m_ends.clear();
+
+    m_valueNames.clear();
+    m_valueIds.clear();
+}
+
+void TokenTable::append(const Token& token)
+{
+    Index value;
+    unordered_map<string, Index>::iterator it =
+                                m_valueIds.find(token.value());
+    if(it != m_valueIds.end()) {
+        value = it->second;
+    } else {
+        value = Index(m_valueNames.size());
+        m_valueNames.push_back(token.value());
+        m_valueIds.insert(std::make_pair(token.value(), value));
+    }
+
+    m_types.push_back(token.type());
+    m_catCodes.push_back(token.catCode());
+    m_values.push_back(value);
+    m_lineNos.push_back(Index(token.lineNo()));
+    m_starts.push_back(Offset(token.linePos() + token.charPos()));
+    m_ends.push_back(Offset(token.linePos() + token.charEnd()));
+}
+
+size_t TokenTable::lex(Lexer& lexer, size_t limit)
+{
+    size_t count = 0;
+    while(limit == 0 || count < limit) {
+        Token::ptr token = lexer.nextToken();
+        if(!token) break;
+        append(*token);
+        ++count;
+    }
+    return count;
+}
+
+} // namespace texpp
+
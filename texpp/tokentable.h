@@ -0,0 +1,81 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __TEXPP_TOKENTABLE_H
+#define __TEXPP_TOKENTABLE_H
+
+#include <texpp/common.h>
+
+#include <boost/cstdint.hpp>
+
+namespace texpp {
+
+class Token;
+class Lexer;
+
+// Flat, columnar representation of a token stream, the counterpart of
+// NodeTable for Lexer output. All columns have one entry per token.
+// Every distinct token value is stored once: the value of token i is
+// valueNames()[values()[i]]. Offsets are byte positions of the token
+// source in the input, lineNos are one-based as in Token::lineNo().
+class TokenTable
+{
+public:
+    typedef shared_ptr<TokenTable> ptr;
+    typedef boost::int32_t Index;
+    typedef boost::int64_t Offset;
+
+    TokenTable() {}
+
+    // Reads up to limit tokens from lexer (all remaining ones if limit
+    // is 0) and appends them. Returns the number of tokens appended,
+    // which is less than limit only at the end of the input.
+    size_t lex(Lexer& lexer, size_t limit = 0);
+
+    void append(const Token& token);
+    void clear();
+
+    size_t size() const { return m_types.size(); }
+
+    // Per-token columns
+    const vector<Index>& types() const { return m_types; }
+    const vector<Index>& catCodes() const { return m_catCodes; }
+    const vector<Index>& values() const { return m_values; }
+    const vector<Index>& lineNos() const { return m_lineNos; }
+    const vector<Offset>& starts() const { return m_starts; }
+    const vector<Offset>& ends() const { return m_ends; }
+
+    // Lookup table for value ids
+    const vector<string>& valueNames() const { return m_valueNames; }
+
+protected:
+    vector<Index>   m_types;
+    vector<Index>   m_catCodes;
+    vector<Index>   m_values;
+    vector<Index>   m_lineNos;
+    vector<Offset>  m_starts;
+    vector<Offset>  m_ends;
+
+    vector<string>  m_valueNames;
+    unordered_map<string, Index> m_valueIds;
+};
+
+} // namespace texpp
+
+#endif
+
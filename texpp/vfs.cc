@@ -0,0 +1,367 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include <texpp/vfs.h>
+#include <texpp/memstream.h>
+#include <texpp/kpsewhich.h>
+
+#include <boost/foreach.hpp>
+#include <boost/cstdint.hpp>
+
+#include <fstream>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <zlib.h>
+
+namespace {
+
+using texpp::string;
+using texpp::vector;
+using texpp::shared_ptr;
+
+const size_t TAR_BLOCK = 512;
+
+bool isAbsolute(const string& path)
+{
+#ifndef WINDOWS
+    return !path.empty() && path[0] == PATH_SEP;
+#else
+    return path.size() >= 3 && path[1] == ':' && path[2] == PATH_SEP;
+#endif
+}
+
+string joinPath(const string& dir, const string& name)
+{
+    if(dir.empty() || isAbsolute(name)) return name;
+    if(dir[dir.size()-1] == PATH_SEP) return dir + name;
+    return dir + PATH_SEP + name;
+}
+
+// Paths tried for \input fname, in order
+vector<string> candidates(const string& fname, const string& workdir)
+{
+    vector<string> result;
+    if(fname.empty()) return result;
+
+    string extended = texpp::kpseextend(fname);
+    result.push_back(texpp::Vfs::normalizePath(joinPath(workdir, extended)));
+    if(extended != fname)
+        result.push_back(texpp::Vfs::normalizePath(joinPath(workdir, fname)));
+    return result;
+}
+
+struct Unmap
+{
+    explicit Unmap(size_t size): m_size(size) {}
+    void operator()(const void* p) const {
+        ::munmap(const_cast<void*>(p), m_size);
+    }
+    size_t m_size;
+};
+
+// Inflates gzip data, returns false if data is not a valid gzip stream
+bool gunzip(const char* data, size_t size, string& result)
+{
+    z_stream zs;
+    std::memset(&zs, 0, sizeof(zs));
+    // 16 selects the gzip wrapper
+    if(inflateInit2(&zs, 16 + MAX_WBITS) != Z_OK)
+        return false;
+
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    zs.avail_in = uInt(size);
+
+    char buf[1 << 16];
+    int ret;
+    do {
+        zs.next_out = reinterpret_cast<Bytef*>(buf);
+        zs.avail_out = sizeof(buf);
+        ret = inflate(&zs, Z_NO_FLUSH);
+        if(ret != Z_OK && ret != Z_STREAM_END) break;
+        result.append(buf, sizeof(buf) - zs.avail_out);
+    } while(ret != Z_STREAM_END);
+
+    inflateEnd(&zs);
+    return ret == Z_STREAM_END;
+}
+
+// String stored in a fixed size, possibly unterminated, tar field
+string tarString(const char* field, size_t size)
+{
+    const char* end = static_cast<const char*>(std::memchr(field, 0, size));
+    return string(field, end ? end - field : size);
+}
+
+// Octal tar number, or a base-256 one for large values
+boost::uint64_t tarNumber(const char* field, size_t size)
+{
+    boost::uint64_t value = 0;
+    if(field[0] & 0x80) {
+        for(size_t n = 1; n < size; ++n)
+            value = (value << 8) | (unsigned char) field[n];
+        return value;
+    }
+    for(size_t n = 0; n < size; ++n) {
+        if(field[n] == ' ' && value == 0) continue;
+        if(field[n] < '0' || field[n] > '7') break;
+        value = value * 8 + (field[n] - '0');
+    }
+    return value;
+}
+
+bool tarChecksumOk(const char* header)
+{
+    boost::uint64_t sum = 0;
+    for(size_t n = 0; n < TAR_BLOCK; ++n)
+        sum += (n >= 148 && n < 156) ? ' ' : (unsigned char) header[n];
+    return sum == tarNumber(header + 148, 8);
+}
+
+// Value of the path record of a pax extended header
+string paxPath(const char* data, size_t size)
+{
+    size_t pos = 0;
+    while(pos < size) {
+        // Records are "<length> <key>=<value>\n"
+        size_t len = 0, n = pos;
+        while(n < size && data[n] >= '0' && data[n] <= '9')
+            len = len * 10 + (data[n++] - '0');
+        if(len == 0 || pos + len > size) break;
+
+        string record(data + n, data + pos + len);
+        if(record.compare(0, 6, " path=") == 0)
+            return record.substr(6, record.size() - 7);
+        pos += len;
+    }
+    return string();
+}
+
+} // namespace
+
+namespace texpp {
+
+string Vfs::resolve(const string& fname, const string& workdir)
+{
+    BOOST_FOREACH(const string& path, candidates(fname, workdir)) {
+        if(exists(path)) return path;
+    }
+    return string();
+}
+
+string Vfs::normalizePath(const string& path)
+{
+    bool absolute = !path.empty() && path[0] == PATH_SEP;
+
+    vector<string> parts;
+    size_t pos = 0;
+    while(pos <= path.size()) {
+        size_t end = path.find(PATH_SEP, pos);
+        if(end == string::npos) end = path.size();
+        string part = path.substr(pos, end - pos);
+        pos = end + 1;
+
+        if(part.empty() || part == ".") continue;
+        if(part == "..") {
+            if(!parts.empty() && parts.back() != "..") {
+                parts.pop_back();
+                continue;
+            }
+            if(absolute) continue;
+        }
+        parts.push_back(part);
+    }
+
+    string result = absolute ? string(1, PATH_SEP) : string();
+    for(size_t n = 0; n < parts.size(); ++n) {
+        if(n) result += PATH_SEP;
+        result += parts[n];
+    }
+    return result;
+}
+
+shared_ptr<std::istream> FileSystemVfs::open(const string& path)
+{
+    shared_ptr<std::istream> stream(new std::ifstream(path.c_str()));
+    if(stream->fail())
+        return shared_ptr<std::istream>();
+    return stream;
+}
+
+bool FileSystemVfs::exists(const string& path)
+{
+    struct stat st;
+    return ::stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+string FileSystemVfs::resolve(const string& fname, const string& workdir)
+{
+    return kpsewhich(fname, workdir);
+}
+
+void MemoryVfs::add(const string& path, const string& data)
+{
+    shared_ptr<string> copy(new string(data));
+    add(path, copy->data(), copy->size(), copy);
+}
+
+void MemoryVfs::add(const string& path, const char* data, size_t size,
+                        shared_ptr<const void> owner)
+{
+    File file = { data, size, owner };
+    m_files[normalizePath(path)] = file;
+}
+
+bool MemoryVfs::remove(const string& path)
+{
+    return m_files.erase(normalizePath(path));
+}
+
+vector<string> MemoryVfs::fileNames() const
+{
+    vector<string> names;
+    BOOST_FOREACH(const Files::value_type& file, m_files)
+        names.push_back(file.first);
+    return names;
+}
+
+shared_ptr<std::istream> MemoryVfs::open(const string& path)
+{
+    Files::const_iterator it = m_files.find(normalizePath(path));
+    if(it != m_files.end())
+        return shared_ptr<std::istream>(new MemoryStream(
+                    it->second.data, it->second.size, it->second.owner));
+    if(m_fallback)
+        return m_fallback->open(path);
+    return shared_ptr<std::istream>();
+}
+
+bool MemoryVfs::exists(const string& path)
+{
+    return m_files.count(normalizePath(path)) ||
+                (m_fallback && m_fallback->exists(path));
+}
+
+string MemoryVfs::resolve(const string& fname, const string& workdir)
+{
+    BOOST_FOREACH(const string& path, candidates(fname, workdir)) {
+        if(m_files.count(path)) return path;
+    }
+    if(m_fallback)
+        return m_fallback->resolve(fname, workdir);
+    return string();
+}
+
+bool ArchiveVfs::load(const string& fileName, const string& root,
+                        const string& singleFileName)
+{
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+
+    struct stat st;
+    if(::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* data = ::mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(data == MAP_FAILED) return false;
+
+    shared_ptr<const void> owner(data, Unmap(st.st_size));
+    return load(static_cast<const char*>(data), st.st_size,
+                    owner, root, singleFileName);
+}
+
+bool ArchiveVfs::load(const char* data, size_t size,
+                        shared_ptr<const void> owner,
+                        const string& root, const string& singleFileName)
+{
+    if(size >= 2 && (unsigned char) data[0] == 0x1f &&
+                    (unsigned char) data[1] == 0x8b) {
+        shared_ptr<string> inflated(new string);
+        if(!gunzip(data, size, *inflated))
+            return false;
+
+        if(loadTar(inflated->data(), inflated->size(), inflated, root))
+            return true;
+
+        add(joinPath(root, singleFileName),
+                inflated->data(), inflated->size(), inflated);
+        return true;
+    }
+
+    return loadTar(data, size, owner, root);
+}
+
+bool ArchiveVfs::loadTar(const char* data, size_t size,
+                            shared_ptr<const void> owner, const string& root)
+{
+    static const char ZERO[TAR_BLOCK] = { 0 };
+
+    bool valid = false;
+    string longName;
+
+    size_t pos = 0;
+    while(pos + TAR_BLOCK <= size) {
+        const char* header = data + pos;
+        if(std::memcmp(header, ZERO, TAR_BLOCK) == 0) break;
+        if(!tarChecksumOk(header)) break;
+        valid = true;
+
+        boost::uint64_t fileSize = tarNumber(header + 124, 12);
+        size_t dataPos = pos + TAR_BLOCK;
+        if(fileSize > size - dataPos) break;
+
+        string name;
+        if(!longName.empty()) {
+            name.swap(longName);
+        } else {
+            name = tarString(header, 100);
+            string prefix;
+            if(std::memcmp(header + 257, "ustar", 5) == 0)
+                prefix = tarString(header + 345, 155);
+            if(!prefix.empty())
+                name = prefix + PATH_SEP + name;
+        }
+
+        char type = header[156];
+        if(type == 'L') {
+            // GNU long name of the next member
+            longName = tarString(data + dataPos, fileSize);
+        } else if(type == 'x') {
+            // pax extended header of the next member
+            longName = paxPath(data + dataPos, fileSize);
+        } else if(type == '0' || type == '\0' || type == '7') {
+            string path = normalizePath(name);
+            if(!path.empty() && !isAbsolute(path) && path != ".." &&
+                    path.compare(0, 3, string("..") + PATH_SEP) != 0)
+                add(joinPath(root, path), data + dataPos, fileSize, owner);
+        }
+
+        pos = dataPos + (fileSize + TAR_BLOCK - 1) / TAR_BLOCK * TAR_BLOCK;
+    }
+
+    return valid;
+}
+
+} // namespace texpp
+
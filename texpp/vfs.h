@@ -0,0 +1,142 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#ifndef __TEXPP_VFS_H
+#define __TEXPP_VFS_H
+
+#include <texpp/common.h>
+
+#include <istream>
+#include <map>
+
+namespace texpp {
+
+// File system seen by the parser. \input and \openin resolve the file
+// names written in the document with resolve() and read the result
+// with open(); Parser uses a FileSystemVfs unless told otherwise.
+// Files written by \openout go to the parser's OutputSink.
+class Vfs
+{
+public:
+    typedef shared_ptr<Vfs> ptr;
+
+    virtual ~Vfs() {}
+
+    // Returns a stream over the file at path, or an empty pointer if
+    // there is no such file
+    virtual shared_ptr<std::istream> open(const string& path) = 0;
+    virtual bool exists(const string& path) = 0;
+
+    // Returns the path of the file that \input fname reads when the
+    // document lives in workdir, or an empty string if there is none.
+    // The default implementation looks for fname with the .tex suffix
+    // added as kpseextend() does, then for fname itself, both relative
+    // to workdir.
+    virtual string resolve(const string& fname, const string& workdir);
+
+    // Collapses repeated separators, `.' and `dir/..' components
+    static string normalizePath(const string& path);
+};
+
+// The real file system, files are found by kpsewhich()
+class FileSystemVfs: public Vfs
+{
+public:
+    shared_ptr<std::istream> open(const string& path);
+    bool exists(const string& path);
+    string resolve(const string& fname, const string& workdir);
+};
+
+// Files kept in memory, keyed by normalized path. Lookups which find
+// nothing are passed on to the fallback file system if there is one,
+// which allows e.g. taking the document from memory and the packages
+// it uses from the real texmf tree.
+class MemoryVfs: public Vfs
+{
+public:
+    typedef shared_ptr<MemoryVfs> ptr;
+
+    explicit MemoryVfs(Vfs::ptr fallback = Vfs::ptr())
+        : m_fallback(fallback) {}
+
+    // Adds a copy of data as the file path
+    void add(const string& path, const string& data);
+    // Adds size bytes at data as the file path without copying them,
+    // owner is kept alive as long as the memory may be used
+    void add(const string& path, const char* data, size_t size,
+                shared_ptr<const void> owner);
+    bool remove(const string& path);
+    void clear() { m_files.clear(); }
+
+    size_t size() const { return m_files.size(); }
+    vector<string> fileNames() const;
+
+    Vfs::ptr fallback() const { return m_fallback; }
+    void setFallback(Vfs::ptr fallback) { m_fallback = fallback; }
+
+    shared_ptr<std::istream> open(const string& path);
+    bool exists(const string& path);
+    string resolve(const string& fname, const string& workdir);
+
+protected:
+    struct File
+    {
+        const char* data;
+        size_t size;
+        shared_ptr<const void> owner;
+    };
+
+    typedef std::map<string, File> Files;
+
+    Files m_files;
+    Vfs::ptr m_fallback;
+};
+
+// Files of a tar archive, optionally gzip compressed, read in place:
+// uncompressed archives are mapped into memory and their members are
+// never copied, compressed ones are inflated once. Members are placed
+// under root; members with absolute paths or `..' components are
+// skipped. A gzip file which does not contain a tar archive becomes
+// the single file singleFileName, as arXiv stores one-file articles.
+class ArchiveVfs: public MemoryVfs
+{
+public:
+    typedef shared_ptr<ArchiveVfs> ptr;
+
+    explicit ArchiveVfs(Vfs::ptr fallback = Vfs::ptr())
+        : MemoryVfs(fallback) {}
+
+    // Adds the members of the archive fileName. Returns false if it
+    // can not be read or is not an archive.
+    bool load(const string& fileName, const string& root = string(),
+              const string& singleFileName = "main.tex");
+    // Same for an archive already in memory, kept alive by owner
+    bool load(const char* data, size_t size, shared_ptr<const void> owner,
+              const string& root = string(),
+              const string& singleFileName = "main.tex");
+
+protected:
+    bool loadTar(const char* data, size_t size,
+                 shared_ptr<const void> owner, const string& root);
+};
+
+} // namespace texpp
+
+#endif
+
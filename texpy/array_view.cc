@@ -0,0 +1,83 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "array_view.h"
+
+namespace texpp { namespace {
+
+int ArrayView_getbuffer(PyObject* self, Py_buffer* view, int flags)
+{
+    view->obj = NULL;
+    if(flags & PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "ArrayView is read-only");
+        return -1;
+    }
+
+    ArrayView* a = boost::python::extract<ArrayView*>(self);
+    if(!a) {
+        PyErr_SetString(PyExc_BufferError, "invalid ArrayView");
+        return -1;
+    }
+
+    view->buf = const_cast<void*>(a->data);
+    view->len = a->size * a->itemsize;
+    view->readonly = 1;
+    view->itemsize = a->itemsize;
+    view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>(a->format)
+                                          : NULL;
+    view->ndim = 1;
+    view->shape = (flags & PyBUF_ND) ? &a->size : NULL;
+    view->strides = (flags & PyBUF_STRIDES) ? &a->itemsize : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+
+    view->obj = self;
+    Py_INCREF(self);
+    return 0;
+}
+
+PyBufferProcs ArrayView_bufferProcs;
+
+Py_ssize_t ArrayView_len(const ArrayView& a) { return a.size; }
+string ArrayView_format(const ArrayView& a) { return a.format; }
+
+}} // namespace texpp // namespace
+
+void export_array_view()
+{
+    using namespace boost::python;
+    using namespace texpp;
+
+    object cls = class_<ArrayView>("ArrayView", no_init)
+        .def("__len__", &ArrayView_len)
+        .add_property("itemsize", &ArrayView::itemsize)
+        .add_property("format", &ArrayView_format)
+        ;
+
+    // boost.python has no notion of the buffer protocol,
+    // so install it directly on the generated type object
+    ArrayView_bufferProcs.bf_getbuffer = &ArrayView_getbuffer;
+    ArrayView_bufferProcs.bf_releasebuffer = NULL;
+
+    PyTypeObject* type = reinterpret_cast<PyTypeObject*>(cls.ptr());
+    type->tp_as_buffer = &ArrayView_bufferProcs;
+#ifdef Py_TPFLAGS_HAVE_NEWBUFFER
+    type->tp_flags |= Py_TPFLAGS_HAVE_NEWBUFFER;
+#endif
+}
+
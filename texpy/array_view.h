@@ -0,0 +1,73 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __TEXPY_ARRAY_VIEW_H
+#define __TEXPY_ARRAY_VIEW_H
+
+#include <boost/python.hpp>
+#include <texpp/common.h>
+
+#include <boost/cstdint.hpp>
+
+namespace texpp {
+
+template<typename T> struct ArrayViewFormat {};
+template<> struct ArrayViewFormat<char> {
+    static const char* format() { return "B"; } };
+template<> struct ArrayViewFormat<boost::int32_t> {
+    static const char* format() { return "i"; } };
+template<> struct ArrayViewFormat<boost::int64_t> {
+    static const char* format() { return "q"; } };
+
+// Read-only one-dimensional view of contiguous native memory exported
+// to python through the buffer protocol (memoryview, numpy.asarray,
+// array.array, ...). The memory is never copied, instead the view
+// keeps its owner alive as long as python references it.
+struct ArrayView
+{
+    ArrayView(): data(NULL), size(0), itemsize(1), format("B") {}
+
+    template<typename T>
+    ArrayView(shared_ptr<const void> o, const T* d, size_t n)
+        : owner(o), data(d), size(n), itemsize(sizeof(T)),
+          format(ArrayViewFormat<T>::format()) {}
+
+    template<typename T>
+    static ArrayView fromVector(shared_ptr<const void> owner,
+                                const vector<T>& v) {
+        return ArrayView(owner, v.empty() ? NULL : &v[0], v.size());
+    }
+
+    static ArrayView fromString(shared_ptr<const void> owner,
+                                const string& s) {
+        return ArrayView(owner, s.data(), s.size());
+    }
+
+    shared_ptr<const void> owner;
+    const void* data;
+    Py_ssize_t  size;
+    Py_ssize_t  itemsize;
+    const char* format;
+};
+
+} // namespace texpp
+
+void export_array_view();
+
+#endif
+
@@ -23,8 +23,15 @@
 
 #include <string>
 
+#include "gil.h"
+
 namespace {
 
+  // Python objects stored in the symbol table are copied and released
+  // by the parser while the GIL is not held, so keep them behind
+  // a shared pointer whose last release re-acquires it
+  typedef boost::shared_ptr<boost::python::object> object_ptr;
+
   struct boost_any_to_python_object
   {
     static PyObject* convert(const boost::any& s)
@@ -42,10 +49,13 @@ namespace {
           return incref(object(*boost::unsafe_any_cast<long>(&s)).ptr());
       else if(s.type() == typeid(std::string))
           return incref(object(*boost::unsafe_any_cast<std::string>(&s)).ptr());
+      else if(s.type() == typeid(object_ptr))
+          return incref((*boost::unsafe_any_cast<object_ptr>(&s))->ptr());
       else if(s.type() == typeid(object))
           return incref(boost::unsafe_any_cast<object>(&s)->ptr());
       else if(s.type() == typeid(Command::ptr))
-          return incref(object(boost::unsafe_any_cast<Command::ptr>(&s)).ptr());
+          return incref(object(texpy::gilUnwrap(
+                    *boost::unsafe_any_cast<Command::ptr>(&s))).ptr());
       else
           return incref(object(reprAny(s)).ptr());
     }
@@ -96,7 +106,8 @@ namespace {
               new (storage) boost::any(Command::ptr(cmd));
           } else {
               // fallback
-              new (storage) boost::any(any_object);
+              new (storage) boost::any(object_ptr(new object(any_object),
+                                    texpy::GILDelete<object>()));
           }
       }
 
@@ -0,0 +1,81 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <boost/python.hpp>
+#include <texpp/memstream.h>
+
+#include "gil.h"
+
+namespace texpp { namespace {
+
+// Keeps a python buffer (and the object exporting it) alive
+struct PythonBuffer
+{
+    Py_buffer view;
+    ~PythonBuffer() {
+        texpy::AcquireGIL gil;
+        PyBuffer_Release(&view);
+    }
+};
+
+// Converts any object supporting the buffer protocol (bytes, mmap,
+// bytearray, memoryview, ...) to an input stream reading directly
+// from the exported memory. Takes precedence over the file object
+// conversion, which would call python read() for every chunk.
+struct python_buffer_to_istream
+{
+    static void register_conversion() {
+        using namespace boost::python;
+        converter::registry::insert(&convertible, &construct,
+                        type_id< shared_ptr<std::istream> >());
+    }
+
+    static void* convertible(PyObject* obj_ptr) {
+        if(obj_ptr == Py_None || !PyObject_CheckBuffer(obj_ptr)) return 0;
+        return obj_ptr;
+    }
+
+    static void construct(PyObject* obj_ptr,
+            boost::python::converter::rvalue_from_python_stage1_data* data)
+    {
+        using namespace boost::python;
+        typedef converter::rvalue_from_python_storage<
+                            shared_ptr<std::istream> > rvalue_t;
+        void* storage = ((rvalue_t*) data)->storage.bytes;
+
+        shared_ptr<PythonBuffer> buffer(new PythonBuffer);
+        if(PyObject_GetBuffer(obj_ptr, &buffer->view, PyBUF_SIMPLE) != 0) {
+            // Nothing to release in ~PythonBuffer
+            buffer->view.obj = NULL;
+            throw_error_already_set();
+        }
+
+        new (storage) shared_ptr<std::istream>(new MemoryStream(
+                static_cast<const char*>(buffer->view.buf),
+                size_t(buffer->view.len), buffer));
+        data->convertible = storage;
+    }
+};
+
+}} // namespace texpp // namespace
+
+void export_buffer_stream()
+{
+    texpp::python_buffer_to_istream::register_conversion();
+}
+
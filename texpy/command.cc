@@ -19,21 +19,26 @@
 #include <boost/python.hpp>
 #include <texpp/parser.h>
 
+#include "gil.h"
+
 namespace texpp { namespace {
 
 using boost::python::wrapper;
-using boost::python::override;
 
 template<class Cmd>
-class CommandWrap: public Cmd, public wrapper<Cmd>
+class CommandWrap: public Cmd, public wrapper<Cmd>,
+                   public texpy::OverrideCache
 {
 public:
     CommandWrap(const string& name = string())
         : Cmd(name) {}
 
     string texRepr(Parser* parser) const {
-        if(override f = this->get_override("texRepr"))
-            return f(parser);
+        ensureOverrides();
+        if(m_texRepr.overridden()) {
+            texpy::AcquireGIL gil;
+            return m_texRepr.call<string>(self(), parser);
+        }
         return this->Cmd::texRepr(parser);
     }
 
@@ -42,8 +47,11 @@ public:
     }
 
     bool invoke(Parser& p, Node::ptr n) {
-        if(override f = this->get_override("invoke"))
-            return f(boost::ref(p), n);
+        ensureOverrides();
+        if(m_invoke.overridden()) {
+            texpy::AcquireGIL gil;
+            return m_invoke.call<bool>(self(), boost::ref(p), n);
+        }
         return this->Cmd::invoke(p, n);
     }
 
@@ -53,8 +61,12 @@ public:
 
     bool invokeWithPrefixes(Parser& p, Node::ptr n,
                             std::set<string>& prefixes) {
-        if(override f = this->get_override("invokeWithPrefixes"))
-            return f(boost::ref(p), n, boost::ref(prefixes));
+        ensureOverrides();
+        if(m_invokeWithPrefixes.overridden()) {
+            texpy::AcquireGIL gil;
+            return m_invokeWithPrefixes.call<bool>(self(),
+                            boost::ref(p), n, boost::ref(prefixes));
+        }
         return Cmd::invokeWithPrefixes(p, n, prefixes);
     }
 
@@ -62,6 +74,23 @@ public:
                                 std::set<string>& prefixes) {
         return Cmd::invokeWithPrefixes(p, n, prefixes);
     }
+
+protected:
+    PyObject* self() const {
+        return boost::python::detail::wrapper_base_::get_owner(*this);
+    }
+
+    void doResolveOverrides() {
+        PyTypeObject* cls = boost::python::converter::
+                    registered<Cmd>::converters.get_class_object();
+        m_texRepr.resolve(self(), cls, "texRepr");
+        m_invoke.resolve(self(), cls, "invoke");
+        m_invokeWithPrefixes.resolve(self(), cls, "invokeWithPrefixes");
+    }
+
+    texpy::Override m_texRepr;
+    texpy::Override m_invoke;
+    texpy::Override m_invokeWithPrefixes;
 };
 
 }}
@@ -105,5 +134,7 @@ void export_command()
     export_derived_command<TokenCommand, bases<Command>,
                 init<Token::ptr> >("TokenCommand");
 
+    texpy::gil_safe_shared_ptr_from_python<Command>::register_conversion();
+
 }
 
@@ -0,0 +1,264 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __TEXPY_GIL_H
+#define __TEXPY_GIL_H
+
+#include <boost/python.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/type_traits/is_polymorphic.hpp>
+
+/*
+    Parser.parse() runs with the GIL released. Every place where native
+    code may call back into python re-acquires it for the duration of
+    the callback only:
+
+      - Command/Logger methods overridden in python (CommandWrap,
+        LoggerWrap). Overrides are looked up once per object, see
+        OverrideCache, so methods that are not overridden never take
+        the GIL,
+      - reads from python file objects (python_file_buffer),
+      - releasing the last native reference to a python-owned object.
+
+    A parser created with logger=None, reading from a real file or a
+    buffer-protocol object and using only native commands never calls
+    any of the above, so it runs without touching the GIL at all until
+    parse() returns.
+*/
+
+namespace texpy {
+
+// Releases the GIL held by the current thread for the scope lifetime
+class ReleaseGIL: boost::noncopyable
+{
+public:
+    ReleaseGIL(): m_state(PyEval_SaveThread()) {}
+    ~ReleaseGIL() { PyEval_RestoreThread(m_state); }
+
+private:
+    PyThreadState* m_state;
+};
+
+// Acquires the GIL for the scope lifetime. Safe to nest and to use
+// from threads that already hold it.
+class AcquireGIL: boost::noncopyable
+{
+public:
+    AcquireGIL(): m_state(PyGILState_Ensure()) {}
+    ~AcquireGIL() { PyGILState_Release(m_state); }
+
+private:
+    PyGILState_STATE m_state;
+};
+
+// shared_ptr deleter that destroys its pointee with the GIL held
+template<typename T>
+struct GILDelete
+{
+    void operator()(T* p) const { AcquireGIL gil; delete p; }
+};
+
+// shared_ptr deleter that keeps a python owner alive and drops it
+// with the GIL held, whichever thread releases the last reference.
+// The owner is a shared_ptr created by boost.python so that gilUnwrap()
+// can give back a pointer that converts to the original python object.
+struct GILOwnerDeleter
+{
+    explicit GILOwnerDeleter(const boost::shared_ptr<void>& owner)
+        : m_owner(owner) {}
+
+    void operator()(const void*) {
+        AcquireGIL gil;
+        m_owner.reset();
+    }
+
+    boost::shared_ptr<void> m_owner;
+};
+
+// Returns a pointer that boost.python converts back to the original
+// python object instead of creating a new wrapper for it
+template<typename T>
+boost::shared_ptr<T> gilUnwrap(const boost::shared_ptr<T>& p)
+{
+    if(GILOwnerDeleter* d = boost::get_deleter<GILOwnerDeleter>(p))
+        if(d->m_owner) return boost::shared_ptr<T>(d->m_owner, p.get());
+    return p;
+}
+
+// A python function overriding a virtual method of a wrapped class.
+// resolve() follows wrapper::get_override() but keeps the function
+// rather than the method bound to self: a bound method stored in the
+// native object would keep its own python owner alive forever.
+class Override
+{
+public:
+    Override(): m_bound(false) {}
+
+    // Must be called with the GIL held
+    void resolve(PyObject* self, PyTypeObject* cls, const char* name)
+    {
+        using namespace boost::python;
+        m_func = object();
+        m_bound = false;
+        if(!self) return;
+
+        handle<> m(allow_null(PyObject_GetAttrString(self, name)));
+        if(!m) { PyErr_Clear(); return; }
+
+        if(PyMethod_Check(m.get()) && PyMethod_GET_SELF(m.get()) == self) {
+            PyObject* f = PyMethod_GET_FUNCTION(m.get());
+            if(cls && cls->tp_dict &&
+                    PyDict_GetItemString(cls->tp_dict, name) == f)
+                return; // the native default
+            m_func = object(handle<>(borrowed(f)));
+            m_bound = true;
+        } else {
+            m_func = object(m);
+        }
+    }
+
+    bool overridden() const { return !m_func.is_none(); }
+
+    // The call itself must be made with the GIL held
+    template<typename R, typename A0>
+    R call(PyObject* self, const A0& a0) const {
+        using boost::python::call;
+        if(m_bound) return call<R>(m_func.ptr(), borrowedSelf(self), a0);
+        return call<R>(m_func.ptr(), a0);
+    }
+
+    template<typename R, typename A0, typename A1>
+    R call(PyObject* self, const A0& a0, const A1& a1) const {
+        using boost::python::call;
+        if(m_bound) return call<R>(m_func.ptr(), borrowedSelf(self), a0, a1);
+        return call<R>(m_func.ptr(), a0, a1);
+    }
+
+    template<typename R, typename A0, typename A1, typename A2>
+    R call(PyObject* self, const A0& a0, const A1& a1, const A2& a2) const {
+        using boost::python::call;
+        if(m_bound)
+            return call<R>(m_func.ptr(), borrowedSelf(self), a0, a1, a2);
+        return call<R>(m_func.ptr(), a0, a1, a2);
+    }
+
+    template<typename R, typename A0, typename A1, typename A2, typename A3>
+    R call(PyObject* self, const A0& a0, const A1& a1,
+                           const A2& a2, const A3& a3) const {
+        using boost::python::call;
+        if(m_bound)
+            return call<R>(m_func.ptr(), borrowedSelf(self), a0, a1, a2, a3);
+        return call<R>(m_func.ptr(), a0, a1, a2, a3);
+    }
+
+protected:
+    static boost::python::object borrowedSelf(PyObject* self) {
+        using namespace boost::python;
+        return object(handle<>(borrowed(self)));
+    }
+
+    boost::python::object m_func;
+    bool m_bound;
+};
+
+// Base of CommandWrap and LoggerWrap. Overrides are resolved when the
+// python object is first converted to a native shared_ptr, that is
+// when it is handed to the parser, and are not looked up again:
+// methods assigned to the class or the instance afterwards are not
+// seen. Objects reaching native code in some other way resolve them
+// on first use instead.
+class OverrideCache
+{
+public:
+    OverrideCache(): m_overridesResolved(false) {}
+    virtual ~OverrideCache() {}
+
+    // Must be called with the GIL held
+    void resolveOverrides() {
+        if(m_overridesResolved) return;
+        doResolveOverrides();
+        m_overridesResolved = true;
+    }
+
+protected:
+    void ensureOverrides() const {
+        if(!m_overridesResolved) {
+            AcquireGIL gil;
+            const_cast<OverrideCache*>(this)->resolveOverrides();
+        }
+    }
+
+    virtual void doResolveOverrides() = 0;
+
+    bool m_overridesResolved;
+};
+
+// Registers a from-python conversion to shared_ptr<T> that takes
+// precedence over the default boost.python one and returns pointers
+// which are safe to release without the GIL
+template<typename T>
+struct gil_safe_shared_ptr_from_python
+{
+    static void register_conversion() {
+        using namespace boost::python;
+        converter::registry::insert(&convertible, &construct,
+                        type_id< boost::shared_ptr<T> >());
+    }
+
+    static void* convertible(PyObject* obj_ptr) {
+        using namespace boost::python;
+        if(obj_ptr == Py_None) return obj_ptr;
+        return converter::get_lvalue_from_python(obj_ptr,
+                        converter::registered<T>::converters);
+    }
+
+    static void construct(PyObject* obj_ptr,
+            boost::python::converter::rvalue_from_python_stage1_data* data)
+    {
+        using namespace boost::python;
+        typedef converter::rvalue_from_python_storage<
+                            boost::shared_ptr<T> > rvalue_t;
+        void* storage = ((rvalue_t*) data)->storage.bytes;
+
+        if(data->convertible == obj_ptr && obj_ptr == Py_None) {
+            new (storage) boost::shared_ptr<T>();
+        } else {
+            resolveOverrides(static_cast<T*>(data->convertible),
+                             boost::is_polymorphic<T>());
+
+            boost::shared_ptr<void> owner(data->convertible,
+                converter::shared_ptr_deleter(handle<>(borrowed(obj_ptr))));
+            new (storage) boost::shared_ptr<T>(
+                static_cast<T*>(data->convertible), GILOwnerDeleter(owner));
+        }
+        data->convertible = storage;
+    }
+
+    static void resolveOverrides(T* p, boost::true_type) {
+        if(OverrideCache* c = dynamic_cast<OverrideCache*>(p))
+            c->resolveOverrides();
+    }
+
+    static void resolveOverrides(T*, boost::false_type) {}
+};
+
+} // namespace texpy
+
+#endif
+
@@ -18,6 +18,9 @@
 
 #include <boost/python.hpp>
 #include <texpp/lexer.h>
+#include <texpp/tokentable.h>
+
+#include "gil.h"
 
 /*
 namespace texpp {
@@ -30,16 +33,34 @@ public:
 };
 }*/
 
+namespace texpp { namespace {
+
+// Lexes the whole input (or limit tokens) without returning to python
+TokenTable::ptr Lexer_tokenTable(Lexer& lexer, size_t limit)
+{
+    TokenTable::ptr table(new TokenTable);
+    texpy::ReleaseGIL nogil;
+    table->lex(lexer, limit);
+    return table;
+}
+
+}} // namespace texpp // namespace
+
+void export_token_table();
+
 void export_lexer()
 {
     using namespace boost::python;
     using namespace texpp;
 
+    export_token_table();
+
     class_<Lexer, shared_ptr<Lexer> >("Lexer",
             init<std::string, shared_ptr<std::istream>,bool,bool>())
         .def(init<std::string, shared_ptr<std::istream>,bool>())
         .def(init<std::string, shared_ptr<std::istream> >())
         .def("nextToken", &Lexer::nextToken)
+        .def("tokenTable", &Lexer_tokenTable, (arg("limit") = 0))
         .def("fileName", &Lexer::fileName, 
                 return_value_policy<copy_const_reference>())
         .def("line", (const string& (Lexer::*)() const) &Lexer::line,
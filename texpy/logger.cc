@@ -19,20 +19,27 @@
 #include <boost/python.hpp>
 #include <texpp/parser.h>
 #include <texpp/logger.h>
+#include <texpp/asynclogger.h>
+
+#include "gil.h"
 
 namespace texpp { namespace {
 
 using boost::python::wrapper;
-using boost::python::override;
 
 template<class Log>
-class LoggerWrap: public Log, public wrapper<Log>
+class LoggerWrap: public Log, public wrapper<Log>,
+                  public texpy::OverrideCache
 {
 public:
     bool log(Logger::Level level, const string& message,
                     Parser& parser, shared_ptr<Token> token) {
-        if(override f = this->get_override("log"))
-            return f(level, message, parser, token);
+        ensureOverrides();
+        if(m_log.overridden()) {
+            texpy::AcquireGIL gil;
+            return m_log.call<bool>(self(), level, message,
+                                    boost::ref(parser), token);
+        }
         return this->Log::log(level, message, parser, token);
     }
 
@@ -40,8 +47,46 @@ public:
                     Parser& parser, shared_ptr<Token> token) {
         return this->Log::log(level, message, parser, token);
     }
+
+    // A python subclass that overrides log() but not enabled() should
+    // keep receiving every message, even when derived from NullLogger
+    bool enabled(Logger::Level level) const {
+        ensureOverrides();
+        if(m_enabled.overridden()) {
+            texpy::AcquireGIL gil;
+            return m_enabled.call<bool>(self(), level);
+        }
+        if(m_log.overridden())
+            return true;
+        return this->Log::enabled(level);
+    }
+
+    bool default_enabled(Logger::Level level) const {
+        return this->Log::enabled(level);
+    }
+
+protected:
+    PyObject* self() const {
+        return boost::python::detail::wrapper_base_::get_owner(*this);
+    }
+
+    void doResolveOverrides() {
+        PyTypeObject* cls = boost::python::converter::
+                    registered<Log>::converters.get_class_object();
+        m_log.resolve(self(), cls, "log");
+        m_enabled.resolve(self(), cls, "enabled");
+    }
+
+    texpy::Override m_log;
+    texpy::Override m_enabled;
 };
 
+void AsyncLogger_flush(AsyncLogger& self)
+{
+    texpy::ReleaseGIL nogil;
+    self.flush();
+}
+
 }}
 
 void export_logger_base()
@@ -55,11 +100,16 @@ void export_logger_base()
         /*.def("levelName", &Logger::levelName,
             return_value_policy<copy_const_reference>())*/
         .def("tokenLines", &Logger::tokenLines)
+        .def("enabled", &Logger::enabled)
         .def("log", pure_virtual(&Logger::log))
         ;
 
     enum_<Logger::Level>("Level")
+        .value("MTRACING", Logger::MTRACING)
+        .value("TRACING", Logger::TRACING)
+        .value("PLAIN", Logger::PLAIN)
         .value("MESSAGE", Logger::MESSAGE)
+        .value("WRITE", Logger::WRITE)
         .value("SHOW", Logger::SHOW)
         .value("ERROR", Logger::ERROR)
         .value("CRITICAL", Logger::CRITICAL)
@@ -73,9 +123,12 @@ void export_derived_logger(const char* name)
     using namespace boost::python;
     using namespace texpp;
 
-    class_<LoggerWrap<Log>, shared_ptr<Log>, _bases >(name)
+    class_<LoggerWrap<Log>, shared_ptr< LoggerWrap<Log> >, _bases,
+            boost::noncopyable>(name)
         .def("log", &Log::log,
                 &LoggerWrap<Log>::default_log)
+        .def("enabled", &Log::enabled,
+                &LoggerWrap<Log>::default_enabled)
         ;
 }
 
@@ -87,5 +140,20 @@ void export_logger()
     export_logger_base();
     export_derived_logger<NullLogger, bases<Logger> >("NullLogger");
     export_derived_logger<ConsoleLogger, bases<Logger> >("ConsoleLogger");
+
+    // Not subclassable from python: its point is to keep logging
+    // entirely out of the interpreter
+    class_<AsyncLogger, shared_ptr<AsyncLogger>, bases<ConsoleLogger>,
+            boost::noncopyable>("AsyncLogger", init<optional<int, size_t> >())
+        .def(init<std::string, optional<size_t> >())
+        .def("flush", &AsyncLogger_flush)
+        .def("good", &AsyncLogger::good)
+        .def("bufferSize", &AsyncLogger::bufferSize)
+        .def("queued", &AsyncLogger::queued)
+        .def("dropped", &AsyncLogger::dropped)
+        .def("droppedBytes", &AsyncLogger::droppedBytes)
+        ;
+
+    texpy::gil_safe_shared_ptr_from_python<Logger>::register_conversion();
 }
 
@@ -0,0 +1,101 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <boost/python.hpp>
+#include <texpp/parser.h>
+#include <texpp/nodequery.h>
+
+#include "gil.h"
+
+namespace texpp { namespace {
+
+shared_ptr<NodeQuery> NodeQuery_create(const string& selector)
+{
+    shared_ptr<NodeQuery> query(new NodeQuery(selector));
+    if(!query->isValid()) {
+        PyErr_SetString(PyExc_ValueError, query->error().c_str());
+        boost::python::throw_error_already_set();
+    }
+    return query;
+}
+
+// Matches as (parent, index, count) tuples
+boost::python::list NodeQuery_select(const NodeQuery& query, Node::ptr root)
+{
+    vector<NodeQuery::Match> matches;
+    {
+        texpy::ReleaseGIL nogil;
+        matches = query.select(root);
+    }
+
+    boost::python::list result;
+    for(size_t n = 0; n < matches.size(); ++n) {
+        const NodeQuery::Match& m = matches[n];
+        result.append(boost::python::make_tuple(m.parent, m.index, m.count));
+    }
+    return result;
+}
+
+boost::python::list NodeQuery_nodes(const NodeQuery& query, Node::ptr root)
+{
+    vector<Node::ptr> nodes;
+    {
+        texpy::ReleaseGIL nogil;
+        nodes = query.nodes(root);
+    }
+
+    boost::python::list result;
+    for(size_t n = 0; n < nodes.size(); ++n)
+        result.append(nodes[n]);
+    return result;
+}
+
+boost::python::list NodeQuery_spans(const NodeQuery& query, Node::ptr root)
+{
+    vector< std::pair<size_t, size_t> > spans;
+    {
+        texpy::ReleaseGIL nogil;
+        spans = query.spans(root);
+    }
+
+    boost::python::list result;
+    for(size_t n = 0; n < spans.size(); ++n)
+        result.append(spans[n]);
+    return result;
+}
+
+}} // namespace texpp // namespace
+
+void export_node_query()
+{
+    using namespace boost::python;
+    using namespace texpp;
+
+    class_<NodeQuery, shared_ptr<NodeQuery>, boost::noncopyable>(
+            "NodeQuery", no_init)
+        .def("__init__", make_constructor(&NodeQuery_create))
+        .def("selector", &NodeQuery::selector,
+            return_value_policy<copy_const_reference>())
+        .def("select", &NodeQuery_select)
+        .def("nodes", &NodeQuery_nodes)
+        .def("spans", &NodeQuery_spans)
+        .def("escape", &NodeQuery::escape)
+        .staticmethod("escape")
+        ;
+}
+
@@ -0,0 +1,96 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <boost/python.hpp>
+#include <texpp/parser.h>
+#include <texpp/nodetable.h>
+
+#include "array_view.h"
+
+namespace texpp { namespace {
+
+#define NODE_TABLE_COLUMN(name) \
+    ArrayView NodeTable_##name(shared_ptr<NodeTable> table) { \
+        return ArrayView::fromVector(table, table->name()); \
+    }
+
+NODE_TABLE_COLUMN(types)
+NODE_TABLE_COLUMN(parents)
+NODE_TABLE_COLUMN(roles)
+NODE_TABLE_COLUMN(files)
+NODE_TABLE_COLUMN(starts)
+NODE_TABLE_COLUMN(ends)
+NODE_TABLE_COLUMN(valueOffsets)
+
+#undef NODE_TABLE_COLUMN
+
+ArrayView NodeTable_valuePool(shared_ptr<NodeTable> table)
+{
+    return ArrayView::fromString(table, table->valuePool());
+}
+
+boost::python::list namesList(const vector<string>& names)
+{
+    boost::python::list result;
+    for(size_t n = 0; n < names.size(); ++n)
+        result.append(names[n]);
+    return result;
+}
+
+boost::python::list NodeTable_typeNames(const NodeTable& table)
+{
+    return namesList(table.typeNames());
+}
+
+boost::python::list NodeTable_roleNames(const NodeTable& table)
+{
+    return namesList(table.roleNames());
+}
+
+boost::python::list NodeTable_fileNames(const NodeTable& table)
+{
+    return namesList(table.fileNames());
+}
+
+}} // namespace texpp // namespace
+
+void export_node_table()
+{
+    using namespace boost::python;
+    using namespace texpp;
+
+    class_<NodeTable, shared_ptr<NodeTable>, boost::noncopyable>(
+            "NodeTable", init<Node::ptr>())
+        .def("__len__", &NodeTable::size)
+        .def("size", &NodeTable::size)
+
+        .def("types", &NodeTable_types)
+        .def("parents", &NodeTable_parents)
+        .def("roles", &NodeTable_roles)
+        .def("files", &NodeTable_files)
+        .def("starts", &NodeTable_starts)
+        .def("ends", &NodeTable_ends)
+        .def("valueOffsets", &NodeTable_valueOffsets)
+        .def("valuePool", &NodeTable_valuePool)
+
+        .def("typeNames", &NodeTable_typeNames)
+        .def("roleNames", &NodeTable_roleNames)
+        .def("fileNames", &NodeTable_fileNames)
+        ;
+}
+
@@ -0,0 +1,61 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include <boost/python.hpp>
+#include <texpp/outputsink.h>
+
+#include <boost/foreach.hpp>
+
+namespace texpp { namespace {
+
+boost::python::list MemoryOutputSink_fileNames(const MemoryOutputSink& self)
+{
+    boost::python::list result;
+    BOOST_FOREACH(const string& name, self.fileNames())
+        result.append(name);
+    return result;
+}
+
+}} // namespace texpp // namespace
+
+void export_output_sink()
+{
+    using namespace boost::python;
+    using namespace texpp;
+
+    class_<OutputSink, shared_ptr<OutputSink>,
+                boost::noncopyable>("OutputSink", no_init)
+        .def("flush", &OutputSink::flush)
+        ;
+
+    class_<FileOutputSink, shared_ptr<FileOutputSink>,
+            bases<OutputSink>, boost::noncopyable>("FileOutputSink",
+                init<optional<size_t> >())
+        .def("bufferSize", &FileOutputSink::bufferSize)
+        ;
+
+    class_<MemoryOutputSink, shared_ptr<MemoryOutputSink>,
+            bases<OutputSink>, boost::noncopyable>("MemoryOutputSink")
+        .def("exists", &MemoryOutputSink::exists)
+        .def("contents", &MemoryOutputSink::contents)
+        .def("fileNames", &MemoryOutputSink_fileNames)
+        .def("clear", &MemoryOutputSink::clear)
+        ;
+}
+
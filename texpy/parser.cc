@@ -18,6 +18,11 @@
 
 #include <boost/python.hpp>
 #include <texpp/parser.h>
+#include <texpp/nodetable.h>
+#include <texpp/profiler.h>
+#include <texpp/prefetch.h>
+#include <texpp/outputsink.h>
+#include <texpp/vfs.h>
 
 #include <boost/any.hpp>
 #include <memory>
@@ -27,6 +32,7 @@
 
 #include "std_pair.h"
 #include "shared_ptr.h"
+#include "gil.h"
 
 /*
 namespace texpp { namespace {
@@ -61,6 +67,31 @@ public:
 
 }}*/
 
+void export_node_table();
+void export_node_query();
+
+namespace texpp { namespace {
+
+NodeTable::ptr Node_table(Node::ptr node)
+{
+    return NodeTable::ptr(new NodeTable(node));
+}
+
+Node::ptr Parser_parse(Parser& parser)
+{
+    texpy::ReleaseGIL nogil;
+    return parser.parse();
+}
+
+Node::ptr Parser_reparse(Parser& parser,
+                shared_ptr<std::istream> file, size_t editBegin)
+{
+    texpy::ReleaseGIL nogil;
+    return parser.reparse(file, editBegin);
+}
+
+}} // namespace texpp // namespace
+
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(
     Node_treeRepr_overloads, treeRepr, 0, 1)
 
@@ -75,6 +106,8 @@ void export_node()
     export_std_pair<string, Node::ptr>();
     export_std_pair<size_t, size_t>();
     export_shared_ptr<string>();
+    export_node_table();
+    export_node_query();
 
     scope scopeNode = class_<Node, shared_ptr<Node> >(
             "Node", init<std::string>())
@@ -106,6 +139,7 @@ void export_node()
         .def("child", (Node::ptr (Node::*)(const string&))(&Node::child))
         .def("child", (Node::ptr (Node::*)(int))(&Node::child))
         .def("appendChild", &Node::appendChild)
+        .def("table", &Node_table)
         ;
 
     class_< std::vector<size_t> >("SizeTVector")
@@ -119,6 +153,8 @@ void export_node()
     class_< unordered_map<shared_ptr<string>, string> >("SourcesMap")
         .def(map_indexing_suite< unordered_map<shared_ptr<string>, string>, true >())
     ;
+
+    texpy::gil_safe_shared_ptr_from_python<Node>::register_conversion();
 }
 
 #define PARSER_OVERLOADS(name, n1, n2) \
@@ -145,12 +181,23 @@ void export_parser()
     scope scopeParser = class_<Parser, boost::noncopyable >("Parser",
             init<std::string, shared_ptr<std::istream>,
                  std::string, bool, bool, shared_ptr<Logger> >())
+        .def(init<std::string, shared_ptr<std::istream>,
+                 std::string, bool, bool, shared_ptr<Logger>,
+                 Parser::Style>())
         .def(init<std::string, shared_ptr<std::istream>, std::string, bool, bool>())
         .def(init<std::string, shared_ptr<std::istream>, std::string, bool>())
         .def(init<std::string, shared_ptr<std::istream>, std::string >())
         .def(init<std::string, shared_ptr<std::istream> >())
 
-        .def("parse", &Parser::parse)
+        .def("parse", &Parser_parse)
+        .def("reparse", &Parser_reparse)
+
+        .def("setCheckpointInterval", &Parser::setCheckpointInterval)
+        .def("checkpointInterval", &Parser::checkpointInterval)
+        .def("checkpointsCount", &Parser::checkpointsCount)
+        .def("checkpointPos", &Parser::checkpointPos)
+
+        .def("style", &Parser::style)
 
         .def("workdir", &Parser::workdir,
             return_value_policy<copy_const_reference>())
@@ -197,6 +244,27 @@ void export_parser()
 
         .def("input", &Parser::input)
 
+        // Files
+        .def("setVfs", &Parser::setVfs)
+        .def("vfs", &Parser::vfs)
+        .def("resolveFile", &Parser::resolveFile)
+
+        // Logging
+        .def("logEnabled", &Parser::logEnabled)
+        .def("updateLogLevels", &Parser::updateLogLevels)
+
+        // Profiling
+        .def("setProfiler", &Parser::setProfiler)
+        .def("profiler", &Parser::profiler)
+
+        // Prefetching
+        .def("setPrefetcher", &Parser::setPrefetcher)
+        .def("prefetcher", &Parser::prefetcher)
+
+        // Output files
+        .def("setOutputSink", &Parser::setOutputSink)
+        .def("outputSink", &Parser::outputSink)
+
         .def("end", &Parser::end)
         ;
 
@@ -214,5 +282,10 @@ void export_parser()
         .value("CUSTOM", Parser::GROUP_CUSTOM)
         ;
 
+    enum_<Parser::Style>("Style")
+        .value("PLAIN", Parser::STYLE_PLAIN)
+        .value("LATEX", Parser::STYLE_LATEX)
+        ;
+
 }
 
@@ -0,0 +1,74 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include <boost/python.hpp>
+#include <texpp/prefetch.h>
+
+#include <boost/foreach.hpp>
+
+#include "gil.h"
+
+namespace texpp { namespace {
+
+void Prefetcher_wait(Prefetcher& self)
+{
+    texpy::ReleaseGIL nogil;
+    self.wait();
+}
+
+boost::python::list Prefetcher_inputNames(const string& text)
+{
+    boost::python::list result;
+    BOOST_FOREACH(const string& name,
+                Prefetcher::inputNames(text.data(), text.size()))
+        result.append(name);
+    return result;
+}
+
+}} // namespace texpp // namespace
+
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(Prefetcher_prefetch_overloads,
+                                    prefetch, 1, 2)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(Prefetcher_prefetchName_overloads,
+                                    prefetchName, 1, 2)
+
+void export_prefetcher()
+{
+    using namespace boost::python;
+    using namespace texpp;
+
+    class_<Prefetcher, shared_ptr<Prefetcher>,
+                boost::noncopyable>("Prefetcher",
+                    init<optional<bool, size_t> >())
+        .def("prefetch", &Prefetcher::prefetch,
+                    Prefetcher_prefetch_overloads())
+        .def("prefetchName", &Prefetcher::prefetchName,
+                    Prefetcher_prefetchName_overloads())
+        .def("wait", &Prefetcher_wait)
+        .def("speculative", &Prefetcher::speculative)
+        .def("setSpeculative", &Prefetcher::setSpeculative)
+        .def("maxBytes", &Prefetcher::maxBytes)
+        .def("hits", &Prefetcher::hits)
+        .def("misses", &Prefetcher::misses)
+        .def("loadedBytes", &Prefetcher::loadedBytes)
+        .def("inputNames", &Prefetcher_inputNames)
+        .staticmethod("inputNames")
+        ;
+}
+
@@ -0,0 +1,72 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <boost/python.hpp>
+#include <texpp/profiler.h>
+
+#include <boost/foreach.hpp>
+
+namespace texpp { namespace {
+
+boost::python::list Profiler_entries(const Profiler& profiler,
+                            Profiler::SortKey key = Profiler::BY_EXCLUSIVE)
+{
+    boost::python::list result;
+    BOOST_FOREACH(const Profiler::Entry& e, profiler.entries(key))
+        result.append(e);
+    return result;
+}
+
+}} // namespace texpp // namespace
+
+BOOST_PYTHON_FUNCTION_OVERLOADS(Profiler_entries_overloads,
+                                    texpp::Profiler_entries, 1, 2)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(Profiler_report_overloads,
+                                    report, 0, 2)
+
+void export_profiler()
+{
+    using namespace boost::python;
+    using namespace texpp;
+
+    scope scopeProfiler = class_<Profiler, shared_ptr<Profiler>,
+                                boost::noncopyable>("Profiler")
+        .def("reset", &Profiler::reset)
+        .def("entries", &Profiler_entries, Profiler_entries_overloads())
+        .def("report", &Profiler::report, Profiler_report_overloads())
+        .def("collapsedStacks", &Profiler::collapsedStacks)
+        ;
+
+    class_<Profiler::Entry>("Entry", no_init)
+        .def_readonly("name", &Profiler::Entry::name)
+        .def_readonly("count", &Profiler::Entry::count)
+        .def_readonly("inclusive", &Profiler::Entry::inclusive)
+        .def_readonly("exclusive", &Profiler::Entry::exclusive)
+        .def_readonly("tokens", &Profiler::Entry::tokens)
+        .def_readonly("maxDepth", &Profiler::Entry::maxDepth)
+        ;
+
+    enum_<Profiler::SortKey>("SortKey")
+        .value("EXCLUSIVE", Profiler::BY_EXCLUSIVE)
+        .value("INCLUSIVE", Profiler::BY_INCLUSIVE)
+        .value("COUNT", Profiler::BY_COUNT)
+        .value("TOKENS", Profiler::BY_TOKENS)
+        .value("NAME", Profiler::BY_NAME)
+        ;
+}
+
@@ -90,7 +90,8 @@ namespace boost_adaptbx { namespace file_conversion {
       void *storage = ((rvalue_t *) data)->storage.bytes;
       object python_file((handle<>(borrowed(obj_ptr))));
       new (storage) boost::shared_ptr<python_file_buffer>(
-            new python_file_buffer(python_file));
+            new python_file_buffer(python_file),
+            texpy::GILDelete<python_file_buffer>());
       data->convertible = storage;
     }
   };
@@ -133,7 +134,9 @@ namespace boost_adaptbx { namespace file_conversion {
           object python_file((handle<>(borrowed(obj_ptr))));
           new (storage) boost::shared_ptr<_stream>(
                 new _realstream(boost::shared_ptr<python_file_buffer>(
-                    new python_file_buffer(python_file))));
+                    new python_file_buffer(python_file),
+                    texpy::GILDelete<python_file_buffer>())),
+                texpy::GILDelete<_stream>());
       }
       data->convertible = storage;
     }
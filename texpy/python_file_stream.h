@@ -55,6 +55,8 @@
 #include <boost/optional.hpp>
 #include <boost/utility/typed_in_place_factory.hpp>
 
+#include "gil.h"
+
 #include <streambuf>
 #include <iostream>
 
@@ -224,12 +226,14 @@ class python_file_buffer : public std::basic_streambuf<char>
 
     /// Mundane destructor freeing the allocated resources
     virtual ~python_file_buffer() {
+      texpy::AcquireGIL gil;
       this->sync();
       if (write_buffer) delete[] write_buffer;
     }
 
     /// C.f. C++ standard section 27.5.2.4.3
     virtual int_type underflow() {
+      texpy::AcquireGIL gil;
       int_type const failure = traits_type::eof();
       if (py_read == python::object()) {
         PyErr_SetString(PyExc_AttributeError,
@@ -257,6 +261,7 @@ class python_file_buffer : public std::basic_streambuf<char>
 
     /// C.f. C++ standard section 27.5.2.4.5
     virtual int_type overflow(int_type c=traits_type_eof()) {
+      texpy::AcquireGIL gil;
       if (py_write == python::object()) {
         PyErr_SetString(PyExc_AttributeError,
                         "That Python file object has no 'write' attribute");
@@ -288,6 +293,7 @@ class python_file_buffer : public std::basic_streambuf<char>
         seek position in that read buffer.
     */
     virtual int sync() {
+      texpy::AcquireGIL gil;
       int result = 0;
       farthest_pptr = std::max(farthest_pptr, pptr());
       if (farthest_pptr && farthest_pptr > pbase()) {
@@ -319,6 +325,7 @@ class python_file_buffer : public std::basic_streambuf<char>
          on the stream using this buffer. That simplifies the code
          in a few places.
       */
+      texpy::AcquireGIL gil;
       int const failure = off_type(-1);
 
       if (py_seek == python::object()) {
@@ -25,6 +25,8 @@
 #include <memory>
 
 void export_python_stream();
+void export_buffer_stream();
+void export_array_view();
 void export_boost_any();
 void export_std_set();
 void export_token();
@@ -32,13 +34,24 @@ void export_lexer();
 void export_command();
 void export_parser();
 void export_logger();
+void export_profiler();
+void export_prefetcher();
+void export_output_sink();
+void export_vfs();
 
 BOOST_PYTHON_MODULE(texpy)
 {
     using namespace boost::python;
     using namespace texpp;
 
+#if PY_VERSION_HEX < 0x03070000
+    // Parser.parse() releases the GIL
+    PyEval_InitThreads();
+#endif
+
     export_python_stream();
+    export_buffer_stream();
+    export_array_view();
     export_boost_any();
     export_std_set();
     export_token();
@@ -46,6 +59,10 @@ BOOST_PYTHON_MODULE(texpy)
     export_command();
     export_parser();
     export_logger();
+    export_profiler();
+    export_prefetcher();
+    export_output_sink();
+    export_vfs();
 
     def("kpsewhich", texpp::kpsewhich);
 
@@ -22,6 +22,8 @@
 
 #include <boost/python/suite/indexing/vector_indexing_suite.hpp>
 
+#include "gil.h"
+
 void export_token_class()
 {
     using namespace boost::python;
@@ -105,5 +107,7 @@ void export_token()
     class_<std::vector< shared_ptr<Token> > >("TokenList")
         .def(vector_indexing_suite<std::vector< shared_ptr<Token> >, true >())
     ;
+
+    texpy::gil_safe_shared_ptr_from_python<Token>::register_conversion();
 }
 
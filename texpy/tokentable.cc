@@ -0,0 +1,82 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <boost/python.hpp>
+#include <texpp/lexer.h>
+#include <texpp/tokentable.h>
+
+#include "array_view.h"
+#include "gil.h"
+
+namespace texpp { namespace {
+
+#define TOKEN_TABLE_COLUMN(name) \
+    ArrayView TokenTable_##name(shared_ptr<TokenTable> table) { \
+        return ArrayView::fromVector(table, table->name()); \
+    }
+
+TOKEN_TABLE_COLUMN(types)
+TOKEN_TABLE_COLUMN(catCodes)
+TOKEN_TABLE_COLUMN(values)
+TOKEN_TABLE_COLUMN(lineNos)
+TOKEN_TABLE_COLUMN(starts)
+TOKEN_TABLE_COLUMN(ends)
+
+#undef TOKEN_TABLE_COLUMN
+
+boost::python::list TokenTable_valueNames(const TokenTable& table)
+{
+    boost::python::list result;
+    const vector<string>& names = table.valueNames();
+    for(size_t n = 0; n < names.size(); ++n)
+        result.append(names[n]);
+    return result;
+}
+
+size_t TokenTable_lex(TokenTable& table, Lexer& lexer, size_t limit)
+{
+    texpy::ReleaseGIL nogil;
+    return table.lex(lexer, limit);
+}
+
+}} // namespace texpp // namespace
+
+void export_token_table()
+{
+    using namespace boost::python;
+    using namespace texpp;
+
+    class_<TokenTable, shared_ptr<TokenTable>, boost::noncopyable>(
+            "TokenTable", init<>())
+        .def("__len__", &TokenTable::size)
+        .def("size", &TokenTable::size)
+        .def("lex", &TokenTable_lex,
+                (arg("lexer"), arg("limit") = 0))
+        .def("clear", &TokenTable::clear)
+
+        .def("types", &TokenTable_types)
+        .def("catCodes", &TokenTable_catCodes)
+        .def("values", &TokenTable_values)
+        .def("lineNos", &TokenTable_lineNos)
+        .def("starts", &TokenTable_starts)
+        .def("ends", &TokenTable_ends)
+
+        .def("valueNames", &TokenTable_valueNames)
+        ;
+}
+
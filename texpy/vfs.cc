@@ -0,0 +1,107 @@
+/*  This file is part of texpp library.
+    Copyright (C) 2009 Vladimir Kuznetsov <ks.vladimir@gmail.com>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include <boost/python.hpp>
+#include <texpp/vfs.h>
+
+#include <boost/foreach.hpp>
+
+namespace texpp { namespace {
+
+boost::python::list MemoryVfs_fileNames(const MemoryVfs& self)
+{
+    boost::python::list result;
+    BOOST_FOREACH(const string& name, self.fileNames())
+        result.append(name);
+    return result;
+}
+
+void MemoryVfs_add(MemoryVfs& self, const string& path, const string& data)
+{
+    self.add(path, data);
+}
+
+string Vfs_read(Vfs& self, const string& path)
+{
+    shared_ptr<std::istream> stream = self.open(path);
+    if(!stream) return string();
+    return string(std::istreambuf_iterator<char>(*stream),
+                  std::istreambuf_iterator<char>());
+}
+
+bool ArchiveVfs_load(ArchiveVfs& self, const string& fileName,
+                const string& root = string(),
+                const string& singleFileName = "main.tex")
+{
+    return self.load(fileName, root, singleFileName);
+}
+
+bool ArchiveVfs_loadData(ArchiveVfs& self, const string& data,
+                const string& root = string(),
+                const string& singleFileName = "main.tex")
+{
+    shared_ptr<string> copy(new string(data));
+    return self.load(copy->data(), copy->size(), copy, root, singleFileName);
+}
+
+}} // namespace texpp // namespace
+
+BOOST_PYTHON_FUNCTION_OVERLOADS(ArchiveVfs_load_overloads,
+                                    texpp::ArchiveVfs_load, 2, 4)
+BOOST_PYTHON_FUNCTION_OVERLOADS(ArchiveVfs_loadData_overloads,
+                                    texpp::ArchiveVfs_loadData, 2, 4)
+
+void export_vfs()
+{
+    using namespace boost::python;
+    using namespace texpp;
+
+    class_<Vfs, shared_ptr<Vfs>, boost::noncopyable>("Vfs", no_init)
+        .def("exists", &Vfs::exists)
+        .def("resolve", &Vfs::resolve)
+        .def("read", &Vfs_read)
+        .def("normalizePath", &Vfs::normalizePath)
+        .staticmethod("normalizePath")
+        ;
+
+    class_<FileSystemVfs, shared_ptr<FileSystemVfs>,
+            bases<Vfs>, boost::noncopyable>("FileSystemVfs")
+        ;
+
+    class_<MemoryVfs, shared_ptr<MemoryVfs>,
+            bases<Vfs>, boost::noncopyable>("MemoryVfs",
+                init<optional<shared_ptr<Vfs> > >())
+        .def("add", &MemoryVfs_add)
+        .def("remove", &MemoryVfs::remove)
+        .def("clear", &MemoryVfs::clear)
+        .def("size", &MemoryVfs::size)
+        .def("fileNames", &MemoryVfs_fileNames)
+        .def("fallback", &MemoryVfs::fallback)
+        .def("setFallback", &MemoryVfs::setFallback)
+        ;
+
+    class_<ArchiveVfs, shared_ptr<ArchiveVfs>,
+            bases<MemoryVfs>, boost::noncopyable>("ArchiveVfs",
+                init<optional<shared_ptr<Vfs> > >())
+        .def("load", &ArchiveVfs_load, ArchiveVfs_load_overloads())
+        .def("loadData", &ArchiveVfs_loadData,
+                    ArchiveVfs_loadData_overloads())
+        ;
+}
+